@@ -0,0 +1,315 @@
+// *************************************
+// Modula Replication Engine
+// Benchmarks
+// 'allocation_benchmark.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "thread_pool.hh"
+
+#include <new>
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+#include <format>
+#include <future>
+#include <thread>
+#include <iostream>
+#include <optional>
+#include <functional>
+#include <condition_variable>
+
+//
+// Number of global operator new calls across all threads.
+//
+static std::atomic<uint64_t> s_number_allocations(0);
+
+void*
+operator new(
+    std::size_t p_size)
+{
+    s_number_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* allocation = std::malloc(p_size != 0 ? p_size : 1))
+    {
+        return allocation;
+    }
+
+    throw std::bad_alloc();
+}
+
+void
+operator delete(
+    void* p_allocation) noexcept
+{
+    std::free(p_allocation);
+}
+
+void
+operator delete(
+    void* p_allocation,
+    std::size_t) noexcept
+{
+    std::free(p_allocation);
+}
+
+namespace modula
+{
+
+//
+// Thread pool with a single task queue behind a mutex and a condition variable, packaging tasks as the thread
+// pool did before moving onto small tasks: a shared packaged task wrapped into a heap-allocated std::function.
+// Kept as the baseline.
+//
+class reference_thread_pool
+{
+
+public:
+
+    //
+    // Constructor. Launches all the worker threads.
+    //
+    explicit
+    reference_thread_pool(
+        const uint16 p_number_threads)
+        : m_stop(false)
+    {
+        for (uint16 thread_index = 0; thread_index < p_number_threads; ++thread_index)
+        {
+            m_worker_threads.emplace_back(&reference_thread_pool::task_handler, this);
+        }
+    }
+
+    //
+    // Destructor. Finishes the pending tasks and joins all the worker threads.
+    //
+    ~reference_thread_pool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_stop = true;
+        }
+
+        m_condition.notify_all();
+
+        for (std::thread& worker_thread : m_worker_threads)
+        {
+            worker_thread.join();
+        }
+    }
+
+    //
+    // Enqueues a task into the queue, packaged the same way the former thread pool did.
+    //
+    template<typename Function>
+    std::optional<std::future<typename std::result_of<Function()>::type>>
+    enqueue_task(
+        Function&& p_function)
+    {
+        using return_type = typename std::result_of<Function()>::type;
+
+        std::shared_ptr<std::packaged_task<return_type()>> packaged_task = std::make_shared<std::packaged_task<return_type()>>(
+            std::bind(std::forward<Function>(p_function)));
+
+        std::future<return_type> packaged_task_result = packaged_task->get_future();
+
+        std::unique_ptr<task> packaged_task_wrapper = std::make_unique<task>(
+            [packaged_task]()
+            {
+                (*packaged_task)();
+            });
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            if (m_stop)
+            {
+                return std::nullopt;
+            }
+
+            m_tasks.push(std::move(packaged_task_wrapper));
+        }
+
+        m_condition.notify_one();
+
+        return std::make_optional<std::future<return_type>>(std::move(packaged_task_result));
+    }
+
+private:
+
+    //
+    // Type-erased task to be executed by the worker threads.
+    //
+    using task = std::function<void()>;
+
+    //
+    // Worker thread loop.
+    //
+    void
+    task_handler()
+    {
+        forever
+        {
+            std::unique_ptr<task> next_task;
+
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+
+                m_condition.wait(lock,
+                    [this]
+                    {
+                        return this->m_stop ||
+                            !this->m_tasks.empty();
+                    });
+
+                if (m_stop &&
+                    m_tasks.empty())
+                {
+                    return;
+                }
+
+                next_task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+
+            (*next_task)();
+        }
+    }
+
+    //
+    // Worker threads.
+    //
+    std::vector<std::thread> m_worker_threads;
+
+    //
+    // Tasks waiting to be executed.
+    //
+    std::queue<std::unique_ptr<task>> m_tasks;
+
+    //
+    // Lock for synchronizing access to the task queue.
+    //
+    std::mutex m_lock;
+
+    //
+    // Condition variable for awakening worker threads.
+    //
+    std::condition_variable m_condition;
+
+    //
+    // Flag for stopping the worker threads.
+    //
+    bool m_stop;
+
+};
+
+//
+// Number of worker threads of each thread pool.
+//
+static constexpr uint16 c_number_threads = 4u;
+
+//
+// Number of tasks per measurement.
+//
+static constexpr uint64 c_number_tasks = 200'000u;
+
+//
+// Number of rounds per measurement. The first round warms up the task queues and the task node caches.
+//
+static constexpr uint32 c_number_rounds = 2u;
+
+//
+// Measures the heap allocations per task of an enqueue function, enqueuing from a thread outside the pool.
+//
+template<typename Enqueue>
+static
+double
+measure_allocations_per_task(
+    Enqueue&& p_enqueue)
+{
+    double allocations_per_task = 0;
+
+    for (uint32 round = 0; round < c_number_rounds; ++round)
+    {
+        std::atomic<uint64> number_completed_tasks(0);
+        const uint64 number_allocations = s_number_allocations.load(std::memory_order_relaxed);
+
+        for (uint64 task_index = 0; task_index < c_number_tasks; ++task_index)
+        {
+            p_enqueue([&number_completed_tasks]()
+            {
+                number_completed_tasks.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        while (number_completed_tasks.load(std::memory_order_acquire) < c_number_tasks)
+        {
+            std::this_thread::yield();
+        }
+
+        allocations_per_task = static_cast<double>(s_number_allocations.load(std::memory_order_relaxed) - number_allocations) / c_number_tasks;
+    }
+
+    return allocations_per_task;
+}
+
+} // namespace modula.
+
+int main()
+{
+    using namespace modula;
+
+    status_code status = status::success;
+
+    double reference_allocations = 0;
+
+    {
+        reference_thread_pool mutex_thread_pool(c_number_threads);
+
+        reference_allocations = measure_allocations_per_task([&mutex_thread_pool](auto&& p_function)
+        {
+            mutex_thread_pool.enqueue_task(std::forward<decltype(p_function)>(p_function));
+        });
+    }
+
+    //
+    // The queue is unbounded so that no submission blocks while being measured.
+    //
+    thread_pool_options options(c_number_threads);
+    options.m_max_queued_tasks = 0;
+
+    thread_pool pool(
+        &status,
+        options);
+
+    if (status::failed(status))
+    {
+        std::cerr << std::format("Thread pool startup failed. Status={:#X}.\n", status);
+
+        return EXIT_FAILURE;
+    }
+
+    const double enqueue_task_allocations = measure_allocations_per_task([&pool](auto&& p_function)
+    {
+        pool.enqueue_task(std::forward<decltype(p_function)>(p_function));
+    });
+
+    const double post_allocations = measure_allocations_per_task([&pool](auto&& p_function)
+    {
+        pool.post(std::forward<decltype(p_function)>(p_function));
+    });
+
+    std::cout << std::format("Threads={}, Tasks={}.\n",
+        c_number_threads,
+        c_number_tasks);
+
+    std::cout << std::format("{:<28} {:>16}\n", "Submission", "Allocations/task");
+    std::cout << std::format("{:<28} {:>16.3f}\n", "packaged_task+std::function", reference_allocations);
+    std::cout << std::format("{:<28} {:>16.3f}\n", "enqueue_task", enqueue_task_allocations);
+    std::cout << std::format("{:<28} {:>16.3f}\n", "post", post_allocations);
+
+    return EXIT_SUCCESS;
+}
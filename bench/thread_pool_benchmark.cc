@@ -0,0 +1,390 @@
+// *************************************
+// Modula Replication Engine
+// Benchmarks
+// 'thread_pool_benchmark.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "thread_pool.hh"
+
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+namespace modula
+{
+
+//
+// Thread pool with a fixed number of worker threads sharing a single task queue behind a mutex and a condition
+// variable, as the replication engine used before moving onto work-stealing deques. Kept as the baseline.
+//
+class reference_thread_pool
+{
+
+public:
+
+    //
+    // Constructor. Launches all the worker threads.
+    //
+    explicit
+    reference_thread_pool(
+        const uint16 p_number_threads)
+        : m_stop(false)
+    {
+        for (uint16 thread_index = 0; thread_index < p_number_threads; ++thread_index)
+        {
+            m_worker_threads.emplace_back(&reference_thread_pool::task_handler, this);
+        }
+    }
+
+    //
+    // Destructor. Finishes the pending tasks and joins all the worker threads.
+    //
+    ~reference_thread_pool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_stop = true;
+        }
+
+        m_condition.notify_all();
+
+        for (std::thread& worker_thread : m_worker_threads)
+        {
+            worker_thread.join();
+        }
+    }
+
+    //
+    // Enqueues a task into the queue, packaged the same way the original thread pool did.
+    //
+    template<typename Function>
+    std::optional<std::future<typename std::result_of<Function()>::type>>
+    enqueue_task(
+        Function&& p_function)
+    {
+        using return_type = typename std::result_of<Function()>::type;
+
+        std::shared_ptr<std::packaged_task<return_type()>> packaged_task = std::make_shared<std::packaged_task<return_type()>>(
+            std::forward<Function>(p_function));
+
+        std::future<return_type> packaged_task_result = packaged_task->get_future();
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            if (m_stop)
+            {
+                return std::nullopt;
+            }
+
+            m_tasks.emplace(
+                [packaged_task]()
+                {
+                    (*packaged_task)();
+                });
+        }
+
+        m_condition.notify_one();
+
+        return std::make_optional<std::future<return_type>>(std::move(packaged_task_result));
+    }
+
+private:
+
+    //
+    // Worker thread loop.
+    //
+    void
+    task_handler()
+    {
+        forever
+        {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+
+                m_condition.wait(lock,
+                    [this]
+                    {
+                        return this->m_stop ||
+                            !this->m_tasks.empty();
+                    });
+
+                if (m_stop &&
+                    m_tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+
+            task();
+        }
+    }
+
+    //
+    // Worker threads.
+    //
+    std::vector<std::thread> m_worker_threads;
+
+    //
+    // Tasks waiting to be executed.
+    //
+    std::queue<std::function<void()>> m_tasks;
+
+    //
+    // Lock for synchronizing access to the task queue.
+    //
+    std::mutex m_lock;
+
+    //
+    // Condition variable for awakening worker threads.
+    //
+    std::condition_variable m_condition;
+
+    //
+    // Flag for stopping the worker threads.
+    //
+    bool m_stop;
+
+};
+
+//
+// Number of tasks per throughput measurement.
+//
+static constexpr uint64 c_number_throughput_tasks = 1'000'000u;
+
+//
+// Number of tasks enqueued by each task running on the pool for the nested throughput measurement.
+//
+static constexpr uint64 c_number_nested_tasks_per_parent = 1'000u;
+
+//
+// Number of wakeup latency samples.
+//
+static constexpr uint64 c_number_latency_samples = 2'000u;
+
+//
+// Idle time before each wakeup latency sample, long enough for the worker threads to park.
+//
+static constexpr std::chrono::microseconds c_latency_sample_idle_time(200);
+
+//
+// Number of rounds per measurement; the best round is reported.
+//
+static constexpr uint32 c_number_rounds = 3u;
+
+//
+// Returns the current steady clock time in nanoseconds.
+//
+static
+int64
+get_current_time_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//
+// Waits until the provided number of tasks have completed.
+//
+static
+void
+wait_for_completed_tasks(
+    const std::atomic<uint64>& p_number_completed_tasks,
+    const uint64 p_number_tasks)
+{
+    while (p_number_completed_tasks.load(std::memory_order_acquire) < p_number_tasks)
+    {
+        std::this_thread::yield();
+    }
+}
+
+//
+// Measures the throughput, in tasks per second, of empty tasks enqueued from a thread outside the pool.
+//
+template<typename ThreadPool>
+static
+double
+measure_external_throughput(
+    ThreadPool& p_thread_pool)
+{
+    std::atomic<uint64> number_completed_tasks(0);
+    const int64 start_time_ns = get_current_time_ns();
+
+    for (uint64 task_index = 0; task_index < c_number_throughput_tasks; ++task_index)
+    {
+        p_thread_pool.enqueue_task([&number_completed_tasks]()
+        {
+            number_completed_tasks.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    wait_for_completed_tasks(number_completed_tasks, c_number_throughput_tasks);
+
+    return c_number_throughput_tasks * 1e9 / (get_current_time_ns() - start_time_ns);
+}
+
+//
+// Measures the throughput, in tasks per second, of empty tasks enqueued by tasks already running on the pool,
+// as the fan-out pipelines and the parallel copies do.
+//
+template<typename ThreadPool>
+static
+double
+measure_nested_throughput(
+    ThreadPool& p_thread_pool)
+{
+    const uint64 number_parent_tasks = c_number_throughput_tasks / c_number_nested_tasks_per_parent;
+    std::atomic<uint64> number_completed_tasks(0);
+    const int64 start_time_ns = get_current_time_ns();
+
+    for (uint64 parent_task_index = 0; parent_task_index < number_parent_tasks; ++parent_task_index)
+    {
+        p_thread_pool.enqueue_task([&p_thread_pool, &number_completed_tasks]()
+        {
+            for (uint64 task_index = 0; task_index < c_number_nested_tasks_per_parent; ++task_index)
+            {
+                p_thread_pool.enqueue_task([&number_completed_tasks]()
+                {
+                    number_completed_tasks.fetch_add(1, std::memory_order_release);
+                });
+            }
+        });
+    }
+
+    wait_for_completed_tasks(number_completed_tasks, number_parent_tasks * c_number_nested_tasks_per_parent);
+
+    return number_parent_tasks * c_number_nested_tasks_per_parent * 1e9 / (get_current_time_ns() - start_time_ns);
+}
+
+//
+// Measures the latency, in nanoseconds, from enqueuing a task into an idle pool until a worker thread starts running it.
+// Returns the sorted samples.
+//
+template<typename ThreadPool>
+static
+std::vector<int64>
+measure_wakeup_latency(
+    ThreadPool& p_thread_pool)
+{
+    std::vector<int64> latencies_ns;
+    latencies_ns.reserve(c_number_latency_samples);
+
+    for (uint64 sample_index = 0; sample_index < c_number_latency_samples; ++sample_index)
+    {
+        std::this_thread::sleep_for(c_latency_sample_idle_time);
+
+        std::atomic<int64> task_start_time_ns(0);
+        const int64 enqueue_time_ns = get_current_time_ns();
+
+        p_thread_pool.enqueue_task([&task_start_time_ns]()
+        {
+            task_start_time_ns.store(get_current_time_ns(), std::memory_order_release);
+        });
+
+        while (task_start_time_ns.load(std::memory_order_acquire) == 0)
+        {
+            std::this_thread::yield();
+        }
+
+        latencies_ns.push_back(task_start_time_ns.load(std::memory_order_relaxed) - enqueue_time_ns);
+    }
+
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+
+    return latencies_ns;
+}
+
+//
+// Runs all the measurements on a thread pool and reports them.
+//
+template<typename ThreadPool>
+static
+void
+run_benchmark(
+    const std::string& p_name,
+    ThreadPool& p_thread_pool)
+{
+    double external_throughput = 0;
+    double nested_throughput = 0;
+
+    for (uint32 round = 0; round < c_number_rounds; ++round)
+    {
+        external_throughput = std::max(external_throughput, measure_external_throughput(p_thread_pool));
+        nested_throughput = std::max(nested_throughput, measure_nested_throughput(p_thread_pool));
+    }
+
+    const std::vector<int64> latencies_ns = measure_wakeup_latency(p_thread_pool);
+
+    std::cout << std::format("{:<12} {:>16.0f} {:>16.0f} {:>14} {:>14}\n",
+        p_name,
+        external_throughput,
+        nested_throughput,
+        latencies_ns[latencies_ns.size() / 2] / 1000,
+        latencies_ns[latencies_ns.size() * 99 / 100] / 1000);
+}
+
+} // namespace modula.
+
+int main()
+{
+    using namespace modula;
+
+    const uint16 number_threads = static_cast<uint16>(std::clamp(std::thread::hardware_concurrency(), 2u, 16u));
+
+    std::cout << std::format("Threads={}, ThroughputTasks={}, LatencySamples={}.\n",
+        number_threads,
+        c_number_throughput_tasks,
+        c_number_latency_samples);
+
+    std::cout << std::format("{:<12} {:>16} {:>16} {:>14} {:>14}\n",
+        "Pool",
+        "External task/s",
+        "Nested task/s",
+        "Wakeup p50 us",
+        "Wakeup p99 us");
+
+    {
+        reference_thread_pool mutex_thread_pool(number_threads);
+
+        run_benchmark("mutex+cv", mutex_thread_pool);
+    }
+
+    {
+        status_code status = status::success;
+
+        //
+        // All worker threads are launched upfront and the queue is unbounded, as in the reference thread pool.
+        //
+        thread_pool_options options(number_threads);
+        options.m_min_number_threads = number_threads;
+        options.m_max_queued_tasks = 0;
+
+        thread_pool work_stealing_thread_pool(
+            &status,
+            options);
+
+        if (status::failed(status))
+        {
+            std::cerr << std::format("Thread pool startup failed. Status={:#X}.\n", status);
+
+            return EXIT_FAILURE;
+        }
+
+        run_benchmark("work-stealing", work_stealing_thread_pool);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'async_mutex.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "async_mutex.hh"
+
+namespace modula
+{
+
+async_mutex_lock::async_mutex_lock(
+    async_mutex* p_async_mutex)
+    : m_async_mutex(p_async_mutex)
+{}
+
+async_mutex_lock::async_mutex_lock(
+    async_mutex_lock&& p_async_mutex_lock)
+    : m_async_mutex(p_async_mutex_lock.m_async_mutex)
+{
+    p_async_mutex_lock.m_async_mutex = nullptr;
+}
+
+async_mutex_lock::~async_mutex_lock()
+{
+    if (m_async_mutex != nullptr)
+    {
+        m_async_mutex->unlock();
+    }
+}
+
+async_mutex_turn::async_mutex_turn()
+    : m_async_mutex(nullptr),
+      m_turn(0)
+{}
+
+async_mutex_turn::async_mutex_turn(
+    async_mutex* p_async_mutex,
+    const uint64 p_turn)
+    : m_async_mutex(p_async_mutex),
+      m_turn(p_turn)
+{}
+
+async_mutex_turn::async_mutex_turn(
+    async_mutex_turn&& p_async_mutex_turn)
+    : m_async_mutex(p_async_mutex_turn.m_async_mutex),
+      m_turn(p_async_mutex_turn.m_turn)
+{
+    p_async_mutex_turn.m_async_mutex = nullptr;
+}
+
+async_mutex_turn::~async_mutex_turn()
+{
+    if (m_async_mutex != nullptr)
+    {
+        m_async_mutex->release_turn(m_turn);
+    }
+}
+
+async_mutex_turn::operator bool() const
+{
+    return m_async_mutex != nullptr;
+}
+
+async_mutex::lock_awaitable::lock_awaitable(
+    async_mutex* p_async_mutex,
+    const uint64 p_turn)
+    : m_async_mutex(p_async_mutex),
+      m_turn(p_turn)
+{}
+
+bool
+async_mutex::lock_awaitable::await_ready() const
+{
+    std::scoped_lock<std::mutex> lock(m_async_mutex->m_lock);
+
+    return m_async_mutex->m_current_turn == m_turn;
+}
+
+bool
+async_mutex::lock_awaitable::await_suspend(
+    std::coroutine_handle<> p_coroutine)
+{
+    std::scoped_lock<std::mutex> lock(m_async_mutex->m_lock);
+
+    //
+    // The turn may have been reached since it was checked; take the async mutex without suspending then.
+    //
+    if (m_async_mutex->m_current_turn == m_turn)
+    {
+        return false;
+    }
+
+    m_async_mutex->m_waiting_coroutines.emplace(m_turn, p_coroutine);
+
+    return true;
+}
+
+async_mutex_lock
+async_mutex::lock_awaitable::await_resume() const
+{
+    return async_mutex_lock(m_async_mutex);
+}
+
+async_mutex::async_mutex()
+    : m_next_turn(0),
+      m_current_turn(0)
+{}
+
+async_mutex::lock_awaitable
+async_mutex::scoped_lock()
+{
+    std::scoped_lock<std::mutex> lock(m_lock);
+
+    return lock_awaitable(this, m_next_turn++);
+}
+
+async_mutex::lock_awaitable
+async_mutex::scoped_lock(
+    async_mutex_turn&& p_async_mutex_turn)
+{
+    if (!p_async_mutex_turn)
+    {
+        return scoped_lock();
+    }
+
+    //
+    // The turn is consumed by the lock; the async mutex is released through the scoped ownership from then on.
+    //
+    p_async_mutex_turn.m_async_mutex = nullptr;
+
+    return lock_awaitable(this, p_async_mutex_turn.m_turn);
+}
+
+async_mutex_turn
+async_mutex::reserve_turn()
+{
+    std::scoped_lock<std::mutex> lock(m_lock);
+
+    return async_mutex_turn(this, m_next_turn++);
+}
+
+void
+async_mutex::unlock()
+{
+    std::coroutine_handle<> next_coroutine;
+
+    {
+        std::scoped_lock<std::mutex> lock(m_lock);
+
+        next_coroutine = advance_turn();
+    }
+
+    //
+    // Ownership is handed over directly to the coroutine waiting on the next turn.
+    //
+    if (next_coroutine)
+    {
+        next_coroutine.resume();
+    }
+}
+
+void
+async_mutex::release_turn(
+    const uint64 p_turn)
+{
+    std::coroutine_handle<> next_coroutine;
+
+    {
+        std::scoped_lock<std::mutex> lock(m_lock);
+
+        if (p_turn != m_current_turn)
+        {
+            //
+            // The turn is skipped once the turns ahead of it are done.
+            //
+            m_released_turns.insert(p_turn);
+
+            return;
+        }
+
+        next_coroutine = advance_turn();
+    }
+
+    if (next_coroutine)
+    {
+        next_coroutine.resume();
+    }
+}
+
+std::coroutine_handle<>
+async_mutex::advance_turn()
+{
+    ++m_current_turn;
+
+    while (m_released_turns.erase(m_current_turn) != 0)
+    {
+        ++m_current_turn;
+    }
+
+    auto waiting_coroutine = m_waiting_coroutines.find(m_current_turn);
+
+    if (waiting_coroutine == m_waiting_coroutines.end())
+    {
+        //
+        // The owner of the next turn has not awaited the async mutex yet, and takes it right away once it does.
+        //
+        return nullptr;
+    }
+
+    const std::coroutine_handle<> next_coroutine = waiting_coroutine->second;
+    m_waiting_coroutines.erase(waiting_coroutine);
+
+    return next_coroutine;
+}
+
+} // namespace modula.
@@ -0,0 +1,254 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'async_mutex.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef ASYNC_MUTEX_
+#define ASYNC_MUTEX_
+
+#include "utilities.hh"
+
+#include <set>
+#include <map>
+#include <mutex>
+#include <coroutine>
+
+namespace modula
+{
+
+class async_mutex;
+
+//
+// Scoped ownership of an async mutex, unlocking it on destruction.
+//
+class async_mutex_lock
+{
+
+public:
+
+    //
+    // Constructor. Takes ownership of a locked async mutex.
+    //
+    explicit
+    async_mutex_lock(
+        async_mutex* p_async_mutex);
+
+    //
+    // Move constructor. Transfers the async mutex ownership.
+    //
+    async_mutex_lock(
+        async_mutex_lock&& p_async_mutex_lock);
+
+    async_mutex_lock(
+        const async_mutex_lock&) = delete;
+
+    async_mutex_lock&
+    operator=(
+        const async_mutex_lock&) = delete;
+
+    //
+    // Destructor. Unlocks the async mutex.
+    //
+    ~async_mutex_lock();
+
+private:
+
+    //
+    // Owned async mutex.
+    //
+    async_mutex* m_async_mutex;
+
+};
+
+//
+// Turn reserved on an async mutex, locking it in the order the turn was reserved rather than in the order the lock
+// is awaited. A turn which is not used for locking is released on destruction, so the turns behind it are not held back.
+//
+class async_mutex_turn
+{
+
+public:
+
+    //
+    // Constructor. Holds no turn.
+    //
+    async_mutex_turn();
+
+    //
+    // Constructor. Takes ownership of a reserved turn.
+    //
+    async_mutex_turn(
+        async_mutex* p_async_mutex,
+        const uint64 p_turn);
+
+    //
+    // Move constructor. Transfers the turn ownership.
+    //
+    async_mutex_turn(
+        async_mutex_turn&& p_async_mutex_turn);
+
+    async_mutex_turn(
+        const async_mutex_turn&) = delete;
+
+    async_mutex_turn&
+    operator=(
+        const async_mutex_turn&) = delete;
+
+    //
+    // Destructor. Releases the turn, if still held.
+    //
+    ~async_mutex_turn();
+
+    //
+    // Returns whether a turn is held.
+    //
+    explicit
+    operator bool() const;
+
+private:
+
+    friend class async_mutex;
+
+    //
+    // Async mutex the turn was reserved on.
+    //
+    async_mutex* m_async_mutex;
+
+    //
+    // Position of the turn within the async mutex.
+    //
+    uint64 m_turn;
+
+};
+
+//
+// Mutex class for coroutines. Coroutines waiting for the async mutex are suspended instead of blocking their thread,
+// and are handed the async mutex in the order of their turns. Turns are taken when locking, in FIFO order, unless
+// reserved earlier. Since the owner of the async mutex may resume on a different thread than the one which locked it,
+// it can be held across suspension points, unlike a regular mutex.
+//
+class async_mutex
+{
+
+public:
+
+    //
+    // Awaitable locking the async mutex, suspending the awaiting coroutine while it is owned by another one.
+    //
+    class lock_awaitable
+    {
+
+    public:
+
+        //
+        // Constructor.
+        //
+        lock_awaitable(
+            async_mutex* p_async_mutex,
+            const uint64 p_turn);
+
+        bool
+        await_ready() const;
+
+        bool
+        await_suspend(
+            std::coroutine_handle<> p_coroutine);
+
+        async_mutex_lock
+        await_resume() const;
+
+    private:
+
+        //
+        // Async mutex to be locked.
+        //
+        async_mutex* m_async_mutex;
+
+        //
+        // Turn to lock the async mutex on.
+        //
+        uint64 m_turn;
+
+    };
+
+    //
+    // Constructor.
+    //
+    async_mutex();
+
+    //
+    // Returns an awaitable which resumes with the scoped ownership of the async mutex.
+    //
+    lock_awaitable
+    scoped_lock();
+
+    //
+    // Returns an awaitable which resumes with the scoped ownership of the async mutex on a reserved turn.
+    //
+    lock_awaitable
+    scoped_lock(
+        async_mutex_turn&& p_async_mutex_turn);
+
+    //
+    // Reserves the next turn of the async mutex.
+    //
+    async_mutex_turn
+    reserve_turn();
+
+private:
+
+    friend class async_mutex_lock;
+    friend class async_mutex_turn;
+
+    //
+    // Unlocks the async mutex. The coroutine waiting on the next turn, if any, takes it over and is resumed on the unlocking thread.
+    //
+    void
+    unlock();
+
+    //
+    // Releases a reserved turn without locking the async mutex on it.
+    //
+    void
+    release_turn(
+        const uint64 p_turn);
+
+    //
+    // Moves onto the next turn not released yet, and returns the coroutine waiting on it, if any.
+    // Must be called with the async mutex state lock held.
+    //
+    std::coroutine_handle<>
+    advance_turn();
+
+    //
+    // Lock guarding the async mutex state.
+    //
+    std::mutex m_lock;
+
+    //
+    // Next turn to be reserved.
+    //
+    uint64 m_next_turn;
+
+    //
+    // Turn currently owning the async mutex, or allowed to take it.
+    //
+    uint64 m_current_turn;
+
+    //
+    // Coroutines waiting for the async mutex, keyed by turn.
+    //
+    std::map<uint64, std::coroutine_handle<>> m_waiting_coroutines;
+
+    //
+    // Reserved turns released before being reached.
+    //
+    std::set<uint64> m_released_turns;
+
+};
+
+} // namespace modula.
+
+#endif
@@ -0,0 +1,432 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'async_task.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef ASYNC_TASK_
+#define ASYNC_TASK_
+
+#include "utilities.hh"
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <coroutine>
+#include <exception>
+
+namespace modula
+{
+
+template<typename T>
+class async_task;
+
+//
+// Promise state shared by all async tasks. Async tasks are lazily started: they only begin running once awaited,
+// and on completion they transfer control straight back to the awaiting coroutine, without any thread hop.
+//
+class async_task_promise_base
+{
+
+public:
+
+    //
+    // Awaitable resuming the awaiting coroutine once the async task completes.
+    //
+    struct final_awaitable
+    {
+
+        bool
+        await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template<typename Promise>
+        std::coroutine_handle<>
+        await_suspend(
+            std::coroutine_handle<Promise> p_coroutine) noexcept
+        {
+            return p_coroutine.promise().m_continuation;
+        }
+
+        void
+        await_resume() const noexcept
+        {}
+
+    };
+
+    std::suspend_always
+    initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    final_awaitable
+    final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void
+    unhandled_exception() noexcept
+    {
+        m_exception = std::current_exception();
+    }
+
+    //
+    // Coroutine awaiting the async task.
+    //
+    std::coroutine_handle<> m_continuation;
+
+    //
+    // Exception escaping the async task, rethrown to the awaiting coroutine.
+    //
+    std::exception_ptr m_exception;
+
+};
+
+//
+// Promise of an async task producing a value.
+//
+template<typename T>
+class async_task_promise : public async_task_promise_base
+{
+
+public:
+
+    async_task<T>
+    get_return_object() noexcept;
+
+    void
+    return_value(
+        T p_value)
+    {
+        m_value.emplace(std::move(p_value));
+    }
+
+    //
+    // Returns the produced value, or rethrows the exception escaping the async task.
+    //
+    T
+    take_value()
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+
+        return std::move(*m_value);
+    }
+
+private:
+
+    //
+    // Value produced by the async task.
+    //
+    std::optional<T> m_value;
+
+};
+
+//
+// Promise of an async task producing no value.
+//
+template<>
+class async_task_promise<void> : public async_task_promise_base
+{
+
+public:
+
+    async_task<void>
+    get_return_object() noexcept;
+
+    void
+    return_void() const noexcept
+    {}
+
+    //
+    // Rethrows the exception escaping the async task, if any.
+    //
+    void
+    take_value()
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+};
+
+//
+// Move-only coroutine type for asynchronous operations which suspend instead of blocking their thread. The
+// coroutine frame is owned by the async task and destroyed along with it, so an async task must be awaited
+// before it goes out of scope. Reference parameters of an async task coroutine must outlive its completion.
+//
+template<typename T = void>
+class async_task
+{
+
+public:
+
+    using promise_type = async_task_promise<T>;
+
+    //
+    // Constructor. Takes ownership of the coroutine frame.
+    //
+    explicit
+    async_task(
+        std::coroutine_handle<promise_type> p_coroutine) noexcept
+        : m_coroutine(p_coroutine)
+    {}
+
+    //
+    // Move constructor. Transfers the coroutine frame ownership.
+    //
+    async_task(
+        async_task&& p_async_task) noexcept
+        : m_coroutine(std::exchange(p_async_task.m_coroutine, nullptr))
+    {}
+
+    async_task(
+        const async_task&) = delete;
+
+    async_task&
+    operator=(
+        const async_task&) = delete;
+
+    //
+    // Destructor. Destroys the coroutine frame.
+    //
+    ~async_task()
+    {
+        if (m_coroutine)
+        {
+            m_coroutine.destroy();
+        }
+    }
+
+    //
+    // Awaitable starting the async task and resuming the awaiting coroutine with its result on completion.
+    //
+    struct awaitable
+    {
+
+        bool
+        await_ready() const noexcept
+        {
+            return false;
+        }
+
+        std::coroutine_handle<>
+        await_suspend(
+            std::coroutine_handle<> p_continuation) noexcept
+        {
+            m_coroutine.promise().m_continuation = p_continuation;
+
+            return m_coroutine;
+        }
+
+        T
+        await_resume()
+        {
+            return m_coroutine.promise().take_value();
+        }
+
+        std::coroutine_handle<promise_type> m_coroutine;
+
+    };
+
+    awaitable
+    operator co_await() && noexcept
+    {
+        return awaitable{m_coroutine};
+    }
+
+private:
+
+    //
+    // Coroutine frame of the async task.
+    //
+    std::coroutine_handle<promise_type> m_coroutine;
+
+};
+
+template<typename T>
+async_task<T>
+async_task_promise<T>::get_return_object() noexcept
+{
+    return async_task<T>(std::coroutine_handle<async_task_promise<T>>::from_promise(*this));
+}
+
+inline
+async_task<void>
+async_task_promise<void>::get_return_object() noexcept
+{
+    return async_task<void>(std::coroutine_handle<async_task_promise<void>>::from_promise(*this));
+}
+
+//
+// Eagerly started coroutine type whose frame destroys itself on completion. Used for
+// launching async tasks from non-coroutine code, which does not wait for them to complete.
+//
+class detached_task
+{
+
+public:
+
+    struct promise_type
+    {
+
+        detached_task
+        get_return_object() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never
+        initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never
+        final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void
+        return_void() const noexcept
+        {}
+
+        void
+        unhandled_exception() const noexcept
+        {
+            std::terminate();
+        }
+
+    };
+
+};
+
+//
+// Starts an async task without waiting for it. The async task runs on the calling thread until its first suspension.
+//
+template<typename T>
+detached_task
+start_detached(
+    async_task<T> p_async_task)
+{
+    co_await std::move(p_async_task);
+}
+
+//
+// Awaitable starting a set of async tasks concurrently and resuming the awaiting coroutine once all of them completed.
+// Pending async tasks are counted with an extra reference held while starting them, so the awaiting coroutine is resumed
+// exactly once: by the last async task to complete, or in place when all of them completed before being fully started.
+//
+template<typename T>
+class when_all_awaitable
+{
+
+public:
+
+    //
+    // Constructor. Results are stored in the same order as their async tasks.
+    //
+    when_all_awaitable(
+        std::vector<async_task<T>>& p_async_tasks,
+        std::vector<T>& p_results)
+        : m_async_tasks(p_async_tasks),
+          m_results(p_results),
+          m_number_pending_async_tasks(p_async_tasks.size() + 1)
+    {}
+
+    bool
+    await_ready() const noexcept
+    {
+        return m_async_tasks.empty();
+    }
+
+    bool
+    await_suspend(
+        std::coroutine_handle<> p_continuation)
+    {
+        m_continuation = p_continuation;
+
+        for (uint64 async_task_index = 0; async_task_index < m_async_tasks.size(); ++async_task_index)
+        {
+            run_async_task(
+                std::move(m_async_tasks[async_task_index]),
+                &m_results[async_task_index]);
+        }
+
+        return m_number_pending_async_tasks.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void
+    await_resume() const noexcept
+    {}
+
+private:
+
+    //
+    // Runs an async task to completion and resumes the awaiting coroutine if it was the last one pending.
+    //
+    detached_task
+    run_async_task(
+        async_task<T> p_async_task,
+        T* p_result)
+    {
+        *p_result = co_await std::move(p_async_task);
+
+        if (m_number_pending_async_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            m_continuation.resume();
+        }
+    }
+
+    //
+    // Async tasks to be awaited.
+    //
+    std::vector<async_task<T>>& m_async_tasks;
+
+    //
+    // Results of the async tasks.
+    //
+    std::vector<T>& m_results;
+
+    //
+    // Number of async tasks yet to complete, plus one while they are being started.
+    //
+    std::atomic<uint64> m_number_pending_async_tasks;
+
+    //
+    // Coroutine awaiting all async tasks.
+    //
+    std::coroutine_handle<> m_continuation;
+
+};
+
+//
+// Awaits a set of async tasks running concurrently and returns their results in order. The awaiting coroutine
+// resumes on the thread completing the last async task, without any thread being blocked in between.
+//
+template<typename T>
+async_task<std::vector<T>>
+when_all(
+    std::vector<async_task<T>> p_async_tasks)
+{
+    std::vector<T> results(p_async_tasks.size());
+
+    co_await when_all_awaitable<T>(p_async_tasks, results);
+
+    co_return results;
+}
+
+} // namespace modula.
+
+#endif
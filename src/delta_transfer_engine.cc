@@ -0,0 +1,443 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'delta_transfer_engine.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "delta_transfer_engine.hh"
+
+#include <cmath>
+#include <bit>
+#include <cstring>
+#include <unistd.h>
+#include <optional>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unordered_map>
+
+namespace modula
+{
+
+status_code
+delta_transfer_engine::compute_delta_instructions(
+    const file_descriptor p_source_file_descriptor,
+    const file_descriptor p_basis_file_descriptor,
+    const uint64 p_basis_file_size,
+    std::vector<delta_instruction>* p_delta_instructions)
+{
+    const uint32 block_size = compute_block_size(p_basis_file_size);
+    const uint32 number_blocks = static_cast<uint32>(p_basis_file_size / block_size);
+
+    if (number_blocks == 0)
+    {
+        //
+        // The basis file is smaller than a single block; the whole source file is literal data.
+        //
+        struct stat source_stat;
+
+        if (utilities::system_call_failed(fstat(p_source_file_descriptor, &source_stat)))
+        {
+            return status::delta_transfer_failed;
+        }
+
+        if (source_stat.st_size > 0)
+        {
+            append_delta_instruction(p_delta_instructions, {0, 0, static_cast<uint64>(source_stat.st_size), true});
+        }
+
+        return status::success;
+    }
+
+    std::vector<byte> buffer(static_cast<uint64>(block_size) * c_source_window_number_blocks);
+
+    //
+    // Build the basis file signature. Weak checksums are indexed through collision
+    // chains laid out in flat arrays to keep the memory footprint per block small.
+    //
+    std::vector<uint32> weak_checksums(number_blocks);
+    std::vector<uint64> strong_checksums(number_blocks);
+    std::vector<uint32> next_blocks(number_blocks, c_no_block);
+    std::unordered_map<uint32, uint32> weak_checksums_heads;
+    weak_checksums_heads.reserve(number_blocks);
+
+    for (uint32 block_index = 0; block_index < number_blocks;)
+    {
+        const uint32 number_blocks_to_read = std::min(number_blocks - block_index, c_source_window_number_blocks);
+        const uint64 number_bytes_to_read = static_cast<uint64>(number_blocks_to_read) * block_size;
+        uint64 number_bytes_read = 0;
+
+        while (number_bytes_read < number_bytes_to_read)
+        {
+            const ssize_t read_result = pread(
+                p_basis_file_descriptor,
+                buffer.data() + number_bytes_read,
+                number_bytes_to_read - number_bytes_read,
+                static_cast<uint64>(block_index) * block_size + number_bytes_read);
+
+            if (read_result == -1 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (read_result <= 0)
+            {
+                return status::delta_transfer_failed;
+            }
+
+            number_bytes_read += read_result;
+        }
+
+        for (uint32 window_block_index = 0; window_block_index < number_blocks_to_read; ++window_block_index, ++block_index)
+        {
+            const byte* block = buffer.data() + static_cast<uint64>(window_block_index) * block_size;
+            uint32 sum = 0;
+            uint32 weighted_sum = 0;
+
+            weak_checksums[block_index] = compute_weak_checksum(block, block_size, &sum, &weighted_sum);
+            strong_checksums[block_index] = compute_strong_checksum(block, block_size);
+
+            auto [head, inserted] = weak_checksums_heads.try_emplace(weak_checksums[block_index], block_index);
+
+            if (!inserted)
+            {
+                next_blocks[block_index] = head->second;
+                head->second = block_index;
+            }
+        }
+    }
+
+    //
+    // Stream the source file through a sliding window. The window start is matched against the
+    // signature; on a miss, the weak checksum is rolled forward by a single byte and the skipped
+    // byte becomes literal data. Literal ranges are recorded by offset and read again when applied.
+    //
+    uint64 buffer_offset = 0;
+    uint64 buffer_length = 0;
+    uint64 position = 0;
+    uint64 literal_start = 0;
+    uint32 sum = 0;
+    uint32 weighted_sum = 0;
+    uint32 expected_block = 0;
+    bool weak_checksum_valid = false;
+    bool end_of_file = false;
+
+    forever
+    {
+        if (!end_of_file &&
+            position + block_size >= buffer_length)
+        {
+            //
+            // Keep at least one byte of lookahead past the window for rolling the checksum.
+            //
+            std::memmove(buffer.data(), buffer.data() + position, buffer_length - position);
+            buffer_offset += position;
+            buffer_length -= position;
+            position = 0;
+
+            while (buffer_length < buffer.size())
+            {
+                const ssize_t read_result = pread(
+                    p_source_file_descriptor,
+                    buffer.data() + buffer_length,
+                    buffer.size() - buffer_length,
+                    buffer_offset + buffer_length);
+
+                if (read_result == -1 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                if (read_result == -1)
+                {
+                    return status::delta_transfer_failed;
+                }
+
+                if (read_result == 0)
+                {
+                    end_of_file = true;
+
+                    break;
+                }
+
+                buffer_length += read_result;
+            }
+        }
+
+        if (position + block_size > buffer_length)
+        {
+            //
+            // Trailing data shorter than a block is always transferred as literal data.
+            //
+            break;
+        }
+
+        const byte* window = buffer.data() + position;
+
+        if (!weak_checksum_valid)
+        {
+            compute_weak_checksum(window, block_size, &sum, &weighted_sum);
+            weak_checksum_valid = true;
+        }
+
+        const uint32 weak_checksum = sum | (weighted_sum << 16);
+        uint32 matched_block = c_no_block;
+        std::optional<uint64> strong_checksum;
+
+        //
+        // The block following the last match is checked first as it is the most likely one.
+        //
+        if (expected_block < number_blocks &&
+            weak_checksums[expected_block] == weak_checksum)
+        {
+            strong_checksum = compute_strong_checksum(window, block_size);
+
+            if (strong_checksums[expected_block] == strong_checksum.value())
+            {
+                matched_block = expected_block;
+            }
+        }
+
+        if (matched_block == c_no_block)
+        {
+            auto head = weak_checksums_heads.find(weak_checksum);
+
+            for (uint32 candidate_block = head == weak_checksums_heads.end() ? c_no_block : head->second;
+                candidate_block != c_no_block;
+                candidate_block = next_blocks[candidate_block])
+            {
+                if (!strong_checksum.has_value())
+                {
+                    strong_checksum = compute_strong_checksum(window, block_size);
+                }
+
+                if (strong_checksums[candidate_block] == strong_checksum.value())
+                {
+                    matched_block = candidate_block;
+
+                    break;
+                }
+            }
+        }
+
+        if (matched_block != c_no_block)
+        {
+            const uint64 match_offset = buffer_offset + position;
+
+            if (match_offset > literal_start)
+            {
+                append_delta_instruction(p_delta_instructions, {literal_start, 0, match_offset - literal_start, true});
+            }
+
+            append_delta_instruction(p_delta_instructions, {match_offset, static_cast<uint64>(matched_block) * block_size, block_size, false});
+
+            position += block_size;
+            literal_start = match_offset + block_size;
+            expected_block = matched_block + 1;
+            weak_checksum_valid = false;
+
+            continue;
+        }
+
+        if (position + block_size >= buffer_length)
+        {
+            //
+            // No lookahead byte is left at the end of the file.
+            //
+            break;
+        }
+
+        //
+        // Roll the weak checksum forward by a single byte.
+        //
+        const uint32 outgoing_byte = window[0];
+        const uint32 incoming_byte = window[block_size];
+        sum = (sum - outgoing_byte + incoming_byte) & c_weak_checksum_mask;
+        weighted_sum = (weighted_sum - block_size * outgoing_byte + sum) & c_weak_checksum_mask;
+
+        ++position;
+    }
+
+    const uint64 source_file_size = buffer_offset + buffer_length;
+
+    if (source_file_size > literal_start)
+    {
+        append_delta_instruction(p_delta_instructions, {literal_start, 0, source_file_size - literal_start, true});
+    }
+
+    return status::success;
+}
+
+bool
+delta_transfer_engine::is_in_place_applicable(
+    const std::vector<delta_instruction>& p_delta_instructions)
+{
+    return std::all_of(p_delta_instructions.begin(), p_delta_instructions.end(),
+        [](const delta_instruction& p_delta_instruction)
+        {
+            return p_delta_instruction.m_literal ||
+                p_delta_instruction.m_basis_offset == p_delta_instruction.m_offset;
+        });
+}
+
+status_code
+delta_transfer_engine::apply_delta_instructions(
+    const file_descriptor p_source_file_descriptor,
+    const file_descriptor p_basis_file_descriptor,
+    const file_descriptor p_output_file_descriptor,
+    const std::vector<delta_instruction>& p_delta_instructions,
+    const bool p_in_place,
+    uint64* p_delta_bytes,
+    uint64* p_literal_bytes)
+{
+    status_code status = status::success;
+    uint64 output_file_size = 0;
+
+    for (const delta_instruction& delta_instruction : p_delta_instructions)
+    {
+        output_file_size = delta_instruction.m_offset + delta_instruction.m_length;
+
+        if (delta_instruction.m_literal)
+        {
+            status = utilities::copy_data_extents(
+                p_source_file_descriptor,
+                delta_instruction.m_offset,
+                p_output_file_descriptor,
+                delta_instruction.m_offset,
+                delta_instruction.m_length,
+                p_in_place,
+                p_literal_bytes);
+
+            if (status::failed(status))
+            {
+                return status::delta_transfer_failed;
+            }
+
+            continue;
+        }
+
+        if (!p_in_place)
+        {
+            uint64 number_bytes_copied = 0;
+
+            status = utilities::copy_data_extents(
+                p_basis_file_descriptor,
+                delta_instruction.m_basis_offset,
+                p_output_file_descriptor,
+                delta_instruction.m_offset,
+                delta_instruction.m_length,
+                false /* Fresh output file; holes are left as they are. */,
+                &number_bytes_copied);
+
+            if (status::failed(status))
+            {
+                return status::delta_transfer_failed;
+            }
+        }
+
+        *p_delta_bytes += delta_instruction.m_length;
+    }
+
+    if (utilities::system_call_failed(ftruncate(p_output_file_descriptor, output_file_size)))
+    {
+        return status::delta_transfer_failed;
+    }
+
+    return status;
+}
+
+uint32
+delta_transfer_engine::compute_block_size(
+    const uint64 p_basis_file_size)
+{
+    //
+    // Square-root sizing as rsync does, which balances the signature size against the match granularity.
+    //
+    const uint64 block_size = static_cast<uint64>(std::sqrt(static_cast<double_precision>(p_basis_file_size))) & ~static_cast<uint64>(c_minimum_block_size - 1);
+
+    return static_cast<uint32>(std::clamp<uint64>(block_size, c_minimum_block_size, c_maximum_block_size));
+}
+
+uint32
+delta_transfer_engine::compute_weak_checksum(
+    const byte* p_data,
+    const uint32 p_length,
+    uint32* p_sum,
+    uint32* p_weighted_sum)
+{
+    uint32 sum = 0;
+    uint32 weighted_sum = 0;
+
+    for (uint32 byte_index = 0; byte_index < p_length; ++byte_index)
+    {
+        sum += p_data[byte_index];
+        weighted_sum += sum;
+    }
+
+    *p_sum = sum & c_weak_checksum_mask;
+    *p_weighted_sum = weighted_sum & c_weak_checksum_mask;
+
+    return *p_sum | (*p_weighted_sum << 16);
+}
+
+uint64
+delta_transfer_engine::compute_strong_checksum(
+    const byte* p_data,
+    const uint32 p_length)
+{
+    constexpr uint64 prime_1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64 prime_2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64 prime_3 = 0x165667B19E3779F9ull;
+    constexpr uint64 prime_4 = 0x85EBCA77C2B2AE63ull;
+
+    uint64 hash = prime_3 ^ (static_cast<uint64>(p_length) * prime_1);
+    uint32 byte_index = 0;
+
+    for (; byte_index + sizeof(uint64) <= p_length; byte_index += sizeof(uint64))
+    {
+        uint64 word;
+        std::memcpy(&word, p_data + byte_index, sizeof(uint64));
+
+        hash ^= std::rotl(word * prime_2, 31) * prime_1;
+        hash = std::rotl(hash, 27) * prime_1 + prime_4;
+    }
+
+    for (; byte_index < p_length; ++byte_index)
+    {
+        hash ^= p_data[byte_index] * prime_3;
+        hash = std::rotl(hash, 11) * prime_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime_2;
+    hash ^= hash >> 29;
+    hash *= prime_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+void
+delta_transfer_engine::append_delta_instruction(
+    std::vector<delta_instruction>* p_delta_instructions,
+    const delta_instruction& p_delta_instruction)
+{
+    if (!p_delta_instructions->empty())
+    {
+        delta_instruction& last_delta_instruction = p_delta_instructions->back();
+
+        if (last_delta_instruction.m_literal == p_delta_instruction.m_literal &&
+            last_delta_instruction.m_offset + last_delta_instruction.m_length == p_delta_instruction.m_offset &&
+            (p_delta_instruction.m_literal ||
+            last_delta_instruction.m_basis_offset + last_delta_instruction.m_length == p_delta_instruction.m_basis_offset))
+        {
+            last_delta_instruction.m_length += p_delta_instruction.m_length;
+
+            return;
+        }
+    }
+
+    p_delta_instructions->push_back(p_delta_instruction);
+}
+
+} // namespace modula.
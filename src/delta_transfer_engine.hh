@@ -0,0 +1,166 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'delta_transfer_engine.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef DELTA_TRANSFER_ENGINE_
+#define DELTA_TRANSFER_ENGINE_
+
+#include "status.hh"
+#include "utilities.hh"
+
+#include <vector>
+
+namespace modula
+{
+
+//
+// Delta instruction for reconstructing a file out of a basis file and literal source data.
+//
+struct delta_instruction
+{
+
+    //
+    // Offset of the instruction in the reconstructed file, which is the same as in the source file.
+    //
+    uint64 m_offset;
+
+    //
+    // Offset in the basis file to copy from. Unused for literal instructions.
+    //
+    uint64 m_basis_offset;
+
+    //
+    // Number of bytes covered by the instruction.
+    //
+    uint64 m_length;
+
+    //
+    // Flag for determining whether the data must be taken from the source file.
+    //
+    bool m_literal;
+
+};
+
+//
+// Delta transfer engine static class for block-level replication of updated files.
+// Uses the rsync rolling checksum algorithm against the current target file as basis,
+// so that only the changed blocks of the source file need to be transferred.
+//
+class delta_transfer_engine
+{
+
+    //
+    // Static class.
+    //
+    delta_transfer_engine() = delete;
+
+public:
+
+    //
+    // Computes the delta instructions for reconstructing the source file out of the basis file.
+    //
+    static
+    status_code
+    compute_delta_instructions(
+        const file_descriptor p_source_file_descriptor,
+        const file_descriptor p_basis_file_descriptor,
+        const uint64 p_basis_file_size,
+        std::vector<delta_instruction>* p_delta_instructions);
+
+    //
+    // Determines whether the delta instructions can be applied directly over the basis file.
+    // This is the case when every matched block remains at its original offset, which is
+    // the common pattern for in-place updates such as database files and VM images.
+    //
+    static
+    bool
+    is_in_place_applicable(
+        const std::vector<delta_instruction>& p_delta_instructions);
+
+    //
+    // Applies the delta instructions into the output file. For in-place application the
+    // output file must be the basis file itself and only literal data is written.
+    //
+    static
+    status_code
+    apply_delta_instructions(
+        const file_descriptor p_source_file_descriptor,
+        const file_descriptor p_basis_file_descriptor,
+        const file_descriptor p_output_file_descriptor,
+        const std::vector<delta_instruction>& p_delta_instructions,
+        const bool p_in_place,
+        uint64* p_delta_bytes,
+        uint64* p_literal_bytes);
+
+private:
+
+    //
+    // Computes the block size used for the basis file signature.
+    //
+    static
+    uint32
+    compute_block_size(
+        const uint64 p_basis_file_size);
+
+    //
+    // Computes the weak rolling checksum of a block.
+    //
+    static
+    uint32
+    compute_weak_checksum(
+        const byte* p_data,
+        const uint32 p_length,
+        uint32* p_sum,
+        uint32* p_weighted_sum);
+
+    //
+    // Computes the strong checksum of a block for confirming weak checksum matches.
+    //
+    static
+    uint64
+    compute_strong_checksum(
+        const byte* p_data,
+        const uint32 p_length);
+
+    //
+    // Appends an instruction to the container, merging it with the last one when contiguous.
+    //
+    static
+    void
+    append_delta_instruction(
+        std::vector<delta_instruction>* p_delta_instructions,
+        const delta_instruction& p_delta_instruction);
+
+    //
+    // Minimum block size in bytes for the basis file signature.
+    //
+    static constexpr uint32 c_minimum_block_size = 4096u;
+
+    //
+    // Maximum block size in bytes for the basis file signature.
+    //
+    static constexpr uint32 c_maximum_block_size = 1024u * 1024u;
+
+    //
+    // Number of blocks held by the source streaming window.
+    //
+    static constexpr uint32 c_source_window_number_blocks = 32u;
+
+    //
+    // Modulus mask for the weak rolling checksum components.
+    //
+    static constexpr uint32 c_weak_checksum_mask = 0xFFFFu;
+
+    //
+    // Sentinel for the end of a weak checksum collision chain.
+    //
+    static constexpr uint32 c_no_block = 0xFFFFFFFFu;
+
+};
+
+} // namespace modula.
+
+#endif
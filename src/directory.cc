@@ -6,6 +6,11 @@
 // *************************************
 
 #include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
 
 #include "directory.hh"
 #include "utilities.hh"
@@ -27,12 +32,16 @@ directory::directory(
 
 directory::directory(
     const directory& p_directory) :
-    m_path(p_directory.m_path)
+    m_path(p_directory.m_path),
+    m_reflink_supported(p_directory.m_reflink_supported),
+    m_transport_profile(p_directory.m_transport_profile)
 {}
 
 directory::directory(
     const directory&& p_directory) :
-    m_path(std::move(p_directory.m_path))
+    m_path(std::move(p_directory.m_path)),
+    m_reflink_supported(p_directory.m_reflink_supported),
+    m_transport_profile(p_directory.m_transport_profile)
 {}
 
 const std::string&
@@ -75,4 +84,74 @@ directory::is_subdirectory_of(
     return canonical_comparing_directory_iterator == canonical_comparing_directory.end();
 }
 
+void
+directory::detect_reflink_support(
+    const std::string& p_source_directory_path)
+{
+    m_reflink_supported = false;
+
+    struct stat source_directory_stat;
+    struct stat target_directory_stat;
+
+    if (utilities::system_call_failed(stat(p_source_directory_path.c_str(), &source_directory_stat)) ||
+        utilities::system_call_failed(stat(m_path.c_str(), &target_directory_stat)) ||
+        source_directory_stat.st_dev != target_directory_stat.st_dev)
+    {
+        //
+        // Files can only be cloned within the same filesystem.
+        //
+        return;
+    }
+
+    //
+    // Probe with two temporary files inside this directory so that
+    // the watched source directory never observes probing events.
+    //
+    std::string probe_source_path = m_path + "/" + c_reflink_probe_file_name_template;
+    std::string probe_target_path = probe_source_path;
+
+    file_descriptor probe_source_file_descriptor = mkostemp(probe_source_path.data(), O_CLOEXEC);
+    file_descriptor probe_target_file_descriptor = mkostemp(probe_target_path.data(), O_CLOEXEC);
+
+    if (utilities::is_file_descriptor_valid(probe_source_file_descriptor) &&
+        utilities::is_file_descriptor_valid(probe_target_file_descriptor))
+    {
+        const std::string probe_data(c_reflink_probe_size, '\0');
+
+        m_reflink_supported = write(probe_source_file_descriptor, probe_data.data(), probe_data.size()) == static_cast<ssize_t>(probe_data.size()) &&
+            !utilities::system_call_failed(ioctl(probe_target_file_descriptor, FICLONE, probe_source_file_descriptor));
+    }
+
+    if (utilities::is_file_descriptor_valid(probe_source_file_descriptor))
+    {
+        close(probe_source_file_descriptor);
+        unlink(probe_source_path.c_str());
+    }
+
+    if (utilities::is_file_descriptor_valid(probe_target_file_descriptor))
+    {
+        close(probe_target_file_descriptor);
+        unlink(probe_target_path.c_str());
+    }
+}
+
+bool
+directory::is_reflink_supported() const
+{
+    return m_reflink_supported;
+}
+
+const transport_profile&
+directory::get_transport_profile() const
+{
+    return m_transport_profile;
+}
+
+void
+directory::set_transport_profile(
+    const transport_profile& p_transport_profile)
+{
+    m_transport_profile = p_transport_profile;
+}
+
 } // pathspace modula.
@@ -8,6 +8,8 @@
 #ifndef DIRECTORY_
 #define DIRECTORY_
 
+#include "transport_profile.hh"
+
 #include <string>
 
 namespace modula
@@ -58,12 +60,59 @@ public:
     is_subdirectory_of(
         const std::string& p_comparing_directory) const;
 
+    //
+    // Detects and caches whether files from the source directory can be reflinked into this directory.
+    // Requires both directories to be on the same filesystem and the filesystem to support cloning.
+    //
+    void
+    detect_reflink_support(
+        const std::string& p_source_directory_path);
+
+    //
+    // Returns whether files can be reflinked into the directory.
+    //
+    bool
+    is_reflink_supported() const;
+
+    //
+    // Returns the transport profile used for replicating into the directory.
+    //
+    const transport_profile&
+    get_transport_profile() const;
+
+    //
+    // Sets the transport profile used for replicating into the directory.
+    //
+    void
+    set_transport_profile(
+        const transport_profile& p_transport_profile);
+
 private:
 
     //
     // Path of the directory.
     //
     std::string m_path;
+
+    //
+    // Cached reflink support for files replicated into the directory.
+    //
+    bool m_reflink_supported = false;
+
+    //
+    // Transport profile for replicating into the directory.
+    //
+    transport_profile m_transport_profile;
+
+    //
+    // Name template for the temporary files used when probing reflink support.
+    //
+    static constexpr const character* c_reflink_probe_file_name_template = ".modula-reflink-probe-XXXXXX";
+
+    //
+    // Size in bytes of the data cloned when probing reflink support.
+    //
+    static constexpr uint32 c_reflink_probe_size = 4096u;
     
 };
 
@@ -0,0 +1,375 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'fan_out_pipeline.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "fan_out_pipeline.hh"
+
+#include <cerrno>
+#include <unistd.h>
+#include <algorithm>
+
+namespace modula
+{
+
+std::vector<std::unique_ptr<byte[]>> fan_out_pipeline::s_buffers_pool;
+
+std::mutex fan_out_pipeline::s_buffers_pool_lock;
+
+fan_out_pipeline::fan_out_pipeline(
+    const file_descriptor p_source_file_descriptor,
+    const uint64 p_number_bytes,
+    const std::vector<file_descriptor>& p_target_file_descriptors) :
+    m_source_file_descriptor(p_source_file_descriptor),
+    m_number_bytes(p_number_bytes),
+    m_target_file_descriptors(p_target_file_descriptors),
+    m_target_statuses(p_target_file_descriptors.size(), status::success),
+    m_target_bytes_transferred(p_target_file_descriptors.size(), 0),
+    m_slots(c_number_slots, slot{}),
+    m_number_filled_slots(0),
+    m_target_slot_sequences(p_target_file_descriptors.size(), 0),
+    m_writer_claims(std::make_shared<writer_claims>()),
+    m_source_exhausted(false)
+{
+    m_writer_claims->m_claimed_writers.assign(p_target_file_descriptors.size(), false);
+    m_writer_claims->m_number_running_writers = 0;
+}
+
+status_code
+fan_out_pipeline::execute(
+    thread_pool* p_thread_pool)
+{
+    status_code status = status::success;
+
+    for (slot& slot : m_slots)
+    {
+        slot.m_buffer = acquire_buffer();
+    }
+
+    //
+    // Every filled slot is drained by all the writers, whether they run on the thread pool or are taken over by the reader.
+    //
+    for (uint32 target_index = 0; target_index < m_target_file_descriptors.size(); ++target_index)
+    {
+        //
+        // A rejected writer is not an error; the reader takes it over.
+        //
+        p_thread_pool->post(
+            [this, writer_claims = m_writer_claims, target_index]()
+            {
+                this->run_scheduled_writer(writer_claims, target_index);
+            });
+    }
+
+    uint64 offset = 0;
+    uint64 data_end_offset = 0;
+
+    while (offset < m_number_bytes)
+    {
+        //
+        // Holes are never read nor written; the targets get their size once committed.
+        //
+        if (offset >= data_end_offset &&
+            !utilities::find_next_data_extent(m_source_file_descriptor, offset, m_number_bytes, &offset, &data_end_offset))
+        {
+            break;
+        }
+
+        slot& slot = m_slots[m_number_filled_slots % c_number_slots];
+
+        bool slot_pending = false;
+
+        {
+            std::scoped_lock<std::mutex> lock(m_lock);
+            slot_pending = slot.m_number_pending_writers != 0;
+        }
+
+        if (slot_pending)
+        {
+            //
+            // Writers still waiting for a worker thread would hold the slot for as long as the thread pool
+            // is busy, possibly with this very pipeline; the reader takes them over and drains them itself.
+            //
+            claim_unstarted_writers();
+
+            for (const uint32 target_index : m_reader_targets)
+            {
+                write_target(
+                    target_index,
+                    false /* Do not wait for slots. */);
+            }
+
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            //
+            // Wait for the running writers to consume the previous data held by the slot.
+            //
+            m_slot_released_condition.wait(lock, [&slot]()
+            {
+                return slot.m_number_pending_writers == 0;
+            });
+        }
+
+        const ssize_t bytes_read = pread(
+            m_source_file_descriptor,
+            slot.m_buffer,
+            std::min<uint64>(data_end_offset - offset, c_buffer_size),
+            offset);
+
+        if (bytes_read < 0 &&
+            errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes_read < 0)
+        {
+            status = status::native_copy_failed;
+
+            break;
+        }
+
+        if (bytes_read == 0)
+        {
+            //
+            // The source file was truncated while being replicated.
+            //
+            break;
+        }
+
+        {
+            std::scoped_lock<std::mutex> lock(m_lock);
+            slot.m_offset = offset;
+            slot.m_length = static_cast<uint32>(bytes_read);
+            slot.m_number_pending_writers = static_cast<uint32>(m_target_file_descriptors.size());
+            ++m_number_filled_slots;
+        }
+
+        m_slot_filled_condition.notify_all();
+        offset += bytes_read;
+    }
+
+    {
+        std::scoped_lock<std::mutex> lock(m_lock);
+        m_source_exhausted = true;
+    }
+
+    m_slot_filled_condition.notify_all();
+
+    //
+    // Writers which have not started yet are not waited for; the reader drains them instead.
+    //
+    claim_unstarted_writers();
+
+    for (const uint32 target_index : m_reader_targets)
+    {
+        write_target(
+            target_index,
+            false /* Do not wait for slots. */);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_writer_claims->m_lock);
+
+        m_writer_claims->m_writers_completed_condition.wait(lock, [this]()
+        {
+            return m_writer_claims->m_number_running_writers == 0;
+        });
+    }
+
+    for (slot& slot : m_slots)
+    {
+        release_buffer(slot.m_buffer);
+        slot.m_buffer = nullptr;
+    }
+
+    return status;
+}
+
+status_code
+fan_out_pipeline::get_target_status(
+    const uint32 p_target_index) const
+{
+    return m_target_statuses[p_target_index];
+}
+
+uint64
+fan_out_pipeline::get_target_bytes_transferred(
+    const uint32 p_target_index) const
+{
+    return m_target_bytes_transferred[p_target_index];
+}
+
+void
+fan_out_pipeline::run_scheduled_writer(
+    const std::shared_ptr<writer_claims>& p_writer_claims,
+    const uint32 p_target_index)
+{
+    {
+        std::scoped_lock<std::mutex> lock(p_writer_claims->m_lock);
+
+        //
+        // The pipeline may be gone once the reader took the writer over; it is not touched in that case.
+        //
+        if (p_writer_claims->m_claimed_writers[p_target_index])
+        {
+            return;
+        }
+
+        p_writer_claims->m_claimed_writers[p_target_index] = true;
+        ++p_writer_claims->m_number_running_writers;
+    }
+
+    write_target(
+        p_target_index,
+        true /* Wait for slots. */);
+
+    std::scoped_lock<std::mutex> lock(p_writer_claims->m_lock);
+
+    if (--p_writer_claims->m_number_running_writers == 0)
+    {
+        p_writer_claims->m_writers_completed_condition.notify_all();
+    }
+}
+
+void
+fan_out_pipeline::claim_unstarted_writers()
+{
+    std::scoped_lock<std::mutex> lock(m_writer_claims->m_lock);
+
+    for (uint32 target_index = 0; target_index < m_writer_claims->m_claimed_writers.size(); ++target_index)
+    {
+        if (!m_writer_claims->m_claimed_writers[target_index])
+        {
+            m_writer_claims->m_claimed_writers[target_index] = true;
+            m_reader_targets.push_back(target_index);
+        }
+    }
+}
+
+void
+fan_out_pipeline::write_target(
+    const uint32 p_target_index,
+    const bool p_wait_for_slots)
+{
+    uint64& slot_sequence = m_target_slot_sequences[p_target_index];
+
+    forever
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            if (p_wait_for_slots)
+            {
+                m_slot_filled_condition.wait(lock, [this, &slot_sequence]()
+                {
+                    return m_number_filled_slots > slot_sequence || m_source_exhausted;
+                });
+            }
+
+            if (m_number_filled_slots <= slot_sequence)
+            {
+                return;
+            }
+        }
+
+        const slot& slot = m_slots[slot_sequence % c_number_slots];
+
+        //
+        // A failed target keeps draining the ring without writing, so that the reader never waits on it.
+        //
+        if (status::succeeded(m_target_statuses[p_target_index]))
+        {
+            m_target_statuses[p_target_index] = write_slot(
+                m_target_file_descriptors[p_target_index],
+                slot);
+
+            if (status::succeeded(m_target_statuses[p_target_index]))
+            {
+                m_target_bytes_transferred[p_target_index] += slot.m_length;
+            }
+        }
+
+        bool slot_released = false;
+
+        {
+            std::scoped_lock<std::mutex> lock(m_lock);
+            slot_released = --m_slots[slot_sequence % c_number_slots].m_number_pending_writers == 0;
+        }
+
+        if (slot_released)
+        {
+            m_slot_released_condition.notify_one();
+        }
+
+        ++slot_sequence;
+    }
+}
+
+status_code
+fan_out_pipeline::write_slot(
+    const file_descriptor p_target_file_descriptor,
+    const slot& p_slot)
+{
+    uint32 number_bytes_written = 0;
+
+    while (number_bytes_written < p_slot.m_length)
+    {
+        const ssize_t bytes_written = pwrite(
+            p_target_file_descriptor,
+            p_slot.m_buffer + number_bytes_written,
+            p_slot.m_length - number_bytes_written,
+            p_slot.m_offset + number_bytes_written);
+
+        if (bytes_written < 0 &&
+            errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes_written <= 0)
+        {
+            return status::native_copy_failed;
+        }
+
+        number_bytes_written += bytes_written;
+    }
+
+    return status::success;
+}
+
+byte*
+fan_out_pipeline::acquire_buffer()
+{
+    {
+        std::scoped_lock<std::mutex> lock(s_buffers_pool_lock);
+
+        if (!s_buffers_pool.empty())
+        {
+            byte* buffer = s_buffers_pool.back().release();
+            s_buffers_pool.pop_back();
+
+            return buffer;
+        }
+    }
+
+    return new byte[c_buffer_size];
+}
+
+void
+fan_out_pipeline::release_buffer(
+    byte* p_buffer)
+{
+    std::unique_ptr<byte[]> buffer(p_buffer);
+
+    std::scoped_lock<std::mutex> lock(s_buffers_pool_lock);
+
+    if (s_buffers_pool.size() < c_max_number_pooled_buffers)
+    {
+        s_buffers_pool.push_back(std::move(buffer));
+    }
+}
+
+} // namespace modula.
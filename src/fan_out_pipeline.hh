@@ -0,0 +1,271 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'fan_out_pipeline.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef FAN_OUT_PIPELINE_
+#define FAN_OUT_PIPELINE_
+
+#include "status.hh"
+#include "utilities.hh"
+#include "thread_pool.hh"
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <condition_variable>
+
+namespace modula
+{
+
+//
+// Fan-out pipeline class for replicating a source file into many target files out of a single read.
+// The data extents of the source file are read once into a ring of pooled buffers by the calling thread,
+// while one writer per target drains the same buffers concurrently from the replication tasks thread pool.
+// Writers still waiting for a worker thread once the reader needs their slots are taken over by the reader,
+// so the pipeline never waits on the thread pool it may itself be running on.
+//
+class fan_out_pipeline
+{
+
+public:
+
+    //
+    // Constructor. Binds the pipeline to the source file and the target files to be written.
+    //
+    fan_out_pipeline(
+        const file_descriptor p_source_file_descriptor,
+        const uint64 p_number_bytes,
+        const std::vector<file_descriptor>& p_target_file_descriptors);
+
+    //
+    // Executes the pipeline and returns the status of the source read. Writers are
+    // scheduled on the provided thread pool and are all completed before returning.
+    // Writers the thread pool does not start in time are run by the calling thread.
+    //
+    status_code
+    execute(
+        thread_pool* p_thread_pool);
+
+    //
+    // Returns the status of the writes into a target file.
+    //
+    status_code
+    get_target_status(
+        const uint32 p_target_index) const;
+
+    //
+    // Returns the number of bytes written into a target file.
+    //
+    uint64
+    get_target_bytes_transferred(
+        const uint32 p_target_index) const;
+
+private:
+
+    //
+    // Slot of the buffers ring shared by the reader and the writers.
+    //
+    struct slot
+    {
+
+        //
+        // Pooled buffer holding the slot data.
+        //
+        byte* m_buffer;
+
+        //
+        // Offset of the slot data in both the source and target files.
+        //
+        uint64 m_offset;
+
+        //
+        // Number of valid bytes in the buffer.
+        //
+        uint32 m_length;
+
+        //
+        // Number of writers which have not yet consumed the slot.
+        //
+        uint32 m_number_pending_writers;
+
+    };
+
+    //
+    // Claims over the writers of a pipeline, shared with the writers scheduled on the thread pool.
+    // Writers taken over by the reader may only start once the pipeline is gone, so they find out
+    // whether their target is still theirs through the claims alone.
+    //
+    struct writer_claims
+    {
+
+        //
+        // Flags for determining whether each writer was claimed, either by its scheduled writer or by the reader.
+        //
+        std::vector<bool> m_claimed_writers;
+
+        //
+        // Number of writers claimed by their scheduled writer and not completed yet.
+        //
+        uint32 m_number_running_writers;
+
+        //
+        // Lock for synchronizing access to the claims.
+        //
+        std::mutex m_lock;
+
+        //
+        // Condition for awakening the reader once the last running writer completes.
+        //
+        std::condition_variable m_writers_completed_condition;
+
+    };
+
+    //
+    // Runs a scheduled writer, unless the reader already took it over.
+    //
+    void
+    run_scheduled_writer(
+        const std::shared_ptr<writer_claims>& p_writer_claims,
+        const uint32 p_target_index);
+
+    //
+    // Takes over the writers which have not started yet, returning them through the reader targets.
+    //
+    void
+    claim_unstarted_writers();
+
+    //
+    // Drains the buffers ring into a target file. Waits for further slots until the source is exhausted
+    // when requested, or returns once all the filled slots are consumed otherwise.
+    //
+    void
+    write_target(
+        const uint32 p_target_index,
+        const bool p_wait_for_slots);
+
+    //
+    // Writes a whole slot into a target file.
+    //
+    status_code
+    write_slot(
+        const file_descriptor p_target_file_descriptor,
+        const slot& p_slot);
+
+    //
+    // Acquires a buffer from the process-wide buffers pool.
+    //
+    static
+    byte*
+    acquire_buffer();
+
+    //
+    // Returns a buffer into the process-wide buffers pool.
+    //
+    static
+    void
+    release_buffer(
+        byte* p_buffer);
+
+    //
+    // Source file to read from.
+    //
+    file_descriptor m_source_file_descriptor;
+
+    //
+    // Number of bytes to be replicated.
+    //
+    uint64 m_number_bytes;
+
+    //
+    // Target files to write into.
+    //
+    std::vector<file_descriptor> m_target_file_descriptors;
+
+    //
+    // Status of the writes for each target file.
+    //
+    std::vector<status_code> m_target_statuses;
+
+    //
+    // Number of bytes written into each target file.
+    //
+    std::vector<uint64> m_target_bytes_transferred;
+
+    //
+    // Ring of slots shared by the reader and the writers.
+    //
+    std::vector<slot> m_slots;
+
+    //
+    // Number of slots filled by the reader so far; slot sequence numbers wrap over the ring.
+    //
+    uint64 m_number_filled_slots;
+
+    //
+    // Sequence number of the next slot to be consumed by each writer.
+    //
+    std::vector<uint64> m_target_slot_sequences;
+
+    //
+    // Claims over the writers, shared with the writers scheduled on the thread pool.
+    //
+    std::shared_ptr<writer_claims> m_writer_claims;
+
+    //
+    // Targets whose writers were taken over by the reader.
+    //
+    std::vector<uint32> m_reader_targets;
+
+    //
+    // Flag for determining whether the reader finished filling slots.
+    //
+    bool m_source_exhausted;
+
+    //
+    // Lock for synchronizing access to the slots ring.
+    //
+    std::mutex m_lock;
+
+    //
+    // Condition for awakening the writers on new filled slots.
+    //
+    std::condition_variable m_slot_filled_condition;
+
+    //
+    // Condition for awakening the reader on released slots.
+    //
+    std::condition_variable m_slot_released_condition;
+
+    //
+    // Process-wide pool of buffers reused across pipelines.
+    //
+    static std::vector<std::unique_ptr<byte[]>> s_buffers_pool;
+
+    //
+    // Lock for synchronizing access to the buffers pool.
+    //
+    static std::mutex s_buffers_pool_lock;
+
+    //
+    // Number of slots in the buffers ring.
+    //
+    static constexpr uint32 c_number_slots = 8u;
+
+    //
+    // Size in bytes of each pooled buffer.
+    //
+    static constexpr uint32 c_buffer_size = 1024u * 1024u;
+
+    //
+    // Max number of idle buffers retained by the buffers pool.
+    //
+    static constexpr uint32 c_max_number_pooled_buffers = 64u;
+
+};
+
+} // namespace modula.
+
+#endif
@@ -0,0 +1,126 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'filesystem_events_batch.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "filesystem_events_batch.hh"
+
+namespace modula
+{
+
+filesystem_events_batch::filesystem_events_batch()
+{
+    m_entries.reserve(c_initial_number_entries);
+    m_names.reserve(c_initial_names_size);
+}
+
+std::string*
+filesystem_events_batch::append(
+    const file_descriptor p_watch_descriptor,
+    const replication_action p_replication_action,
+    const bool p_write_completed)
+{
+    seal_last_entry();
+
+    m_entries.push_back(entry{
+        p_watch_descriptor,
+        p_replication_action,
+        p_write_completed,
+        static_cast<uint32>(m_names.size()),
+        0,
+        0,
+        0});
+
+    return &m_names;
+}
+
+std::string*
+filesystem_events_batch::append_move(
+    const file_descriptor p_watch_descriptor,
+    const std::string_view p_previous_filesystem_object_name)
+{
+    seal_last_entry();
+
+    const uint32 previous_name_offset = m_names.size();
+    m_names.append(p_previous_filesystem_object_name);
+
+    m_entries.push_back(entry{
+        p_watch_descriptor,
+        replication_action::move,
+        true /* Write completed. */,
+        static_cast<uint32>(m_names.size()),
+        0,
+        previous_name_offset,
+        static_cast<uint32>(p_previous_filesystem_object_name.size())});
+
+    return &m_names;
+}
+
+void
+filesystem_events_batch::append(
+    const file_descriptor p_watch_descriptor,
+    const replication_action p_replication_action,
+    const bool p_write_completed,
+    const std::string_view p_filesystem_object_name)
+{
+    append(
+        p_watch_descriptor,
+        p_replication_action,
+        p_write_completed)->append(p_filesystem_object_name);
+}
+
+const filesystem_events_batch::entry&
+filesystem_events_batch::get_entry(
+    const uint32 p_entry_index)
+{
+    seal_last_entry();
+
+    return m_entries[p_entry_index];
+}
+
+std::string_view
+filesystem_events_batch::get_filesystem_object_name(
+    const entry& p_entry) const
+{
+    return std::string_view(m_names).substr(p_entry.m_name_offset, p_entry.m_name_length);
+}
+
+std::string_view
+filesystem_events_batch::get_previous_filesystem_object_name(
+    const entry& p_entry) const
+{
+    return std::string_view(m_names).substr(p_entry.m_previous_name_offset, p_entry.m_previous_name_length);
+}
+
+uint32
+filesystem_events_batch::get_size() const
+{
+    return m_entries.size();
+}
+
+bool
+filesystem_events_batch::is_empty() const
+{
+    return m_entries.empty();
+}
+
+void
+filesystem_events_batch::clear()
+{
+    m_entries.clear();
+    m_names.clear();
+}
+
+void
+filesystem_events_batch::seal_last_entry()
+{
+    if (!m_entries.empty())
+    {
+        entry& last_entry = m_entries.back();
+        last_entry.m_name_length = m_names.size() - last_entry.m_name_offset;
+    }
+}
+
+} // namespace modula.
@@ -0,0 +1,181 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'filesystem_events_batch.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef FILESYSTEM_EVENTS_BATCH_
+#define FILESYSTEM_EVENTS_BATCH_
+
+#include "utilities.hh"
+#include "replication_task.hh"
+
+#include <string>
+#include <vector>
+#include <string_view>
+
+namespace modula
+{
+
+//
+// Filesystem events batch class for handing filesystem events from the kernel events offloader to the
+// replication tasks dispatcher as a single unit. Object names live back to back in a per-batch names arena
+// and entries refer to them by offset, so filling a batch whose buffers were already grown by an earlier
+// use performs no heap allocation. Batches are cleared and recycled instead of being released.
+//
+class filesystem_events_batch
+{
+
+public:
+
+    //
+    // Filesystem event entry of the batch.
+    //
+    struct entry
+    {
+
+        //
+        // Watch descriptor routing the filesystem event to its replication engine.
+        //
+        file_descriptor m_watch_descriptor;
+
+        //
+        // Replication action to be performed.
+        //
+        replication_action m_replication_action;
+
+        //
+        // Flag for determining whether a writer closed the filesystem object.
+        //
+        bool m_write_completed;
+
+        //
+        // Offset of the filesystem object name within the names arena.
+        //
+        uint32 m_name_offset;
+
+        //
+        // Length of the filesystem object name.
+        //
+        uint32 m_name_length;
+
+        //
+        // Offset of the previous filesystem object name of a move within the names arena.
+        //
+        uint32 m_previous_name_offset;
+
+        //
+        // Length of the previous filesystem object name of a move. Zero for any other replication action.
+        //
+        uint32 m_previous_name_length;
+
+    };
+
+    //
+    // Constructor.
+    //
+    filesystem_events_batch();
+
+    //
+    // Starts a new filesystem event entry. The object name is appended through the returned names arena, which
+    // lets callers build names in place; the entry is sealed on the next append or when the batch is read.
+    //
+    std::string*
+    append(
+        const file_descriptor p_watch_descriptor,
+        const replication_action p_replication_action,
+        const bool p_write_completed);
+
+    //
+    // Starts a new filesystem event entry with the provided object name.
+    //
+    void
+    append(
+        const file_descriptor p_watch_descriptor,
+        const replication_action p_replication_action,
+        const bool p_write_completed,
+        const std::string_view p_filesystem_object_name);
+
+    //
+    // Starts a new move filesystem event entry out of the previous filesystem object name. The new object
+    // name is appended through the returned names arena, as with any other entry. Moves are flagged as
+    // write completed since a rename carries no pending writes.
+    //
+    std::string*
+    append_move(
+        const file_descriptor p_watch_descriptor,
+        const std::string_view p_previous_filesystem_object_name);
+
+    //
+    // Returns a filesystem event entry of the batch.
+    //
+    const entry&
+    get_entry(
+        const uint32 p_entry_index);
+
+    //
+    // Returns the filesystem object name of a filesystem event entry.
+    //
+    std::string_view
+    get_filesystem_object_name(
+        const entry& p_entry) const;
+
+    //
+    // Returns the previous filesystem object name of a move filesystem event entry.
+    //
+    std::string_view
+    get_previous_filesystem_object_name(
+        const entry& p_entry) const;
+
+    //
+    // Returns the number of filesystem event entries.
+    //
+    uint32
+    get_size() const;
+
+    //
+    // Determines whether the batch holds no filesystem event entries.
+    //
+    bool
+    is_empty() const;
+
+    //
+    // Removes all filesystem event entries while keeping the grown buffers for reuse.
+    //
+    void
+    clear();
+
+private:
+
+    //
+    // Seals the length of the last filesystem event entry out of the names arena size.
+    //
+    void
+    seal_last_entry();
+
+    //
+    // Filesystem event entries in arrival order.
+    //
+    std::vector<entry> m_entries;
+
+    //
+    // Arena holding the filesystem object names back to back.
+    //
+    std::string m_names;
+
+    //
+    // Initial number of entries reserved for a new batch.
+    //
+    static constexpr uint32 c_initial_number_entries = 256u;
+
+    //
+    // Initial size in bytes reserved for the names arena of a new batch.
+    //
+    static constexpr uint32 c_initial_names_size = 16u * 1024u;
+
+};
+
+} // namespace modula.
+
+#endif
@@ -12,18 +12,31 @@
 
 #include <tuple>
 #include <chrono>
+#include <csignal>
 #include <cstdlib>
 #include <cstring>
+#include <poll.h>
+#include <sched.h>
 #include <unistd.h>
+#include <iterator>
+#include <pthread.h>
+#include <algorithm>
+#include <functional>
 #include <filesystem>
 #include <sys/epoll.h>
+#include <sys/statfs.h>
+#include <sys/eventfd.h>
+#include <sys/fanotify.h>
+#include <unordered_map>
 
 namespace modula
 {
 
 filesystem_event::filesystem_event()
     : m_replication_action(replication_action::invalid),
-      m_filesystem_object_name("")
+      m_filesystem_object_name(""),
+      m_previous_filesystem_object_name(""),
+      m_write_completed(false)
 {}
 
 filesystem_monitor::filesystem_monitor(
@@ -32,23 +45,47 @@ filesystem_monitor::filesystem_monitor(
     status_code* p_status) :
     m_termination_signals_handle(p_termination_signals_handle),
     m_replication_manager(p_replication_manager),
-    m_random_identifier_generator()
+    m_number_queued_filesystem_events(0),
+    m_max_filesystem_events_queue_depth(0),
+    m_number_received_filesystem_events(0),
+    m_number_dispatched_replication_tasks(0),
+    m_number_kernel_events_queue_overflows(0),
+    m_number_deferred_dispatches(0),
+    m_number_in_flight_replications(0),
+    m_random_identifier_generator(),
+    m_fanotify_handle(c_invalid_file_descriptor)
 {
     //
-    // Start the inotify instance in non-blocking mode.
+    // Start the eventfd instance used by the kernel events offloader for awakening the replication tasks dispatcher.
     //
-    m_inotify_handle = inotify_init1(IN_NONBLOCK);
+    m_filesystem_events_notification_handle = eventfd(0, EFD_CLOEXEC);
 
-    if (!utilities::is_file_descriptor_valid(m_inotify_handle))
+    if (!utilities::is_file_descriptor_valid(m_filesystem_events_notification_handle))
     {
-        *p_status = status::inotify_startup_failed;
+        *p_status = status::eventfd_startup_failed;
 
-        logger::log(log_level::critical, std::format("Inotify instance startup failed. Status={:#X}.",
+        logger::log(log_level::critical, std::format("Eventfd instance startup failed. {} (errno {}), Status={:#X}.",
+            std::strerror(errno),
+            errno,
             *p_status));
 
         return;
     }
 
+    //
+    // Start the inotify shards, each with its own inotify and epoll instances.
+    //
+    const uint32 number_inotify_shards = m_replication_manager->get_number_inotify_shards();
+
+    for (uint32 shard_index = 0; shard_index < number_inotify_shards; ++shard_index)
+    {
+        m_inotify_shards.emplace_back(std::make_unique<inotify_shard>(shard_index));
+
+        *p_status = start_inotify_shard(*m_inotify_shards.back());
+
+        return_if_failed(*p_status)
+    }
+
     //
     // Start all watch descriptors for the specified directories.
     //
@@ -70,10 +107,17 @@ filesystem_monitor::filesystem_monitor(
             return;
         }
 
+        const bool fanotify_monitoring = replication_engines[replication_engine_index].get_monitoring_backend() == monitoring_backend::fanotify;
+        inotify_shard& shard = *m_inotify_shards[m_replication_manager->get_inotify_shard_index(replication_engine_index)];
+
+        //
+        // Source directories monitored through fanotify keep a single inotify watch, limited to the
+        // removal of the directory itself, whose watch descriptor routes their filesystem events.
+        //
         file_descriptor directory_watch_descriptor = inotify_add_watch(
-            m_inotify_handle,
+            shard.m_inotify_handle,
             replication_engine_source_directory_path.c_str(),
-            IN_CREATE | IN_MODIFY | IN_DELETE);
+            fanotify_monitoring ? (IN_DELETE_SELF | IN_ONLYDIR) : c_directory_watch_mask);
     
         if (!utilities::is_file_descriptor_valid(directory_watch_descriptor))
         {
@@ -86,49 +130,70 @@ filesystem_monitor::filesystem_monitor(
             return;
         }
 
-        m_watch_descriptors.emplace_back(directory_watch_descriptor);
+        shard.m_watch_descriptors.emplace_back(directory_watch_descriptor);
+        shard.m_watch_descriptor_index.add_root(directory_watch_descriptor);
+        shard.m_source_directory_paths.emplace(directory_watch_descriptor, replication_engine_source_directory_path);
 
         //
-        // Apppend entry for cross-reference routing across components.
+        // Apppend entry for cross-reference routing across components. Watch descriptors are only unique within
+        // an inotify instance, so the filesystem events are routed through watch descriptors carrying the shard.
         //
         m_replication_manager->append_entry_to_replication_engines_router(
+            shard.m_shard_index,
             directory_watch_descriptor,
             replication_engine_index);
-    }
 
-    //
-    // Create an epoll instance used for monitoring the kernel inotify
-    // filesystem events along with external system termination signals.
-    //
-    m_epoll_handle = epoll_create1(0);
+        const file_descriptor routing_watch_descriptor = shard.get_routing_watch_descriptor(directory_watch_descriptor);
 
-    if (!utilities::is_file_descriptor_valid(m_epoll_handle))
-    {
-        *p_status = status::epoll_startup_failed;
+        m_coalescing_windows.emplace(
+            routing_watch_descriptor,
+            replication_engines[replication_engine_index].get_coalescing_window());
 
-        logger::log(log_level::critical, std::format("Epoll instance startup failed. Status={:#X}.",
-            *p_status));
+        if (fanotify_monitoring)
+        {
+            *p_status = add_fanotify_source(
+                replication_engine_source_directory_path,
+                routing_watch_descriptor);
 
-        return;
+            return_if_failed(*p_status)
+
+            continue;
+        }
+
+        //
+        // Existing objects are covered by the initial full sync; only the nested directories are watched.
+        //
+        watch_directory_tree(
+            shard,
+            directory_watch_descriptor,
+            directory_watch_descriptor,
+            "",
+            false /* Publish existing objects. */);
+
+        logger::log(log_level::info, std::format("Source directory tree watched. "
+            "SourceDirectoryPath={}, InotifyShardIndex={}, NumberWatchedDirectories={}.",
+            replication_engine_source_directory_path,
+            shard.m_shard_index,
+            shard.m_watch_descriptor_index.get_number_watch_descriptors()));
     }
 
     //
-    // Setup the epoll events for system termination and filesystem monitoring.
+    // The fanotify instance is offloaded by the first shard.
     //
     epoll_event event;
     event.events = EPOLLIN;
-
-    event.data.fd = m_termination_signals_handle;
-
-    if (utilities::system_call_failed(epoll_ctl(
-        m_epoll_handle,
-        EPOLL_CTL_ADD,
-        m_termination_signals_handle,
-        &event)))
+    event.data.fd = m_fanotify_handle;
+
+    if (utilities::is_file_descriptor_valid(m_fanotify_handle) &&
+        utilities::system_call_failed(epoll_ctl(
+            m_inotify_shards.front()->m_epoll_handle,
+            EPOLL_CTL_ADD,
+            m_fanotify_handle,
+            &event)))
     {
         *p_status = status::epoll_startup_failed;
 
-        logger::log(log_level::critical, std::format("Failed to attach the termination signals handle to the epoll instance. {} (errno {}), Status={:#X}.",
+        logger::log(log_level::critical, std::format("Failed to attach the fanotify handle to the epoll instance. {} (errno {}), Status={:#X}.",
             std::strerror(errno),
             errno,
             *p_status));
@@ -136,19 +201,17 @@ filesystem_monitor::filesystem_monitor(
         return;
     }
 
-    event.data.fd = m_inotify_handle;
+    //
+    // Initialize thread pool for handling dispatcher calls to replication engines. It is in place
+    // before the dispatcher thread starts, since the dispatcher checks its capacity on every cycle.
+    //
+    m_dispatcher_thread_pool = std::make_unique<thread_pool>(
+        p_status,
+        m_replication_manager->get_dispatcher_thread_pool_options());
 
-    if (utilities::system_call_failed(epoll_ctl(
-        m_epoll_handle,
-        EPOLL_CTL_ADD,
-        m_inotify_handle,
-        &event)))
+    if (status::failed(*p_status))
     {
-        *p_status = status::epoll_startup_failed;
-
-        logger::log(log_level::critical, std::format("Failed to attach the inotify handle to the epoll instance. {} (errno {}), Status={:#X}.",
-            std::strerror(errno),
-            errno,
+        logger::log(log_level::critical, std::format("Replication task dispatcher thread pool could not be started. Status={:#X}.",
             *p_status));
 
         return;
@@ -183,42 +246,243 @@ filesystem_monitor::filesystem_monitor(
 
         return;
     }
-    
+}
+
+filesystem_monitor::~filesystem_monitor()
+{
     //
-    // Initialize thread pool for handling dispatcher calls to replication engines.
+    // Ensure the system waits for the kernel events offloaders of the other shards before closing their instances.
     //
-    m_dispatcher_thread_pool = std::make_unique<thread_pool>(
-        p_status,
-        c_dispatcher_thread_pool_size);
-
-    if (status::failed(*p_status))
+    for (const std::unique_ptr<inotify_shard>& shard : m_inotify_shards)
     {
-        logger::log(log_level::critical, std::format("Replication task dispatcher thread pool could not be started. Status={:#X}.",
-            *p_status));
+        if (shard->m_kernel_events_offloader_thread.joinable())
+        {
+            shard->m_kernel_events_offloader_thread.join();
+        }
     }
-}
 
-filesystem_monitor::~filesystem_monitor()
-{
-    for (const file_descriptor& watch_descriptor : m_watch_descriptors)
+    for (const std::unique_ptr<inotify_shard>& shard : m_inotify_shards)
     {
-        inotify_rm_watch(m_inotify_handle, watch_descriptor);
+        for (const file_descriptor& watch_descriptor : shard->m_watch_descriptors)
+        {
+            inotify_rm_watch(shard->m_inotify_handle, watch_descriptor);
+        }
+
+        if (utilities::is_file_descriptor_valid(shard->m_inotify_handle))
+        {
+            close(shard->m_inotify_handle);
+        }
+
+        if (utilities::is_file_descriptor_valid(shard->m_epoll_handle))
+        {
+            close(shard->m_epoll_handle);
+        }
     }
     
+    for (const fanotify_source& fanotify_source : m_fanotify_sources)
+    {
+        close(fanotify_source.m_mount_file_descriptor);
+    }
+
+    if (utilities::is_file_descriptor_valid(m_fanotify_handle))
+    {
+        close(m_fanotify_handle);
+    }
+
     close(m_termination_signals_handle);
-    close(m_inotify_handle);
-    close(m_epoll_handle);
 
     //
     // Ensure the system waits for the replication tasks dispatcher to finish.
     //
+    notify_replication_tasks_dispatcher();
     m_replication_tasks_dispatcher_thread.join();
+
+    //
+    // Ensure the system waits for the in-flight replications, which still reference the dispatcher thread pool.
+    //
+    {
+        std::unique_lock<std::mutex> lock(m_in_flight_replications_lock);
+
+        m_in_flight_replications_condition.wait(lock, [this]()
+        {
+            return m_number_in_flight_replications == 0;
+        });
+    }
+
+    close(m_filesystem_events_notification_handle);
+}
+
+filesystem_monitor::inotify_shard::inotify_shard(
+    const uint32 p_shard_index) :
+    m_shard_index(p_shard_index),
+    m_epoll_handle(c_invalid_file_descriptor),
+    m_inotify_handle(c_invalid_file_descriptor),
+    m_filesystem_events_queue(c_filesystem_events_queue_capacity),
+    m_recycled_filesystem_events_batches(c_filesystem_events_queue_capacity),
+    m_offloading_batch(std::make_unique<filesystem_events_batch>())
+{}
+
+file_descriptor
+filesystem_monitor::inotify_shard::get_routing_watch_descriptor(
+    const file_descriptor p_watch_descriptor) const
+{
+    return replication_manager::get_routing_watch_descriptor(
+        m_shard_index,
+        p_watch_descriptor);
+}
+
+status_code
+filesystem_monitor::start_inotify_shard(
+    inotify_shard& p_inotify_shard)
+{
+    status_code status = status::success;
+
+    //
+    // Start the inotify instance in non-blocking mode.
+    //
+    p_inotify_shard.m_inotify_handle = inotify_init1(IN_NONBLOCK);
+
+    if (!utilities::is_file_descriptor_valid(p_inotify_shard.m_inotify_handle))
+    {
+        status = status::inotify_startup_failed;
+
+        logger::log(log_level::critical, std::format("Inotify instance startup failed. InotifyShardIndex={}, {} (errno {}), Status={:#X}.",
+            p_inotify_shard.m_shard_index,
+            std::strerror(errno),
+            errno,
+            status));
+
+        return status;
+    }
+
+    //
+    // Create an epoll instance used for monitoring the kernel inotify
+    // filesystem events along with external system termination signals.
+    //
+    p_inotify_shard.m_epoll_handle = epoll_create1(0);
+
+    if (!utilities::is_file_descriptor_valid(p_inotify_shard.m_epoll_handle))
+    {
+        status = status::epoll_startup_failed;
+
+        logger::log(log_level::critical, std::format("Epoll instance startup failed. InotifyShardIndex={}, Status={:#X}.",
+            p_inotify_shard.m_shard_index,
+            status));
+
+        return status;
+    }
+
+    //
+    // Setup the epoll events for system termination and filesystem monitoring. The termination signals
+    // handle is never read, so it stays ready and wakes the offloaders of every shard on termination.
+    //
+    epoll_event event;
+    event.events = EPOLLIN;
+
+    event.data.fd = m_termination_signals_handle;
+
+    if (utilities::system_call_failed(epoll_ctl(
+        p_inotify_shard.m_epoll_handle,
+        EPOLL_CTL_ADD,
+        m_termination_signals_handle,
+        &event)))
+    {
+        status = status::epoll_startup_failed;
+
+        logger::log(log_level::critical, std::format("Failed to attach the termination signals handle to the epoll instance. {} (errno {}), Status={:#X}.",
+            std::strerror(errno),
+            errno,
+            status));
+
+        return status;
+    }
+
+    event.data.fd = p_inotify_shard.m_inotify_handle;
+
+    if (utilities::system_call_failed(epoll_ctl(
+        p_inotify_shard.m_epoll_handle,
+        EPOLL_CTL_ADD,
+        p_inotify_shard.m_inotify_handle,
+        &event)))
+    {
+        status = status::epoll_startup_failed;
+
+        logger::log(log_level::critical, std::format("Failed to attach the inotify handle to the epoll instance. {} (errno {}), Status={:#X}.",
+            std::strerror(errno),
+            errno,
+            status));
+
+        return status;
+    }
+
+    return status;
 }
 
 void
 filesystem_monitor::start_kernel_events_offloader()
 {
-    std::vector<filesystem_event> offloading_filesystem_events_bucket;
+    const uint32 number_cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (const std::unique_ptr<inotify_shard>& shard : m_inotify_shards)
+    {
+        if (shard->m_shard_index != 0)
+        {
+            try
+            {
+                shard->m_kernel_events_offloader_thread = std::thread(
+                    &filesystem_monitor::run_kernel_events_offloader,
+                    this,
+                    std::ref(*shard));
+            }
+            catch (const std::system_error& exception)
+            {
+                logger::log(log_level::critical, std::format("Failed to start the kernel events offloader thread. "
+                    "InotifyShardIndex={}, Exception='{}', Status={:#X}.",
+                    shard->m_shard_index,
+                    exception.what(),
+                    status::launch_thread_failed));
+
+                //
+                // Terminate gracefully through the termination signals handle, which stops the offloaders already started.
+                //
+                kill(getpid(), SIGTERM);
+
+                break;
+            }
+        }
+
+        //
+        // Spread the offloaders across cores so that the shards are drained in parallel.
+        //
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(shard->m_shard_index % number_cores, &cpu_set);
+
+        const int32 affinity_status = pthread_setaffinity_np(
+            shard->m_shard_index == 0 ? pthread_self() : shard->m_kernel_events_offloader_thread.native_handle(),
+            sizeof(cpu_set),
+            &cpu_set);
+
+        if (affinity_status != 0)
+        {
+            logger::log(log_level::warning, std::format("Kernel events offloader thread could not be pinned to a core. "
+                "InotifyShardIndex={}, {} (errno {}).",
+                shard->m_shard_index,
+                std::strerror(affinity_status),
+                affinity_status));
+        }
+    }
+
+    run_kernel_events_offloader(*m_inotify_shards.front());
+}
+
+void
+filesystem_monitor::run_kernel_events_offloader(
+    inotify_shard& p_inotify_shard)
+{
+    logger::log(log_level::info, std::format("Offloading the filesystem events of an inotify shard. InotifyShardIndex={}, NumberInotifyShards={}.",
+        p_inotify_shard.m_shard_index,
+        m_inotify_shards.size()));
 
     forever
     {
@@ -233,11 +497,14 @@ filesystem_monitor::start_kernel_events_offloader()
         //
         epoll_event epoll_events[c_epoll_event_buffer_size];
 
+        //
+        // Pending moved-from halves bound the wait so that they fall back to removals in time.
+        //
         uint16 number_epoll_events = epoll_wait(
-            m_epoll_handle,
+            p_inotify_shard.m_epoll_handle,
             epoll_events,
             c_epoll_event_buffer_size,
-            -1 /* No timeout for the epoll events. */);
+            p_inotify_shard.m_pending_moves.empty() ? -1 : static_cast<int32>(c_move_pairing_timeout_ms));
 
         if (errno == EAGAIN)
         {
@@ -256,7 +523,8 @@ filesystem_monitor::start_kernel_events_offloader()
 
             epoll_event event = epoll_events[epoll_event_index];
 
-            if (!(event.data.fd == m_inotify_handle ||
+            if (!(event.data.fd == p_inotify_shard.m_inotify_handle ||
+                event.data.fd == m_fanotify_handle ||
                 event.data.fd == m_termination_signals_handle))
             {
                 //
@@ -268,123 +536,1472 @@ filesystem_monitor::start_kernel_events_offloader()
             if (event.data.fd == m_termination_signals_handle)
             {
                 //
-                // The system has been instructed to be terminated.
+                // The system has been instructed to be terminated. The first shard runs
+                // on the calling thread and handles the termination for the whole system.
                 //
-                modula::invoke_system_termination_handler();
+                if (p_inotify_shard.m_shard_index == 0)
+                {
+                    modula::invoke_system_termination_handler();
+                }
+
+                notify_replication_tasks_dispatcher();
 
                 return;
             }
 
+            if (event.data.fd == m_fanotify_handle)
+            {
+                offload_fanotify_events(p_inotify_shard);
+
+                continue;
+            }
+
+            offload_inotify_events(p_inotify_shard);
+        }
+
+        if (!p_inotify_shard.m_pending_moves.empty())
+        {
+            expire_pending_moves(
+                p_inotify_shard,
+                std::chrono::steady_clock::now());
+        }
+
+        //
+        // A single wakeup covers all filesystem events offloaded out of the ready instances.
+        //
+        publish_filesystem_events_batch(p_inotify_shard);
+    }
+}
+
+void
+filesystem_monitor::offload_inotify_events(
+    inotify_shard& p_inotify_shard)
+{
+    //
+    // Read event buffer of the inotify instance.
+    //
+    byte read_event_buffer[c_read_event_buffer_size] __attribute__ ((aligned(__alignof__(inotify_event))));
+
+    forever
+    {
+        const ssize_t number_bytes_read = read(
+            p_inotify_shard.m_inotify_handle,
+            read_event_buffer,
+            c_read_event_buffer_size);
+
+        if (number_bytes_read <= 0)
+        {
             //
-            // Read event buffer of the inotify instance.
+            // The inotify instance has been drained (EAGAIN) or failed; wait for the next wakeup.
             //
-            byte read_event_buffer[c_read_event_buffer_size] __attribute__ ((aligned(__alignof__(inotify_event))));
+            return;
+        }
+
+        uint32 number_bytes_processed = 0;
+
+        while (number_bytes_processed < number_bytes_read)
+        {
+            inotify_event* inotify_filesystem_event = reinterpret_cast<inotify_event*>(&read_event_buffer[number_bytes_processed]);
 
-            uint32 number_bytes_read = read(
-                m_inotify_handle,
-                read_event_buffer,
-                c_read_event_buffer_size);
+            number_bytes_processed += sizeof(inotify_event) + inotify_filesystem_event->len;
 
-            if (errno == EAGAIN)
+            if (inotify_filesystem_event->mask & IN_Q_OVERFLOW)
             {
                 //
-                // The inotify instance has no current data to process; ignore.
+                // The overflow is reported without a watch descriptor; every source directory of the shard may have lost events.
                 //
+                handle_kernel_events_queue_overflow(
+                    p_inotify_shard,
+                    monitoring_backend::inotify);
+
                 continue;
             }
 
-            if (number_bytes_read <= 0)
+            if (inotify_filesystem_event->mask & IN_IGNORED)
             {
                 //
-                // Unknown behavior.
+                // The watched directory was removed or unmounted and the kernel dropped its watch.
                 //
+                p_inotify_shard.m_watch_descriptor_index.remove(inotify_filesystem_event->wd);
+            }
+
+            if (!inotify_filesystem_event->len ||
+                !p_inotify_shard.m_watch_descriptor_index.contains(inotify_filesystem_event->wd))
+            {
+                continue;
+            }
+
+            const std::string_view filesystem_object_name(inotify_filesystem_event->name);
+
+            if (filesystem_object_name.empty())
+            {
+                continue;
+            }
+
+            if (inotify_filesystem_event->mask & IN_MOVED_FROM)
+            {
+                offload_moved_from_event(
+                    p_inotify_shard,
+                    inotify_filesystem_event,
+                    filesystem_object_name);
+
+                continue;
+            }
+
+            if (inotify_filesystem_event->mask & IN_MOVED_TO)
+            {
+                offload_moved_to_event(
+                    p_inotify_shard,
+                    inotify_filesystem_event,
+                    filesystem_object_name);
+
                 continue;
             }
 
-            uint32 number_bytes_processed = 0;
-            uint32 number_filesystem_events_processed = 0;
+            replication_action action = replication_action::invalid;
+            bool write_completed = false;
 
-            while (number_bytes_processed < number_bytes_read)
+            //
+            // Logging is handled by the replication tasks dispatcher.
+            //
+            switch (inotify_filesystem_event->mask & ~IN_ISDIR)
             {
-                inotify_event* inotify_filesystem_event = reinterpret_cast<inotify_event*>(&read_event_buffer[number_bytes_processed]);
+                case IN_CREATE:
+                {
+                    action = replication_action::create;
 
-                if (inotify_filesystem_event->len)
+                    break;
+                }
+                case IN_MODIFY:
                 {
-                    filesystem_event event;
+                    action = replication_action::update;
 
-                    event.m_filesystem_object_name = inotify_filesystem_event->name;
+                    break;
+                }
+                case IN_DELETE:
+                {
+                    action = replication_action::remove;
 
-                    if (!event.m_filesystem_object_name.empty())
-                    {
-                        event.m_watch_descriptor = inotify_filesystem_event->wd;
-
-                        //
-                        // Logging is handled by the replication tasks dispatcher.
-                        //
-                        switch (inotify_filesystem_event->mask)
-                        {
-                            case IN_CREATE:
-                            {
-                                event.m_replication_action = replication_action::create;
-
-                                break;
-                            }
-                            case IN_MODIFY:
-                            {
-                                event.m_replication_action = replication_action::update;
-
-                                break;
-                            }
-                            case IN_DELETE:
-                            {
-                                event.m_replication_action = replication_action::remove;
-
-                                break;
-                            }
-                        }
-
-                        if (event.m_replication_action != replication_action::invalid)
-                        {
-                            //
-                            // Valid event to process is found; append it to the offloading bucket.
-                            //
-                            offloading_filesystem_events_bucket.push_back(event);
-                        }
-                    }
+                    break;
+                }
+                case IN_CLOSE_WRITE:
+                {
+                    write_completed = true;
+
+                    break;
                 }
-                
-                number_bytes_processed += sizeof(inotify_event) + inotify_filesystem_event->len;
             }
-        }
 
-        if (!offloading_filesystem_events_bucket.empty())
-        {
+            if (action != replication_action::invalid ||
+                write_completed)
             {
                 //
-                // Append recorded filesystem events to the events queue.
+                // Events of nested directories are routed through the source directory watch descriptor, with
+                // the object name expressed relative to the source directory and written straight into the batch.
                 //
-                std::scoped_lock<std::mutex> lock(m_filesystem_events_queue_lock);
+                p_inotify_shard.m_watch_descriptor_index.append_relative_path(
+                    inotify_filesystem_event->wd,
+                    filesystem_object_name,
+                    append_filesystem_event(
+                        p_inotify_shard,
+                        p_inotify_shard.get_routing_watch_descriptor(p_inotify_shard.m_watch_descriptor_index.get_root_watch_descriptor(inotify_filesystem_event->wd)),
+                        action,
+                        write_completed));
+            }
 
-                for (const filesystem_event& event : offloading_filesystem_events_bucket)
-                {
-                    m_filesystem_events_queue.push(event);
-                }
+            if ((inotify_filesystem_event->mask & IN_CREATE) &&
+                (inotify_filesystem_event->mask & IN_ISDIR))
+            {
+                //
+                // New directories are watched right away. Objects created inside them before the
+                // watch was in place produced no events, so they are published as created as well.
+                //
+                watch_directory_tree(
+                    p_inotify_shard,
+                    p_inotify_shard.m_watch_descriptor_index.get_root_watch_descriptor(inotify_filesystem_event->wd),
+                    inotify_filesystem_event->wd,
+                    filesystem_object_name,
+                    true /* Publish existing objects. */);
             }
-            
-            //
-            // Cleanup the offloading bucket before starting to process new extractions.
-            //
-            offloading_filesystem_events_bucket.clear();
         }
     }
 }
 
 void
-filesystem_monitor::replication_tasks_dispatcher()
+filesystem_monitor::offload_moved_from_event(
+    inotify_shard& p_inotify_shard,
+    const inotify_event* p_inotify_event,
+    const std::string_view p_filesystem_object_name)
 {
-    logger::log(log_level::info, "Starting replication tasks dispatcher thread.");
+    p_inotify_shard.m_pending_moves.push_back(pending_move{
+        p_inotify_event->cookie,
+        p_inotify_event->wd,
+        p_inotify_shard.m_watch_descriptor_index.get_root_watch_descriptor(p_inotify_event->wd),
+        p_inotify_shard.m_watch_descriptor_index.get_relative_path(p_inotify_event->wd, p_filesystem_object_name),
+        (p_inotify_event->mask & IN_ISDIR) != 0,
+        std::chrono::steady_clock::now()});
+}
 
-    std::queue<filesystem_event> filesystem_events_batching_queue;
+void
+filesystem_monitor::offload_moved_to_event(
+    inotify_shard& p_inotify_shard,
+    const inotify_event* p_inotify_event,
+    const std::string_view p_filesystem_object_name)
+{
+    const file_descriptor root_watch_descriptor = p_inotify_shard.m_watch_descriptor_index.get_root_watch_descriptor(p_inotify_event->wd);
+    const bool directory = (p_inotify_event->mask & IN_ISDIR) != 0;
+
+    auto moved_from_event = std::find_if(p_inotify_shard.m_pending_moves.begin(), p_inotify_shard.m_pending_moves.end(), [p_inotify_event](const pending_move& p_pending_move)
+    {
+        return p_pending_move.m_cookie == p_inotify_event->cookie;
+    });
+
+    if (moved_from_event != p_inotify_shard.m_pending_moves.end() &&
+        moved_from_event->m_root_watch_descriptor == root_watch_descriptor)
+    {
+        //
+        // Both halves belong to the same source directory; the target directories only need a rename.
+        //
+        p_inotify_shard.m_watch_descriptor_index.append_relative_path(
+            p_inotify_event->wd,
+            p_filesystem_object_name,
+            append_filesystem_event(
+                p_inotify_shard,
+                p_inotify_shard.get_routing_watch_descriptor(root_watch_descriptor),
+                replication_action::move,
+                true /* Write completed. */,
+                moved_from_event->m_relative_path));
+
+        p_inotify_shard.m_pending_moves.erase(moved_from_event);
+
+        if (directory)
+        {
+            //
+            // A moved directory keeps its watch descriptor; only its location in the index changes. The
+            // directories nested under it resolve their paths through it, so they need no update at all.
+            //
+            const std::string directory_path = std::format("{}/{}",
+                p_inotify_shard.m_source_directory_paths[root_watch_descriptor],
+                p_inotify_shard.m_watch_descriptor_index.get_relative_path(p_inotify_event->wd, p_filesystem_object_name));
+
+            const file_descriptor directory_watch_descriptor = inotify_add_watch(
+                p_inotify_shard.m_inotify_handle,
+                directory_path.c_str(),
+                c_directory_watch_mask | IN_DONT_FOLLOW);
+
+            if (p_inotify_shard.m_watch_descriptor_index.contains(directory_watch_descriptor))
+            {
+                p_inotify_shard.m_watch_descriptor_index.add_child(
+                    directory_watch_descriptor,
+                    p_inotify_event->wd,
+                    p_filesystem_object_name);
+            }
+            else if (utilities::is_file_descriptor_valid(directory_watch_descriptor))
+            {
+                watch_directory_tree(
+                    p_inotify_shard,
+                    root_watch_descriptor,
+                    p_inotify_event->wd,
+                    p_filesystem_object_name,
+                    false /* Publish existing objects. */);
+            }
+        }
+
+        return;
+    }
+
+    if (moved_from_event != p_inotify_shard.m_pending_moves.end())
+    {
+        //
+        // Renames across source directories are replicated as a removal from the previous source directory.
+        //
+        append_filesystem_event(
+            p_inotify_shard,
+            p_inotify_shard.get_routing_watch_descriptor(moved_from_event->m_root_watch_descriptor),
+            replication_action::remove,
+            false /* Write completed. */)->append(moved_from_event->m_relative_path);
+
+        if (moved_from_event->m_directory)
+        {
+            const std::string_view relative_path = moved_from_event->m_relative_path;
+
+            unwatch_directory_tree(
+                p_inotify_shard,
+                moved_from_event->m_parent_watch_descriptor,
+                relative_path.substr(relative_path.rfind('/') + 1));
+        }
+
+        p_inotify_shard.m_pending_moves.erase(moved_from_event);
+    }
+
+    //
+    // The object was moved in from elsewhere; it is replicated as created, along with anything nested under it.
+    //
+    p_inotify_shard.m_watch_descriptor_index.append_relative_path(
+        p_inotify_event->wd,
+        p_filesystem_object_name,
+        append_filesystem_event(
+            p_inotify_shard,
+            p_inotify_shard.get_routing_watch_descriptor(root_watch_descriptor),
+            replication_action::create,
+            true /* Write completed. */));
+
+    if (directory)
+    {
+        watch_directory_tree(
+            p_inotify_shard,
+            root_watch_descriptor,
+            p_inotify_event->wd,
+            p_filesystem_object_name,
+            true /* Publish existing objects. */);
+    }
+}
+
+void
+filesystem_monitor::expire_pending_moves(
+    inotify_shard& p_inotify_shard,
+    const std::chrono::steady_clock::time_point p_current_time)
+{
+    auto pending_move = p_inotify_shard.m_pending_moves.begin();
+
+    while (pending_move != p_inotify_shard.m_pending_moves.end())
+    {
+        if (p_current_time - pending_move->m_move_time < std::chrono::milliseconds(c_move_pairing_timeout_ms))
+        {
+            ++pending_move;
+
+            continue;
+        }
+
+        //
+        // The object left every source directory; it is replicated as removed.
+        //
+        append_filesystem_event(
+            p_inotify_shard,
+            p_inotify_shard.get_routing_watch_descriptor(pending_move->m_root_watch_descriptor),
+            replication_action::remove,
+            false /* Write completed. */)->append(pending_move->m_relative_path);
+
+        if (pending_move->m_directory)
+        {
+            const std::string_view relative_path = pending_move->m_relative_path;
+
+            unwatch_directory_tree(
+                p_inotify_shard,
+                pending_move->m_parent_watch_descriptor,
+                relative_path.substr(relative_path.rfind('/') + 1));
+        }
+
+        pending_move = p_inotify_shard.m_pending_moves.erase(pending_move);
+    }
+}
+
+void
+filesystem_monitor::unwatch_directory_tree(
+    inotify_shard& p_inotify_shard,
+    const file_descriptor p_parent_watch_descriptor,
+    const std::string_view p_directory_name)
+{
+    std::vector<file_descriptor> watch_descriptors;
+
+    p_inotify_shard.m_watch_descriptor_index.collect_subtree_watch_descriptors(
+        p_parent_watch_descriptor,
+        p_directory_name,
+        &watch_descriptors);
+
+    for (const file_descriptor watch_descriptor : watch_descriptors)
+    {
+        //
+        // The kernel still reports IN_IGNORED for each dropped watch; unregistering them twice is harmless.
+        //
+        inotify_rm_watch(p_inotify_shard.m_inotify_handle, watch_descriptor);
+
+        p_inotify_shard.m_watch_descriptor_index.remove(watch_descriptor);
+    }
+}
+
+void
+filesystem_monitor::watch_directory_tree(
+    inotify_shard& p_inotify_shard,
+    const file_descriptor p_root_watch_descriptor,
+    const file_descriptor p_parent_watch_descriptor,
+    const std::string_view p_directory_name,
+    const bool p_publish_existing_objects)
+{
+    const std::string& source_directory_path = p_inotify_shard.m_source_directory_paths[p_root_watch_descriptor];
+
+    //
+    // Pending directories to be watched, along with the watch descriptor of their parent directory.
+    // An explicit stack keeps deep trees from exhausting the offloader thread stack.
+    //
+    std::vector<std::pair<file_descriptor, std::string>> pending_directories;
+
+    if (p_directory_name.empty())
+    {
+        pending_directories.emplace_back(c_invalid_file_descriptor, "");
+    }
+    else
+    {
+        pending_directories.emplace_back(p_parent_watch_descriptor, std::string(p_directory_name));
+    }
+
+    while (!pending_directories.empty())
+    {
+        const auto [parent_watch_descriptor, directory_name] = std::move(pending_directories.back());
+        pending_directories.pop_back();
+
+        file_descriptor directory_watch_descriptor = p_parent_watch_descriptor;
+        std::string relative_directory_path;
+
+        if (parent_watch_descriptor != c_invalid_file_descriptor)
+        {
+            relative_directory_path = p_inotify_shard.m_watch_descriptor_index.get_relative_path(parent_watch_descriptor, directory_name);
+
+            const std::string directory_path = std::format("{}/{}", source_directory_path, relative_directory_path);
+
+            directory_watch_descriptor = inotify_add_watch(
+                p_inotify_shard.m_inotify_handle,
+                directory_path.c_str(),
+                c_directory_watch_mask | IN_DONT_FOLLOW);
+
+            if (!utilities::is_file_descriptor_valid(directory_watch_descriptor))
+            {
+                //
+                // The directory may be gone already, or the inotify watches limit has been reached.
+                //
+                logger::log(log_level::warning, std::format("Watch descriptor for nested directory could not be created. "
+                    "DirectoryPath={}, {} (errno {}), Status={:#X}.",
+                    directory_path,
+                    std::strerror(errno),
+                    errno,
+                    status::directory_watch_descriptor_creation_failed));
+
+                continue;
+            }
+
+            p_inotify_shard.m_watch_descriptor_index.add_child(
+                directory_watch_descriptor,
+                parent_watch_descriptor,
+                directory_name);
+        }
+
+        std::error_code error;
+        std::filesystem::directory_iterator directory_iterator(
+            relative_directory_path.empty() ? source_directory_path : std::format("{}/{}", source_directory_path, relative_directory_path),
+            error);
+
+        for (; !error && directory_iterator != std::filesystem::directory_iterator(); directory_iterator.increment(error))
+        {
+            const std::string object_name = directory_iterator->path().filename().string();
+
+            if (p_publish_existing_objects)
+            {
+                std::string* filesystem_object_name = append_filesystem_event(
+                    p_inotify_shard,
+                    p_inotify_shard.get_routing_watch_descriptor(p_root_watch_descriptor),
+                    replication_action::create,
+                    false /* Write completed. */);
+
+                if (!relative_directory_path.empty())
+                {
+                    filesystem_object_name->append(relative_directory_path);
+                    filesystem_object_name->push_back('/');
+                }
+
+                filesystem_object_name->append(object_name);
+            }
+
+            if (directory_iterator->is_directory(error) &&
+                !directory_iterator->is_symlink(error))
+            {
+                pending_directories.emplace_back(directory_watch_descriptor, object_name);
+            }
+        }
+    }
+}
+
+status_code
+filesystem_monitor::add_fanotify_source(
+    const std::string& p_source_directory_path,
+    const file_descriptor p_routing_watch_descriptor)
+{
+    status_code status = status::success;
+
+    if (!utilities::is_file_descriptor_valid(m_fanotify_handle))
+    {
+        //
+        // Directory entry events are reported with the file handle of their parent directory and the entry name.
+        //
+        m_fanotify_handle = fanotify_init(
+            FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_NONBLOCK | FAN_CLOEXEC,
+            O_RDONLY | O_LARGEFILE);
+
+        if (!utilities::is_file_descriptor_valid(m_fanotify_handle))
+        {
+            status = status::fanotify_startup_failed;
+
+            logger::log(log_level::critical, std::format("Fanotify instance startup failed. {} (errno {}), Status={:#X}.",
+                std::strerror(errno),
+                errno,
+                status));
+
+            return status;
+        }
+    }
+
+    //
+    // Event directories are resolved out of file handles into canonical paths, so the source directory must be as well
+    // for them to be matched against it, e.g. when configured through a symbolic link or with a trailing separator.
+    //
+    std::error_code error;
+    const std::filesystem::path canonical_source_directory_path = std::filesystem::canonical(p_source_directory_path, error);
+
+    if (error)
+    {
+        status = status::fanotify_startup_failed;
+
+        logger::log(log_level::critical, std::format("Failed to resolve the canonical source directory path for fanotify monitoring. "
+            "SourceDirectoryPath={}, {} (errno {}), Status={:#X}.",
+            p_source_directory_path,
+            error.message(),
+            error.value(),
+            status));
+
+        return status;
+    }
+
+    fanotify_source source;
+    source.m_path = canonical_source_directory_path.string();
+    source.m_routing_watch_descriptor = p_routing_watch_descriptor;
+
+    //
+    // The source directory handle serves as the mount reference for resolving file handles of its filesystem.
+    //
+    source.m_mount_file_descriptor = open(
+        p_source_directory_path.c_str(),
+        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    struct statfs source_statfs;
+
+    if (!utilities::is_file_descriptor_valid(source.m_mount_file_descriptor) ||
+        utilities::system_call_failed(fstatfs(source.m_mount_file_descriptor, &source_statfs)))
+    {
+        status = status::fanotify_startup_failed;
+
+        logger::log(log_level::critical, std::format("Failed to open the source directory for fanotify monitoring. "
+            "SourceDirectoryPath={}, {} (errno {}), Status={:#X}.",
+            p_source_directory_path,
+            std::strerror(errno),
+            errno,
+            status));
+
+        if (utilities::is_file_descriptor_valid(source.m_mount_file_descriptor))
+        {
+            close(source.m_mount_file_descriptor);
+        }
+
+        return status;
+    }
+
+    std::memcpy(&source.m_filesystem_identifier, &source_statfs.f_fsid, sizeof(source.m_filesystem_identifier));
+
+    const bool filesystem_marked = std::any_of(m_fanotify_sources.begin(), m_fanotify_sources.end(), [&source](const fanotify_source& p_fanotify_source)
+    {
+        return std::memcmp(&p_fanotify_source.m_filesystem_identifier, &source.m_filesystem_identifier, sizeof(source.m_filesystem_identifier)) == 0;
+    });
+
+    //
+    // A single mark covers every source directory on the same filesystem.
+    //
+    if (!filesystem_marked &&
+        utilities::system_call_failed(fanotify_mark(
+            m_fanotify_handle,
+            FAN_MARK_ADD | FAN_MARK_FILESYSTEM,
+            c_fanotify_mark_mask,
+            AT_FDCWD,
+            p_source_directory_path.c_str())))
+    {
+        status = status::fanotify_startup_failed;
+
+        logger::log(log_level::critical, std::format("Failed to mark the source directory filesystem for fanotify monitoring. "
+            "SourceDirectoryPath={}, {} (errno {}), Status={:#X}.",
+            p_source_directory_path,
+            std::strerror(errno),
+            errno,
+            status));
+
+        close(source.m_mount_file_descriptor);
+
+        return status;
+    }
+
+    logger::log(log_level::info, std::format("Source directory monitored through fanotify. "
+        "SourceDirectoryPath={}, FilesystemMarked={}.",
+        p_source_directory_path,
+        !filesystem_marked));
+
+    m_fanotify_sources.push_back(std::move(source));
+
+    return status;
+}
+
+void
+filesystem_monitor::offload_fanotify_events(
+    inotify_shard& p_inotify_shard)
+{
+    byte read_event_buffer[c_read_event_buffer_size] __attribute__ ((aligned(__alignof__(fanotify_event_metadata))));
+
+    forever
+    {
+        const ssize_t number_bytes_read = read(
+            m_fanotify_handle,
+            read_event_buffer,
+            c_read_event_buffer_size);
+
+        if (number_bytes_read <= 0)
+        {
+            //
+            // The fanotify instance has been drained (EAGAIN) or failed; wait for the next wakeup.
+            //
+            return;
+        }
+
+        offload_fanotify_events_buffer(
+            p_inotify_shard,
+            read_event_buffer,
+            number_bytes_read);
+    }
+}
+
+void
+filesystem_monitor::offload_fanotify_events_buffer(
+    inotify_shard& p_inotify_shard,
+    const byte* p_read_event_buffer,
+    const uint32 p_number_bytes_read)
+{
+    uint32 number_bytes_processed = 0;
+
+    while (p_number_bytes_read - number_bytes_processed >= sizeof(fanotify_event_metadata))
+    {
+        //
+        // Event records are only padded to 4 bytes while their metadata holds 8 byte fields, so it is copied out aligned.
+        //
+        const byte* event_record = p_read_event_buffer + number_bytes_processed;
+        fanotify_event_metadata fanotify_filesystem_event;
+        std::memcpy(&fanotify_filesystem_event, event_record, sizeof(fanotify_filesystem_event));
+
+        if (fanotify_filesystem_event.event_len < sizeof(fanotify_event_metadata) ||
+            fanotify_filesystem_event.event_len > p_number_bytes_read - number_bytes_processed)
+        {
+            break;
+        }
+
+        number_bytes_processed += fanotify_filesystem_event.event_len;
+
+        if (fanotify_filesystem_event.vers != FANOTIFY_METADATA_VERSION)
+        {
+            logger::log(log_level::error, std::format("Fanotify event metadata version mismatch. Version={}.",
+                fanotify_filesystem_event.vers));
+
+            break;
+        }
+
+        if (fanotify_filesystem_event.mask & FAN_Q_OVERFLOW)
+        {
+            handle_kernel_events_queue_overflow(
+                p_inotify_shard,
+                monitoring_backend::fanotify);
+
+            continue;
+        }
+
+        const fanotify_event_info_fid* event_info = reinterpret_cast<const fanotify_event_info_fid*>(
+            event_record + fanotify_filesystem_event.metadata_len);
+
+        if (fanotify_filesystem_event.metadata_len >= fanotify_filesystem_event.event_len ||
+            event_info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME)
+        {
+            continue;
+        }
+
+        file_handle* directory_file_handle = const_cast<file_handle*>(reinterpret_cast<const file_handle*>(event_info->handle));
+        const character* filesystem_object_name = reinterpret_cast<const character*>(directory_file_handle->f_handle + directory_file_handle->handle_bytes);
+
+        if (std::strcmp(filesystem_object_name, ".") == 0)
+        {
+            //
+            // Events on the directory itself are reported by its parent directory as well.
+            //
+            continue;
+        }
+
+        //
+        // Fanotify merges queued events on the same object; a removal supersedes any earlier change.
+        //
+        replication_action action = replication_action::invalid;
+
+        //
+        // Fanotify reports both halves of a rename without a cookie to pair them by; they are replicated as a removal and a creation.
+        //
+        if (fanotify_filesystem_event.mask & (FAN_DELETE | FAN_MOVED_FROM))
+        {
+            action = replication_action::remove;
+        }
+        else if (fanotify_filesystem_event.mask & (FAN_CREATE | FAN_MOVED_TO))
+        {
+            action = replication_action::create;
+        }
+        else if (fanotify_filesystem_event.mask & FAN_MODIFY)
+        {
+            action = replication_action::update;
+        }
+
+        const bool write_completed = (fanotify_filesystem_event.mask & FAN_CLOSE_WRITE) != 0;
+
+        if (action == replication_action::invalid &&
+            !write_completed)
+        {
+            continue;
+        }
+
+        std::string directory_path;
+
+        for (const fanotify_source& fanotify_source : m_fanotify_sources)
+        {
+            if (std::memcmp(&fanotify_source.m_filesystem_identifier, &event_info->fsid, sizeof(event_info->fsid)) != 0)
+            {
+                continue;
+            }
+
+            if (directory_path.empty())
+            {
+                directory_path = resolve_fanotify_directory_path(
+                    fanotify_source.m_mount_file_descriptor,
+                    directory_file_handle);
+
+                if (directory_path.empty())
+                {
+                    //
+                    // The directory is gone or is not reachable anymore.
+                    //
+                    break;
+                }
+            }
+
+            //
+            // The mark covers the whole filesystem; only objects under the source directory are replicated.
+            //
+            const bool source_directory_event = directory_path == fanotify_source.m_path;
+
+            if (!source_directory_event &&
+                !(directory_path.starts_with(fanotify_source.m_path) && directory_path[fanotify_source.m_path.size()] == '/'))
+            {
+                continue;
+            }
+
+            std::string* relative_path = append_filesystem_event(
+                p_inotify_shard,
+                fanotify_source.m_routing_watch_descriptor,
+                action,
+                write_completed);
+
+            if (!source_directory_event)
+            {
+                relative_path->append(directory_path, fanotify_source.m_path.size() + 1);
+                relative_path->push_back('/');
+            }
+
+            relative_path->append(filesystem_object_name);
+
+            if ((fanotify_filesystem_event.mask & FAN_MOVED_TO) &&
+                (fanotify_filesystem_event.mask & FAN_ONDIR))
+            {
+                //
+                // A directory moved into place brings its whole tree along in a single event, while the target directories
+                // only create the directory itself, so everything nested under it is published as created too. The tree is
+                // walked right away, before a later rename can take it elsewhere. When the event merged a removal, the
+                // directory is published as created again after it, so the removal does not win over the moved-in tree.
+                //
+                publish_fanotify_directory_tree(
+                    p_inotify_shard,
+                    fanotify_source.m_routing_watch_descriptor,
+                    fanotify_source.m_path,
+                    source_directory_event ?
+                        std::string(filesystem_object_name) :
+                        std::format("{}/{}", std::string_view(directory_path).substr(fanotify_source.m_path.size() + 1), filesystem_object_name),
+                    action == replication_action::remove);
+            }
+        }
+    }
+}
+
+void
+filesystem_monitor::publish_fanotify_directory_tree(
+    inotify_shard& p_inotify_shard,
+    const file_descriptor p_routing_watch_descriptor,
+    const std::string& p_source_directory_path,
+    const std::string& p_relative_directory_path,
+    const bool p_publish_directory)
+{
+    //
+    // Pending directories to be walked, relative to the source directory.
+    // An explicit stack keeps deep trees from exhausting the offloader thread stack.
+    //
+    std::vector<std::string> pending_directories {p_relative_directory_path};
+    bool publish_directory = p_publish_directory;
+
+    while (!pending_directories.empty())
+    {
+        const std::string relative_directory_path = std::move(pending_directories.back());
+        pending_directories.pop_back();
+
+        std::error_code error;
+        std::filesystem::directory_iterator directory_iterator(
+            std::format("{}/{}", p_source_directory_path, relative_directory_path),
+            error);
+
+        if (error)
+        {
+            //
+            // The directory may have been removed or moved away already, in which case its own events follow.
+            //
+            continue;
+        }
+
+        if (publish_directory)
+        {
+            append_filesystem_event(
+                p_inotify_shard,
+                p_routing_watch_descriptor,
+                replication_action::create,
+                false /* Write completed. */)->append(relative_directory_path);
+
+            publish_directory = false;
+        }
+
+        for (; !error && directory_iterator != std::filesystem::directory_iterator(); directory_iterator.increment(error))
+        {
+            std::string relative_path = std::format("{}/{}", relative_directory_path, directory_iterator->path().filename().string());
+
+            append_filesystem_event(
+                p_inotify_shard,
+                p_routing_watch_descriptor,
+                replication_action::create,
+                false /* Write completed. */)->append(relative_path);
+
+            if (directory_iterator->is_directory(error) &&
+                !directory_iterator->is_symlink(error))
+            {
+                pending_directories.push_back(std::move(relative_path));
+            }
+        }
+    }
+}
+
+void
+filesystem_monitor::handle_kernel_events_queue_overflow(
+    inotify_shard& p_inotify_shard,
+    const monitoring_backend p_monitoring_backend)
+{
+    const uint64 number_kernel_events_queue_overflows = m_number_kernel_events_queue_overflows.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    logger::log(log_level::warning, std::format("Kernel filesystem events queue overflowed; rescanning the affected source directories. "
+        "MonitoringBackend={}, NumberKernelEventsQueueOverflows={}, Status={:#X}.",
+        p_monitoring_backend == monitoring_backend::fanotify ? "fanotify" : "inotify",
+        number_kernel_events_queue_overflows,
+        status::kernel_events_queue_overflow));
+
+    if (p_monitoring_backend == monitoring_backend::fanotify)
+    {
+        //
+        // A single fanotify instance monitors every fanotify source directory, regardless of their shard.
+        //
+        for (const fanotify_source& fanotify_source : m_fanotify_sources)
+        {
+            schedule_rescan(fanotify_source.m_routing_watch_descriptor);
+        }
+
+        return;
+    }
+
+    for (const auto& [watch_descriptor, source_directory_path] : p_inotify_shard.m_source_directory_paths)
+    {
+        const file_descriptor routing_watch_descriptor = p_inotify_shard.get_routing_watch_descriptor(watch_descriptor);
+
+        const bool fanotify_monitored = std::any_of(m_fanotify_sources.begin(), m_fanotify_sources.end(), [routing_watch_descriptor](const fanotify_source& p_fanotify_source)
+        {
+            return p_fanotify_source.m_routing_watch_descriptor == routing_watch_descriptor;
+        });
+
+        if (fanotify_monitored)
+        {
+            continue;
+        }
+
+        //
+        // Directories created while events were being lost are not watched yet. Already watched
+        // directories keep their watch descriptors; the rescan covers the objects themselves.
+        //
+        watch_directory_tree(
+            p_inotify_shard,
+            watch_descriptor,
+            watch_descriptor,
+            "",
+            false /* Publish existing objects. */);
+
+        schedule_rescan(routing_watch_descriptor);
+    }
+}
+
+void
+filesystem_monitor::schedule_rescan(
+    const file_descriptor p_routing_watch_descriptor)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_rescans_lock);
+
+        auto [rescan, inserted] = m_rescans_in_progress.emplace(p_routing_watch_descriptor, false);
+
+        if (!inserted)
+        {
+            //
+            // The rescan in progress may have walked past the lost events already; run once more after it.
+            //
+            rescan->second = true;
+
+            return;
+        }
+    }
+
+    start_in_flight_replication(rescan_replication_engine(p_routing_watch_descriptor));
+}
+
+async_task<void>
+filesystem_monitor::rescan_replication_engine(
+    const file_descriptor p_routing_watch_descriptor)
+{
+    const bool scheduled = co_await m_dispatcher_thread_pool->schedule();
+
+    if (!scheduled)
+    {
+        logger::log(log_level::warning, std::format("Replication tasks dispatcher thread pool blocked rescan enqueue process. "
+            "WatchDescriptor={}, Status={:#X}.",
+            p_routing_watch_descriptor,
+            status::thread_pool_enqueue_process_failed));
+
+        std::scoped_lock<std::mutex> lock(m_rescans_lock);
+
+        m_rescans_in_progress.erase(p_routing_watch_descriptor);
+
+        co_return;
+    }
+
+    forever
+    {
+        logger::set_activity_id(m_random_identifier_generator.generate_triple_random_identifier());
+
+        const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+        std::vector<std::pair<std::string, replication_action>> divergent_filesystem_objects;
+
+        const status_code status = m_replication_manager->collect_divergent_filesystem_objects(
+            p_routing_watch_descriptor,
+            &divergent_filesystem_objects);
+
+        logger::log(status::succeeded(status) ? log_level::info : log_level::error, std::format("Rescan completed. "
+            "WatchDescriptor={}, NumberDivergentFilesystemObjects={}, DurationMs={}, Status={:#X}.",
+            p_routing_watch_descriptor,
+            divergent_filesystem_objects.size(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count(),
+            status));
+
+        if (!divergent_filesystem_objects.empty())
+        {
+            //
+            // Only the divergent filesystem objects are replicated, through the same path as the live filesystem events.
+            //
+            replication_tasks_batch divergent_replication_tasks;
+            divergent_replication_tasks.reserve(divergent_filesystem_objects.size());
+
+            for (const std::pair<std::string, replication_action>& divergent_filesystem_object : divergent_filesystem_objects)
+            {
+                divergent_replication_tasks.push_back(std::make_unique<replication_task>(
+                    divergent_filesystem_object.second,
+                    divergent_filesystem_object.first,
+                    m_random_identifier_generator.generate_triple_random_identifier()));
+            }
+
+            co_await m_replication_manager->replication_tasks_entry_point(
+                p_routing_watch_descriptor,
+                std::move(divergent_replication_tasks),
+                m_replication_manager->reserve_submission_turn(p_routing_watch_descriptor));
+        }
+
+        std::scoped_lock<std::mutex> lock(m_rescans_lock);
+
+        auto rescan = m_rescans_in_progress.find(p_routing_watch_descriptor);
+
+        if (rescan == m_rescans_in_progress.end() ||
+            !rescan->second)
+        {
+            if (rescan != m_rescans_in_progress.end())
+            {
+                m_rescans_in_progress.erase(rescan);
+            }
+
+            break;
+        }
+
+        rescan->second = false;
+    }
+
+    logger::reset_activity_id();
+}
+
+std::string
+filesystem_monitor::resolve_fanotify_directory_path(
+    const file_descriptor p_mount_file_descriptor,
+    file_handle* p_directory_file_handle)
+{
+    file_descriptor directory_file_descriptor = open_by_handle_at(
+        p_mount_file_descriptor,
+        p_directory_file_handle,
+        O_PATH | O_CLOEXEC);
+
+    if (!utilities::is_file_descriptor_valid(directory_file_descriptor))
+    {
+        return "";
+    }
+
+    character directory_path[PATH_MAX];
+
+    const ssize_t directory_path_length = readlink(
+        std::format("/proc/self/fd/{}", directory_file_descriptor).c_str(),
+        directory_path,
+        sizeof(directory_path));
+
+    close(directory_file_descriptor);
+
+    if (directory_path_length <= 0 ||
+        directory_path_length == sizeof(directory_path))
+    {
+        return "";
+    }
+
+    return std::string(directory_path, directory_path_length);
+}
+
+uint64
+filesystem_monitor::get_filesystem_events_queue_depth() const
+{
+    return m_number_queued_filesystem_events.load(std::memory_order_relaxed);
+}
+
+uint64
+filesystem_monitor::get_max_filesystem_events_queue_depth() const
+{
+    return m_max_filesystem_events_queue_depth.load(std::memory_order_relaxed);
+}
+
+uint64
+filesystem_monitor::get_number_kernel_events_queue_overflows() const
+{
+    return m_number_kernel_events_queue_overflows.load(std::memory_order_relaxed);
+}
+
+uint64
+filesystem_monitor::get_number_deferred_dispatches() const
+{
+    return m_number_deferred_dispatches.load(std::memory_order_relaxed);
+}
+
+double_precision
+filesystem_monitor::get_coalescing_ratio() const
+{
+    const uint64 number_dispatched_replication_tasks = m_number_dispatched_replication_tasks.load(std::memory_order_relaxed);
+
+    if (number_dispatched_replication_tasks == 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double_precision>(m_number_received_filesystem_events.load(std::memory_order_relaxed)) /
+        number_dispatched_replication_tasks;
+}
+
+void
+filesystem_monitor::coalesce_filesystem_event(
+    const filesystem_events_batch::entry& p_filesystem_event,
+    const std::string_view p_filesystem_object_name,
+    const std::chrono::steady_clock::time_point p_current_time)
+{
+    const std::string& pending_filesystem_event_key = build_pending_filesystem_event_key(
+        p_filesystem_event.m_watch_descriptor,
+        p_filesystem_object_name);
+
+    auto pending_filesystem_event_index = m_pending_filesystem_events_index.find(pending_filesystem_event_key);
+
+    if (pending_filesystem_event_index == m_pending_filesystem_events_index.end())
+    {
+        if (p_filesystem_event.m_replication_action == replication_action::invalid)
+        {
+            //
+            // A close without pending changes; the object was either left untouched or already replicated.
+            //
+            return;
+        }
+
+        //
+        // Only filesystem objects without a pending filesystem event get their own copy of the name.
+        //
+        auto coalescing_window = m_coalescing_windows.find(p_filesystem_event.m_watch_descriptor);
+
+        pending_filesystem_event& pending_event = m_pending_filesystem_events.emplace_back();
+        pending_event.m_filesystem_event.m_watch_descriptor = p_filesystem_event.m_watch_descriptor;
+        pending_event.m_filesystem_event.m_replication_action = p_filesystem_event.m_replication_action;
+        pending_event.m_filesystem_event.m_filesystem_object_name = p_filesystem_object_name;
+        pending_event.m_filesystem_event.m_write_completed = p_filesystem_event.m_write_completed;
+        pending_event.m_first_event_time = p_current_time;
+        pending_event.m_last_event_time = p_current_time;
+        pending_event.m_coalescing_window = coalescing_window == m_coalescing_windows.end() ?
+            std::chrono::milliseconds(0) :
+            coalescing_window->second;
+
+        m_pending_filesystem_events_index.emplace(
+            pending_filesystem_event_key,
+            std::prev(m_pending_filesystem_events.end()));
+
+        return;
+    }
+
+    pending_filesystem_event& pending_event = *pending_filesystem_event_index->second;
+    filesystem_event& coalesced_event = pending_event.m_filesystem_event;
+    const replication_action pending_action = coalesced_event.m_replication_action;
+    const replication_action fetched_action = p_filesystem_event.m_replication_action;
+
+    pending_event.m_last_event_time = p_current_time;
+    coalesced_event.m_write_completed = p_filesystem_event.m_write_completed;
+
+    if (pending_action == replication_action::move &&
+        fetched_action == replication_action::remove)
+    {
+        //
+        // The moved object is gone; the target directories still hold it under its previous name.
+        //
+        const std::string previous_filesystem_object_name = std::move(coalesced_event.m_previous_filesystem_object_name);
+
+        m_pending_filesystem_events.erase(pending_filesystem_event_index->second);
+        m_pending_filesystem_events_index.erase(pending_filesystem_event_index);
+
+        coalesce_filesystem_event(
+            p_filesystem_event,
+            previous_filesystem_object_name,
+            p_current_time);
+
+        return;
+    }
+
+    if (pending_action == replication_action::create &&
+        fetched_action == replication_action::remove)
+    {
+        //
+        // The object came and went within the window; the target directory never needs to see it.
+        //
+        m_pending_filesystem_events.erase(pending_filesystem_event_index->second);
+        m_pending_filesystem_events_index.erase(pending_filesystem_event_index);
+
+        return;
+    }
+
+    if (fetched_action == replication_action::remove ||
+        (pending_action == replication_action::remove && fetched_action == replication_action::create))
+    {
+        //
+        // Removals supersede any pending change, and a recreated object replaces the removed one.
+        //
+        coalesced_event.m_replication_action = fetched_action;
+    }
+    else if (pending_action == replication_action::remove &&
+        fetched_action == replication_action::update)
+    {
+        //
+        // The removed object reappeared before its removal was dispatched.
+        //
+        coalesced_event.m_replication_action = replication_action::create;
+    }
+
+    //
+    // Any other update folds into the pending create or update.
+    //
+}
+
+void
+filesystem_monitor::coalesce_moved_filesystem_event(
+    const file_descriptor p_watch_descriptor,
+    const std::string_view p_filesystem_object_name,
+    const std::string_view p_previous_filesystem_object_name,
+    const std::chrono::steady_clock::time_point p_current_time)
+{
+    replication_action action = replication_action::move;
+    std::string previous_filesystem_object_name(p_previous_filesystem_object_name);
+
+    auto previous_pending_filesystem_event_index = m_pending_filesystem_events_index.find(build_pending_filesystem_event_key(
+        p_watch_descriptor,
+        p_previous_filesystem_object_name));
+
+    if (previous_pending_filesystem_event_index != m_pending_filesystem_events_index.end())
+    {
+        filesystem_event& previous_pending_event = previous_pending_filesystem_event_index->second->m_filesystem_event;
+        const replication_action previous_pending_action = previous_pending_event.m_replication_action;
+
+        if (previous_pending_action == replication_action::create)
+        {
+            //
+            // The object never reached the target directories; it is created under its new name instead.
+            //
+            action = replication_action::create;
+        }
+        else if (previous_pending_action == replication_action::move)
+        {
+            //
+            // Chained renames collapse into a single rename from the name known to the target directories.
+            //
+            previous_filesystem_object_name = std::move(previous_pending_event.m_previous_filesystem_object_name);
+        }
+
+        //
+        // Pending updates are reconciled by the replication engine once the object is renamed.
+        //
+        if (previous_pending_action != replication_action::remove)
+        {
+            m_pending_filesystem_events.erase(previous_pending_filesystem_event_index->second);
+            m_pending_filesystem_events_index.erase(previous_pending_filesystem_event_index);
+        }
+    }
+
+    const std::string& pending_filesystem_event_key = build_pending_filesystem_event_key(
+        p_watch_descriptor,
+        p_filesystem_object_name);
+
+    auto pending_filesystem_event_index = m_pending_filesystem_events_index.find(pending_filesystem_event_key);
+
+    if (pending_filesystem_event_index == m_pending_filesystem_events_index.end())
+    {
+        auto coalescing_window = m_coalescing_windows.find(p_watch_descriptor);
+
+        pending_filesystem_event& pending_event = m_pending_filesystem_events.emplace_back();
+        pending_event.m_filesystem_event.m_watch_descriptor = p_watch_descriptor;
+        pending_event.m_filesystem_event.m_filesystem_object_name = p_filesystem_object_name;
+        pending_event.m_first_event_time = p_current_time;
+        pending_event.m_coalescing_window = coalescing_window == m_coalescing_windows.end() ?
+            std::chrono::milliseconds(0) :
+            coalescing_window->second;
+
+        pending_filesystem_event_index = m_pending_filesystem_events_index.emplace(
+            pending_filesystem_event_key,
+            std::prev(m_pending_filesystem_events.end())).first;
+    }
+
+    //
+    // The rename replaces whatever was pending under the new name.
+    //
+    pending_filesystem_event& pending_event = *pending_filesystem_event_index->second;
+    pending_event.m_filesystem_event.m_replication_action = action;
+    pending_event.m_filesystem_event.m_previous_filesystem_object_name = action == replication_action::move ?
+        std::move(previous_filesystem_object_name) :
+        std::string();
+    pending_event.m_filesystem_event.m_write_completed = true;
+    pending_event.m_last_event_time = p_current_time;
+}
+
+std::chrono::steady_clock::time_point
+filesystem_monitor::flush_ready_filesystem_events(
+    const std::chrono::steady_clock::time_point p_current_time,
+    std::queue<filesystem_event>* p_filesystem_events_batching_queue)
+{
+    std::chrono::steady_clock::time_point next_ready_time = std::chrono::steady_clock::time_point::max();
+
+    auto pending_filesystem_event = m_pending_filesystem_events.begin();
+
+    while (pending_filesystem_event != m_pending_filesystem_events.end())
+    {
+        //
+        // Events are released once their writer closes the object, once the object stays quiet for a whole
+        // window, or once the first coalesced event gets too old to keep holding back its replication.
+        //
+        const std::chrono::steady_clock::time_point ready_time = pending_filesystem_event->m_filesystem_event.m_write_completed ?
+            pending_filesystem_event->m_last_event_time :
+            std::min(
+                pending_filesystem_event->m_last_event_time + pending_filesystem_event->m_coalescing_window,
+                pending_filesystem_event->m_first_event_time + pending_filesystem_event->m_coalescing_window * c_max_coalescing_delay_factor);
+
+        if (ready_time > p_current_time)
+        {
+            next_ready_time = std::min(next_ready_time, ready_time);
+
+            ++pending_filesystem_event;
+
+            continue;
+        }
+
+        m_pending_filesystem_events_index.erase(build_pending_filesystem_event_key(
+            pending_filesystem_event->m_filesystem_event.m_watch_descriptor,
+            pending_filesystem_event->m_filesystem_event.m_filesystem_object_name));
+
+        p_filesystem_events_batching_queue->push(std::move(pending_filesystem_event->m_filesystem_event));
+
+        m_number_dispatched_replication_tasks.fetch_add(1, std::memory_order_relaxed);
+
+        pending_filesystem_event = m_pending_filesystem_events.erase(pending_filesystem_event);
+    }
+
+    return next_ready_time;
+}
+
+const std::string&
+filesystem_monitor::build_pending_filesystem_event_key(
+    const file_descriptor p_watch_descriptor,
+    const std::string_view p_filesystem_object_name)
+{
+    m_pending_filesystem_event_key.clear();
+
+    std::format_to(
+        std::back_inserter(m_pending_filesystem_event_key),
+        "{}/{}",
+        p_watch_descriptor,
+        p_filesystem_object_name);
+
+    return m_pending_filesystem_event_key;
+}
+
+std::string*
+filesystem_monitor::append_filesystem_event(
+    inotify_shard& p_inotify_shard,
+    const file_descriptor p_watch_descriptor,
+    const replication_action p_replication_action,
+    const bool p_write_completed,
+    const std::string_view p_previous_filesystem_object_name)
+{
+    if (p_inotify_shard.m_offloading_batch->get_size() >= c_max_filesystem_events_per_batch)
+    {
+        publish_filesystem_events_batch(p_inotify_shard);
+    }
+
+    if (p_replication_action == replication_action::move)
+    {
+        return p_inotify_shard.m_offloading_batch->append_move(
+            p_watch_descriptor,
+            p_previous_filesystem_object_name);
+    }
+
+    return p_inotify_shard.m_offloading_batch->append(
+        p_watch_descriptor,
+        p_replication_action,
+        p_write_completed);
+}
+
+void
+filesystem_monitor::publish_filesystem_events_batch(
+    inotify_shard& p_inotify_shard)
+{
+    if (p_inotify_shard.m_offloading_batch->is_empty())
+    {
+        return;
+    }
+
+    //
+    // Account for the events before publishing them so that the dispatcher never observes a negative depth.
+    //
+    const uint64 queue_depth = m_number_queued_filesystem_events.fetch_add(p_inotify_shard.m_offloading_batch->get_size(), std::memory_order_relaxed) +
+        p_inotify_shard.m_offloading_batch->get_size();
+
+    bool queue_full_reported = false;
+
+    while (!p_inotify_shard.m_filesystem_events_queue.try_push(std::move(p_inotify_shard.m_offloading_batch)))
+    {
+        if (!queue_full_reported)
+        {
+            queue_full_reported = true;
+
+            logger::log(log_level::warning, std::format("Filesystem events queue is full; waiting for the replication tasks dispatcher. "
+                "InotifyShardIndex={}, QueueCapacity={}, QueueDepth={}.",
+                p_inotify_shard.m_shard_index,
+                p_inotify_shard.m_filesystem_events_queue.get_capacity(),
+                queue_depth));
+        }
+
+        notify_replication_tasks_dispatcher();
+
+        std::this_thread::yield();
+    }
+
+    //
+    // The offloaders of every shard publish concurrently; only a deeper queue replaces the observed max.
+    //
+    uint64 max_queue_depth = m_max_filesystem_events_queue_depth.load(std::memory_order_relaxed);
+
+    while (queue_depth > max_queue_depth &&
+        !m_max_filesystem_events_queue_depth.compare_exchange_weak(max_queue_depth, queue_depth, std::memory_order_relaxed))
+    {}
+
+    //
+    // Continue on a recycled batch; a new batch is only allocated while the recycled batches are still in flight.
+    //
+    if (!p_inotify_shard.m_recycled_filesystem_events_batches.try_pop(&p_inotify_shard.m_offloading_batch))
+    {
+        p_inotify_shard.m_offloading_batch = std::make_unique<filesystem_events_batch>();
+    }
+
+    notify_replication_tasks_dispatcher();
+}
+
+void
+filesystem_monitor::notify_replication_tasks_dispatcher()
+{
+    const uint64 notification = 1;
+
+    if (write(m_filesystem_events_notification_handle, &notification, sizeof(notification)) != sizeof(notification) &&
+        errno != EAGAIN)
+    {
+        logger::log(log_level::error, std::format("Failed to notify the replication tasks dispatcher. {} (errno {}).",
+            std::strerror(errno),
+            errno));
+    }
+}
+
+bool
+filesystem_monitor::is_dispatch_backpressured()
+{
+    if (m_dispatcher_thread_pool->is_saturated() ||
+        m_replication_manager->get_replication_tasks_thread_pool()->is_saturated())
+    {
+        return true;
+    }
+
+    //
+    // Batches waiting on a lock, an executor, a scheduler lane or io_uring transfers are suspended off the thread pools and invisible to their queues.
+    //
+    const uint32 max_number_in_flight_replications = m_replication_manager->get_max_number_in_flight_replications();
+
+    return max_number_in_flight_replications != 0 &&
+        get_number_in_flight_replications() >= max_number_in_flight_replications;
+}
+
+uint64
+filesystem_monitor::get_number_in_flight_replications()
+{
+    std::scoped_lock<std::mutex> lock(m_in_flight_replications_lock);
+
+    return m_number_in_flight_replications;
+}
+
+void
+filesystem_monitor::replication_tasks_dispatcher()
+{
+    logger::log(log_level::info, "Starting replication tasks dispatcher thread.");
+
+    std::queue<filesystem_event> filesystem_events_batching_queue;
+    bool dispatch_deferred = false;
 
     forever
     {
@@ -393,25 +2010,194 @@ filesystem_monitor::replication_tasks_dispatcher()
             break;
         }
 
+        //
+        // Fetch filesystem events from the shard queues and coalesce them per filesystem object
+        // until they are ready to be moved into the batch-processing queue for a synchronous
+        // thread-pool assignment operation.
+        //
+        const uint64 queue_depth = get_filesystem_events_queue_depth();
+        const std::chrono::steady_clock::time_point fetch_time = std::chrono::steady_clock::now();
+        uint32 number_fetched_filesystem_events = 0;
+        std::unique_ptr<filesystem_events_batch> fetched_filesystem_events_batch;
+
+        //
+        // Batches are fetched round-robin across the shards so that a busy shard does not starve the others.
+        //
+        bool filesystem_events_batch_fetched = true;
+
+        while (number_fetched_filesystem_events < c_max_number_fetched_filesystem_events &&
+            filesystem_events_batch_fetched)
+        {
+            filesystem_events_batch_fetched = false;
+
+            for (const std::unique_ptr<inotify_shard>& shard : m_inotify_shards)
+            {
+                if (!shard->m_filesystem_events_queue.try_pop(&fetched_filesystem_events_batch))
+                {
+                    continue;
+                }
+
+                filesystem_events_batch_fetched = true;
+
+                const uint32 filesystem_events_batch_size = fetched_filesystem_events_batch->get_size();
+
+                for (uint32 entry_index = 0; entry_index < filesystem_events_batch_size; ++entry_index)
+                {
+                    const filesystem_events_batch::entry& fetched_filesystem_event = fetched_filesystem_events_batch->get_entry(entry_index);
+
+                    if (fetched_filesystem_event.m_replication_action == replication_action::move)
+                    {
+                        coalesce_moved_filesystem_event(
+                            fetched_filesystem_event.m_watch_descriptor,
+                            fetched_filesystem_events_batch->get_filesystem_object_name(fetched_filesystem_event),
+                            fetched_filesystem_events_batch->get_previous_filesystem_object_name(fetched_filesystem_event),
+                            fetch_time);
+
+                        continue;
+                    }
+
+                    coalesce_filesystem_event(
+                        fetched_filesystem_event,
+                        fetched_filesystem_events_batch->get_filesystem_object_name(fetched_filesystem_event),
+                        fetch_time);
+                }
+
+                m_number_received_filesystem_events.fetch_add(filesystem_events_batch_size, std::memory_order_relaxed);
+                m_number_queued_filesystem_events.fetch_sub(filesystem_events_batch_size, std::memory_order_relaxed);
+                number_fetched_filesystem_events += filesystem_events_batch_size;
+
+                //
+                // Hand the consumed batch back to the offloader; it is released instead when the recycling queue is full.
+                //
+                fetched_filesystem_events_batch->clear();
+                shard->m_recycled_filesystem_events_batches.try_push(std::move(fetched_filesystem_events_batch));
+            }
+        }
+
+        const std::shared_ptr<thread_pool>& replication_tasks_thread_pool = m_replication_manager->get_replication_tasks_thread_pool();
+        std::chrono::steady_clock::time_point next_ready_time;
+
+        if (is_dispatch_backpressured())
+        {
+            //
+            // Ready filesystem events are held back in the pending filesystem events, where further events on the same
+            // filesystem objects keep coalescing into them, until the thread pools drain below their capacity.
+            //
+            if (!dispatch_deferred)
+            {
+                dispatch_deferred = true;
+
+                const uint64 number_deferred_dispatches = m_number_deferred_dispatches.fetch_add(1, std::memory_order_relaxed) + 1;
+
+                logger::log(log_level::warning, std::format("Deferring filesystem events dispatch on saturated thread pools or in-flight replications. "
+                    "NumberPendingFilesystemEvents={}, DispatcherQueuedTasks={}, ReplicationQueuedTasks={}, NumberInFlightReplications={}, "
+                    "NumberDeferredDispatches={}.",
+                    m_pending_filesystem_events.size(),
+                    m_dispatcher_thread_pool->get_number_queued_tasks(),
+                    replication_tasks_thread_pool->get_number_queued_tasks(),
+                    get_number_in_flight_replications(),
+                    number_deferred_dispatches));
+            }
+
+            next_ready_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(c_backpressure_retry_interval_ms);
+        }
+        else
+        {
+            if (dispatch_deferred)
+            {
+                dispatch_deferred = false;
+
+                logger::log(log_level::info, std::format("Resuming filesystem events dispatch. NumberPendingFilesystemEvents={}.",
+                    m_pending_filesystem_events.size()));
+            }
+
+            next_ready_time = flush_ready_filesystem_events(
+                std::chrono::steady_clock::now(),
+                &filesystem_events_batching_queue);
+        }
+
+        if (number_fetched_filesystem_events == 0 &&
+            filesystem_events_batching_queue.empty())
         {
             //
-            // Fetch filesystem events from the shared queue and transfer them to a
-            // batch-processing queue for a synchronous thread-pool assignment operation.
+            // Block until the kernel events offloader publishes new filesystem events, the next pending filesystem
+            // event becomes ready or the system is terminated. Events published after the queue was found empty
+            // always leave a pending notification behind.
             //
-            std::scoped_lock<std::mutex> lock(m_filesystem_events_queue_lock);
+            int32 wait_timeout_ms = -1;
+
+            if (next_ready_time != std::chrono::steady_clock::time_point::max())
+            {
+                wait_timeout_ms = static_cast<int32>(std::chrono::ceil<std::chrono::milliseconds>(
+                    next_ready_time - std::chrono::steady_clock::now()).count());
+
+                wait_timeout_ms = std::max(wait_timeout_ms, 0);
+            }
+
+            pollfd notification_poll {m_filesystem_events_notification_handle, POLLIN, 0};
 
-            uint16 number_fetched_filesystem_events = 0;
+            const int32 number_ready_handles = poll(&notification_poll, 1, wait_timeout_ms);
 
-            while (!m_filesystem_events_queue.empty() && number_fetched_filesystem_events < c_max_number_fetched_filesystem_events)
+            if (number_ready_handles < 0 &&
+                errno != EINTR)
             {
-                filesystem_events_batching_queue.push(m_filesystem_events_queue.front());
+                logger::log(log_level::critical, std::format("Failed to wait for filesystem events notifications. {} (errno {}).",
+                    std::strerror(errno),
+                    errno));
+
+                break;
+            }
 
-                m_filesystem_events_queue.pop();
+            if (number_ready_handles > 0)
+            {
+                uint64 number_notifications = 0;
 
-                ++number_fetched_filesystem_events;
+                read(m_filesystem_events_notification_handle, &number_notifications, sizeof(number_notifications));
             }
+
+            continue;
+        }
+
+        if (filesystem_events_batching_queue.empty())
+        {
+            //
+            // All fetched filesystem events are still within their coalescing window.
+            //
+            continue;
         }
 
+        logger::log(log_level::info, std::format("Dispatching filesystem events batch. NumberFetchedFilesystemEvents={}, NumberReadyFilesystemEvents={}, "
+            "NumberPendingFilesystemEvents={}, QueueDepth={}, MaxQueueDepth={}, CoalescingRatio={:.2f}, "
+            "DispatcherActiveThreads={}, DispatcherIdleThreads={}, DispatcherThreads={}, DispatcherQueuedTasks={}, "
+            "DispatcherRejectedTasks={}, DispatcherBlockedSubmissions={}, ReplicationActiveThreads={}, ReplicationIdleThreads={}, "
+            "ReplicationThreads={}, ReplicationQueuedTasks={}, ReplicationRejectedTasks={}, ReplicationBlockedSubmissions={}, "
+            "NumberDeferredDispatches={}.",
+            number_fetched_filesystem_events,
+            filesystem_events_batching_queue.size(),
+            m_pending_filesystem_events.size(),
+            queue_depth,
+            get_max_filesystem_events_queue_depth(),
+            get_coalescing_ratio(),
+            m_dispatcher_thread_pool->get_number_active_threads(),
+            m_dispatcher_thread_pool->get_number_idle_threads(),
+            m_dispatcher_thread_pool->get_number_threads(),
+            m_dispatcher_thread_pool->get_number_queued_tasks(),
+            m_dispatcher_thread_pool->get_number_rejected_tasks(),
+            m_dispatcher_thread_pool->get_number_blocked_submissions(),
+            replication_tasks_thread_pool->get_number_active_threads(),
+            replication_tasks_thread_pool->get_number_idle_threads(),
+            replication_tasks_thread_pool->get_number_threads(),
+            replication_tasks_thread_pool->get_number_queued_tasks(),
+            replication_tasks_thread_pool->get_number_rejected_tasks(),
+            replication_tasks_thread_pool->get_number_blocked_submissions(),
+            get_number_deferred_dispatches()));
+
+        //
+        // Group the replication tasks of the batching window by watch descriptor so that each
+        // replication engine receives them as a single batch and can coalesce their transfers.
+        //
+        std::unordered_map<file_descriptor, replication_tasks_batch> replication_tasks_batches;
+
         while (!filesystem_events_batching_queue.empty())
         {
             const filesystem_event& current_filesystem_event = filesystem_events_batching_queue.front();
@@ -426,44 +2212,35 @@ filesystem_monitor::replication_tasks_dispatcher()
             std::unique_ptr<replication_task> current_replication_task = std::make_unique<replication_task>(
                 current_filesystem_event.m_replication_action,
                 current_filesystem_event.m_filesystem_object_name,
-                activity_id);
+                activity_id,
+                current_filesystem_event.m_previous_filesystem_object_name);
 
             //
             // Remove event from the queue in a bathching model.
             //
             filesystem_events_batching_queue.pop();
 
-            logger::log(log_level::info, std::format("Created replication task. FilesystemObjectName={}, ReplicationAction={}, WatchDescriptor={}, CreationTime={}.",
+            logger::log(log_level::info, std::format("Created replication task. FilesystemObjectName={}, PreviousFilesystemObjectName={}, ReplicationAction={}, WatchDescriptor={}, CreationTime={}.",
                 current_replication_task->get_filesystem_object_name(),
+                current_replication_task->get_previous_filesystem_object_name(),
                 static_cast<uint8>(current_replication_task->get_replication_action()),
                 watch_descriptor,
                 current_replication_task->get_creation_time().to_string()));
 
+            replication_tasks_batches[watch_descriptor].push_back(std::move(current_replication_task));
+        }
+
+        for (std::pair<const file_descriptor, replication_tasks_batch>& replication_tasks_batch : replication_tasks_batches)
+        {
+            const file_descriptor watch_descriptor = replication_tasks_batch.first;
+
             //
-            // Enqueue the replication task in the thread pool for asynchronous execution and ownership transfer.
+            // Start the replication tasks batch on the dispatcher thread pool for asynchronous execution and ownership transfer.
             //
-            std::optional<std::future<void>> enqueue_status = m_dispatcher_thread_pool->enqueue_task(
-                [this, watch_descriptor, replication_task = std::move(current_replication_task)]() mutable
-                {
-                    this->m_replication_manager->replication_tasks_entry_point(
-                        watch_descriptor,
-                        std::move(replication_task));
-                }
-            );
-
-            if (enqueue_status == std::nullopt)
-            {
-                logger::log(log_level::warning, std::format("Replication tasks dispatcher thread pool blocked replication task enqueue process. "
-                    "Status={:#X}.",
-                    status::thread_pool_enqueue_process_failed));
-            }
+            start_in_flight_replication(dispatch_replication_tasks_batch(
+                watch_descriptor,
+                std::move(replication_tasks_batch.second)));
         }
-
-        //
-        // Use a polling-sleep mechanism to reduce lock blockage induced by the tasks dispatcher;
-        // the kernel offloader should always have a higher priority for offloading kernel events.
-        //
-        std::this_thread::sleep_for(std::chrono::milliseconds(c_replication_tasks_dispatcher_polling_sleep_ms));
     }
 
     logger::reset_activity_id();
@@ -471,4 +2248,60 @@ filesystem_monitor::replication_tasks_dispatcher()
     logger::log(log_level::info, "Finishing replication tasks dispatcher thread.");
 }
 
+void
+filesystem_monitor::start_in_flight_replication(
+    async_task<void>&& p_replication)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_in_flight_replications_lock);
+
+        ++m_number_in_flight_replications;
+    }
+
+    start_detached(run_in_flight_replication(std::move(p_replication)));
+}
+
+async_task<void>
+filesystem_monitor::run_in_flight_replication(
+    async_task<void> p_replication)
+{
+    co_await std::move(p_replication);
+
+    std::scoped_lock<std::mutex> lock(m_in_flight_replications_lock);
+
+    if (--m_number_in_flight_replications == 0)
+    {
+        m_in_flight_replications_condition.notify_all();
+    }
+}
+
+async_task<void>
+filesystem_monitor::dispatch_replication_tasks_batch(
+    const file_descriptor p_watch_descriptor,
+    replication_tasks_batch p_replication_tasks_batch)
+{
+    //
+    // Batches of consecutive dispatching windows may reach their replication engine in any order once on the thread pool,
+    // so their submission turn is reserved first, while still running on the dispatcher thread in dispatch order.
+    //
+    async_mutex_turn submission_turn = m_replication_manager->reserve_submission_turn(p_watch_descriptor);
+
+    const bool scheduled = co_await m_dispatcher_thread_pool->schedule();
+
+    if (!scheduled)
+    {
+        logger::log(log_level::warning, std::format("Replication tasks dispatcher thread pool blocked replication tasks batch enqueue process. "
+            "WatchDescriptor={}, Status={:#X}.",
+            p_watch_descriptor,
+            status::thread_pool_enqueue_process_failed));
+
+        co_return;
+    }
+
+    co_await m_replication_manager->replication_tasks_entry_point(
+        p_watch_descriptor,
+        std::move(p_replication_tasks_batch),
+        std::move(submission_turn));
+}
+
 } // namespace modula.
@@ -12,23 +12,35 @@
 #include "utilities.hh"
 #include "thread_pool.hh"
 #include "replication_task.hh"
+#include "spsc_ring_buffer.hh"
 #include "replication_manager.hh"
+#include "watch_descriptor_index.hh"
+#include "filesystem_events_batch.hh"
 #include "random_identifier_generator.hh"
 
+#include <list>
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <thread>
 #include <memory>
 #include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <condition_variable>
+#include <fcntl.h>
 #include <sys/inotify.h>
+#include <linux/fanotify.h>
 
 namespace modula
 {
 
 //
-// Lightweight filesystem event interface for deep copies of inotify events
-// needed for copying from the internal kernel queue to the user-space queue.
+// Lightweight filesystem event interface for the filesystem events held by the replication
+// tasks dispatcher while their coalescing window is open. Offloaded filesystem events travel
+// in filesystem events batches instead and only get their own copy once they become pending.
 //
 struct filesystem_event
 {
@@ -53,6 +65,18 @@ struct filesystem_event
     //
     std::string m_filesystem_object_name;
 
+    //
+    // Name of the filesystem object before being moved. Only set for move filesystem events.
+    //
+    std::string m_previous_filesystem_object_name;
+
+    //
+    // Flag for determining whether a writer closed the filesystem object. Events only
+    // reporting the close carry an invalid replication action and are never replicated
+    // on their own; they release the coalesced events of the filesystem object instead.
+    //
+    bool m_write_completed;
+
 };
 
 class directory;
@@ -79,21 +103,301 @@ public:
     ~filesystem_monitor();
 
     //
-    // Starts the filesystem monitor kernel events offloader thread.
+    // Starts the kernel events offloader threads, one per inotify shard. The first shard is offloaded
+    // on the calling thread, which returns once the system has been instructed to be terminated.
     //
     void
     start_kernel_events_offloader();
 
+    //
+    // Returns the number of offloaded filesystem events pending to be dispatched.
+    //
+    uint64
+    get_filesystem_events_queue_depth() const;
+
+    //
+    // Returns the max number of offloaded filesystem events observed pending to be dispatched.
+    //
+    uint64
+    get_max_filesystem_events_queue_depth() const;
+
+    //
+    // Returns the ratio between the filesystem events received by the dispatcher and the replication tasks created out of them.
+    //
+    double_precision
+    get_coalescing_ratio() const;
+
+    //
+    // Returns the number of times a kernel filesystem events queue overflowed and filesystem events were lost.
+    //
+    uint64
+    get_number_kernel_events_queue_overflows() const;
+
+    //
+    // Returns the number of times the dispatcher deferred ready filesystem events on saturated thread pools.
+    //
+    uint64
+    get_number_deferred_dispatches() const;
+
 private:
 
+    struct inotify_shard;
+
+    //
+    // Kernel events offloader thread of an inotify shard. Offloads the filesystem events of the inotify
+    // instance of the shard, along with the fanotify instance on the first shard, until termination.
+    //
+    void
+    run_kernel_events_offloader(
+        inotify_shard& p_inotify_shard);
+
+    //
+    // Starts the inotify and epoll instances of an inotify shard, attaching the termination signals handle to the latter.
+    //
+    status_code
+    start_inotify_shard(
+        inotify_shard& p_inotify_shard);
+
     //
     // Filesystem monitor thread that dispatches replication tasks based
     // on the filesystem events received from the kernel events offloader.
-    // Polling-and-batching mechanism is used to avoid contention from mutual exclusion.
+    // The dispatcher blocks on the filesystem events notification handle
+    // and drains the filesystem events queue in batches on every wakeup.
     //
     void
     replication_tasks_dispatcher();
 
+    //
+    // Starts a replication tasks batch or a rescan without waiting for it, accounting for it as in flight until it completes.
+    //
+    void
+    start_in_flight_replication(
+        async_task<void>&& p_replication);
+
+    //
+    // Runs an in-flight replication to completion and releases its accounting.
+    //
+    async_task<void>
+    run_in_flight_replication(
+        async_task<void> p_replication);
+
+    //
+    // Hands a replication tasks batch over to the replication manager from the dispatcher thread pool.
+    // The batch suspends instead of holding a dispatcher thread while its replication is in flight.
+    //
+    async_task<void>
+    dispatch_replication_tasks_batch(
+        const file_descriptor p_watch_descriptor,
+        replication_tasks_batch p_replication_tasks_batch);
+
+    //
+    // Drains the inotify instance of a shard until no filesystem events are left, appending them to the offloading batch of the shard.
+    //
+    void
+    offload_inotify_events(
+        inotify_shard& p_inotify_shard);
+
+    //
+    // Holds the moved-from half of a rename until its moved-to half arrives with the same cookie.
+    //
+    void
+    offload_moved_from_event(
+        inotify_shard& p_inotify_shard,
+        const inotify_event* p_inotify_event,
+        const std::string_view p_filesystem_object_name);
+
+    //
+    // Pairs the moved-to half of a rename with its pending moved-from half into a move filesystem event.
+    // Renames across source directories fall back to a removal and a creation, and objects moved in from
+    // outside any source directory are created, along with anything nested under moved-in directories.
+    //
+    void
+    offload_moved_to_event(
+        inotify_shard& p_inotify_shard,
+        const inotify_event* p_inotify_event,
+        const std::string_view p_filesystem_object_name);
+
+    //
+    // Falls back to removals for the moved-from halves whose moved-to half did not arrive within the pairing timeout,
+    // which is the case for objects moved out of every source directory.
+    //
+    void
+    expire_pending_moves(
+        inotify_shard& p_inotify_shard,
+        const std::chrono::steady_clock::time_point p_current_time);
+
+    //
+    // Drops the watches of a directory and of every directory nested under it.
+    //
+    void
+    unwatch_directory_tree(
+        inotify_shard& p_inotify_shard,
+        const file_descriptor p_parent_watch_descriptor,
+        const std::string_view p_directory_name);
+
+    //
+    // Watches a directory and all directories nested under it, registering them into the watch descriptor index.
+    // When requested, every object found under the directory is appended as a created filesystem event.
+    // An empty directory name walks the nested directories of the source directory itself.
+    //
+    void
+    watch_directory_tree(
+        inotify_shard& p_inotify_shard,
+        const file_descriptor p_root_watch_descriptor,
+        const file_descriptor p_parent_watch_descriptor,
+        const std::string_view p_directory_name,
+        const bool p_publish_existing_objects);
+
+    //
+    // Monitors a source directory through the fanotify instance, starting the instance on first use and
+    // marking the filesystem holding the source directory unless another source directory already did.
+    //
+    status_code
+    add_fanotify_source(
+        const std::string& p_source_directory_path,
+        const file_descriptor p_routing_watch_descriptor);
+
+    //
+    // Drains the fanotify instance until no filesystem events are left, appending them to the offloading batch.
+    //
+    void
+    offload_fanotify_events(
+        inotify_shard& p_inotify_shard);
+
+    //
+    // Appends the fanotify events held by a read event buffer to the offloading batch.
+    //
+    void
+    offload_fanotify_events_buffer(
+        inotify_shard& p_inotify_shard,
+        const byte* p_read_event_buffer,
+        const uint32 p_number_bytes_read);
+
+    //
+    // Appends every object nested under a directory of a fanotify source directory as a created filesystem event.
+    // When requested, the directory itself is appended as created as well, provided it still exists.
+    //
+    void
+    publish_fanotify_directory_tree(
+        inotify_shard& p_inotify_shard,
+        const file_descriptor p_routing_watch_descriptor,
+        const std::string& p_source_directory_path,
+        const std::string& p_relative_directory_path,
+        const bool p_publish_directory);
+
+    //
+    // Recovers from lost filesystem events after a kernel filesystem events queue overflowed. Directory trees
+    // monitored through the overflowed inotify shard are watched again, and a rescan is scheduled for every source
+    // directory collected through the overflowed instance so that only the divergent filesystem objects are replicated.
+    //
+    void
+    handle_kernel_events_queue_overflow(
+        inotify_shard& p_inotify_shard,
+        const monitoring_backend p_monitoring_backend);
+
+    //
+    // Schedules a background rescan of a replication engine on the dispatcher thread pool. A rescan requested
+    // while another one is in progress for the same replication engine is folded into a single follow-up rescan.
+    //
+    void
+    schedule_rescan(
+        const file_descriptor p_routing_watch_descriptor);
+
+    //
+    // Rescans a replication engine and hands its divergent filesystem objects over as a replication tasks batch.
+    // Runs on the dispatcher thread pool, concurrently with the live filesystem events.
+    //
+    async_task<void>
+    rescan_replication_engine(
+        const file_descriptor p_routing_watch_descriptor);
+
+    //
+    // Resolves the file handle of a directory reported by fanotify into its current path.
+    // Returns an empty path when the directory cannot be opened anymore.
+    //
+    static
+    std::string
+    resolve_fanotify_directory_path(
+        const file_descriptor p_mount_file_descriptor,
+        file_handle* p_directory_file_handle);
+
+    //
+    // Merges a fetched filesystem event into the pending filesystem event of the same filesystem object.
+    //
+    void
+    coalesce_filesystem_event(
+        const filesystem_events_batch::entry& p_filesystem_event,
+        const std::string_view p_filesystem_object_name,
+        const std::chrono::steady_clock::time_point p_current_time);
+
+    //
+    // Merges a fetched move filesystem event into the pending filesystem events of its previous and new names.
+    //
+    void
+    coalesce_moved_filesystem_event(
+        const file_descriptor p_watch_descriptor,
+        const std::string_view p_filesystem_object_name,
+        const std::string_view p_previous_filesystem_object_name,
+        const std::chrono::steady_clock::time_point p_current_time);
+
+    //
+    // Builds the key of a pending filesystem event into the reusable pending filesystem event key buffer.
+    //
+    const std::string&
+    build_pending_filesystem_event_key(
+        const file_descriptor p_watch_descriptor,
+        const std::string_view p_filesystem_object_name);
+
+    //
+    // Moves the pending filesystem events whose coalescing window elapsed, or whose writer completed, into the batching queue.
+    // Returns the time at which the next pending filesystem event becomes ready, or the max time point when none is pending.
+    //
+    std::chrono::steady_clock::time_point
+    flush_ready_filesystem_events(
+        const std::chrono::steady_clock::time_point p_current_time,
+        std::queue<filesystem_event>* p_filesystem_events_batching_queue);
+
+    //
+    // Starts a new filesystem event in the offloading batch and returns the names arena through which its
+    // filesystem object name is appended. A full offloading batch is published before the event is started.
+    // Move filesystem events carry the previous filesystem object name as well.
+    //
+    std::string*
+    append_filesystem_event(
+        inotify_shard& p_inotify_shard,
+        const file_descriptor p_watch_descriptor,
+        const replication_action p_replication_action,
+        const bool p_write_completed,
+        const std::string_view p_previous_filesystem_object_name = "");
+
+    //
+    // Publishes the offloading batch into the filesystem events queue and awakens the dispatcher, replacing it
+    // with a recycled batch. When the queue is full, the dispatcher is awakened and the offloader waits for free
+    // slots instead of dropping the batch. Empty offloading batches are not published.
+    //
+    void
+    publish_filesystem_events_batch(
+        inotify_shard& p_inotify_shard);
+
+    //
+    // Awakens the replication tasks dispatcher.
+    //
+    void
+    notify_replication_tasks_dispatcher();
+
+    //
+    // Returns whether the dispatcher or the replication tasks thread pool reached its capacity, or the in-flight
+    // replications reached their bound, in which case ready filesystem events are held back instead of being enqueued.
+    //
+    bool
+    is_dispatch_backpressured();
+
+    //
+    // Returns the number of replication tasks batches and rescans started but not completed yet.
+    //
+    uint64
+    get_number_in_flight_replications();
+
     //
     // Thread pool for replication task dispatcher threads.
     //
@@ -105,29 +409,119 @@ private:
     std::shared_ptr<replication_manager> m_replication_manager;
 
     //
-    // Filesystem events queue for holding offloaded events.
+    // Number of offloaded filesystem events pending to be dispatched across all queued batches.
     //
-    std::queue<filesystem_event> m_filesystem_events_queue;
+    std::atomic<uint64> m_number_queued_filesystem_events;
 
     //
-    // Lock for synchronizing access to the filesystem events queue.
+    // Max number of offloaded filesystem events observed pending to be dispatched.
     //
-    std::mutex m_filesystem_events_queue_lock;
+    std::atomic<uint64> m_max_filesystem_events_queue_depth;
 
     //
-    // Random identifier generator for the replication tasks dispatcher.
+    // Eventfd handle for awakening the replication tasks dispatcher on offloaded filesystem events.
     //
-    random_identifier_generator m_random_identifier_generator;
+    file_descriptor m_filesystem_events_notification_handle;
+
+    //
+    // Filesystem event pending to be dispatched while its coalescing window is open.
+    //
+    struct pending_filesystem_event
+    {
+
+        //
+        // Coalesced filesystem event.
+        //
+        filesystem_event m_filesystem_event;
+
+        //
+        // Time of the first coalesced filesystem event.
+        //
+        std::chrono::steady_clock::time_point m_first_event_time;
+
+        //
+        // Time of the last coalesced filesystem event.
+        //
+        std::chrono::steady_clock::time_point m_last_event_time;
+
+        //
+        // Coalescing window of the source directory of the filesystem object.
+        //
+        std::chrono::milliseconds m_coalescing_window;
+
+    };
+
+    //
+    // Pending filesystem events in arrival order. Only accessed by the replication tasks dispatcher.
+    //
+    std::list<pending_filesystem_event> m_pending_filesystem_events;
+
+    //
+    // Pending filesystem events keyed by watch descriptor and filesystem object name.
+    //
+    std::unordered_map<std::string, std::list<pending_filesystem_event>::iterator> m_pending_filesystem_events_index;
+
+    //
+    // Reusable buffer for building pending filesystem event keys without allocating on every lookup.
+    //
+    std::string m_pending_filesystem_event_key;
 
     //
-    // File descriptor handle for the epoll instance.
+    // Coalescing windows keyed by the watch descriptor routing the filesystem events of each source directory.
     //
-    file_descriptor m_epoll_handle;
+    std::unordered_map<file_descriptor, std::chrono::milliseconds> m_coalescing_windows;
 
     //
-    // File descriptor handle for the inotify instance.
+    // Number of filesystem events received by the replication tasks dispatcher.
     //
-    file_descriptor m_inotify_handle;
+    std::atomic<uint64> m_number_received_filesystem_events;
+
+    //
+    // Number of replication tasks created by the replication tasks dispatcher.
+    //
+    std::atomic<uint64> m_number_dispatched_replication_tasks;
+
+    //
+    // Number of times a kernel filesystem events queue overflowed.
+    //
+    std::atomic<uint64> m_number_kernel_events_queue_overflows;
+
+    //
+    // Number of times the dispatcher deferred ready filesystem events on saturated thread pools.
+    //
+    std::atomic<uint64> m_number_deferred_dispatches;
+
+    //
+    // Lock for synchronizing the rescans bookkeeping across the offloader and the dispatcher thread pool.
+    //
+    std::mutex m_rescans_lock;
+
+    //
+    // Rescans in progress keyed by routing watch descriptor, along with whether a follow-up rescan was requested.
+    //
+    std::unordered_map<file_descriptor, bool> m_rescans_in_progress;
+
+    //
+    // Number of replication tasks batches and rescans started but not completed yet. In-flight replications do not hold
+    // a dispatcher thread while suspended, so the filesystem monitor waits for them explicitly before being destroyed.
+    // Neither do they count as queued tasks of any thread pool, so dispatching is deferred on their own bound as well.
+    //
+    uint64 m_number_in_flight_replications;
+
+    //
+    // Lock for synchronizing access to the number of in-flight replications.
+    //
+    std::mutex m_in_flight_replications_lock;
+
+    //
+    // Condition for awakening the filesystem monitor destruction once the last in-flight replication completes.
+    //
+    std::condition_variable m_in_flight_replications_condition;
+
+    //
+    // Random identifier generator for the replication tasks dispatcher.
+    //
+    random_identifier_generator m_random_identifier_generator;
 
     //
     // Termination signals handle for graceful termination.
@@ -135,9 +529,166 @@ private:
     file_descriptor m_termination_signals_handle;
 
     //
-    // Watch descriptors for the watch directories.
+    // Moved-from half of a rename waiting for its moved-to half.
+    //
+    struct pending_move
+    {
+
+        //
+        // Cookie shared by both halves of the rename.
+        //
+        uint32 m_cookie;
+
+        //
+        // Watch descriptor of the directory the object was moved from.
+        //
+        file_descriptor m_parent_watch_descriptor;
+
+        //
+        // Watch descriptor of the source directory the object was moved from.
+        //
+        file_descriptor m_root_watch_descriptor;
+
+        //
+        // Path of the object relative to its source directory before being moved.
+        //
+        std::string m_relative_path;
+
+        //
+        // Flag for determining whether the moved object is a directory.
+        //
+        bool m_directory;
+
+        //
+        // Time the moved-from half was offloaded.
+        //
+        std::chrono::steady_clock::time_point m_move_time;
+
+    };
+
+    //
+    // Inotify instance along with the state of the kernel events offloader thread draining it. Source directories
+    // are spread across the shards so that their filesystem events are offloaded in parallel; all shards feed
+    // the single replication tasks dispatcher through their own filesystem events queue.
+    //
+    struct inotify_shard
+    {
+
+        //
+        // Constructor.
+        //
+        inotify_shard(
+            const uint32 p_shard_index);
+
+        //
+        // Returns the watch descriptor routing the filesystem events of a source directory of the shard to its replication engine.
+        //
+        file_descriptor
+        get_routing_watch_descriptor(
+            const file_descriptor p_watch_descriptor) const;
+
+        //
+        // Index of the shard, carried by the routing watch descriptors of its source directories.
+        //
+        uint32 m_shard_index;
+
+        //
+        // File descriptor handle for the epoll instance of the shard.
+        //
+        file_descriptor m_epoll_handle;
+
+        //
+        // File descriptor handle for the inotify instance of the shard.
+        //
+        file_descriptor m_inotify_handle;
+
+        //
+        // Watch descriptors for the source directories of the shard.
+        //
+        std::vector<file_descriptor> m_watch_descriptors;
+
+        //
+        // Index for resolving the watch descriptors of nested directories into paths relative to their source directory.
+        // Only accessed by the kernel events offloader of the shard once the filesystem monitor has been constructed.
+        //
+        watch_descriptor_index m_watch_descriptor_index;
+
+        //
+        // Source directory paths keyed by their watch descriptor within the inotify instance of the shard.
+        //
+        std::unordered_map<file_descriptor, std::string> m_source_directory_paths;
+
+        //
+        // Moved-from halves waiting for their moved-to halves. Only accessed by the kernel events offloader of the shard.
+        //
+        std::vector<pending_move> m_pending_moves;
+
+        //
+        // Filesystem events queue for holding offloaded events batches. The kernel events offloader
+        // of the shard is the only producer and the replication tasks dispatcher is the only consumer.
+        //
+        spsc_ring_buffer<std::unique_ptr<filesystem_events_batch>> m_filesystem_events_queue;
+
+        //
+        // Consumed filesystem events batches handed back by the replication tasks dispatcher to the kernel
+        // events offloader, so that their grown buffers are reused instead of being allocated again.
+        //
+        spsc_ring_buffer<std::unique_ptr<filesystem_events_batch>> m_recycled_filesystem_events_batches;
+
+        //
+        // Filesystem events batch being filled by the kernel events offloader of the shard.
+        //
+        std::unique_ptr<filesystem_events_batch> m_offloading_batch;
+
+        //
+        // Kernel events offloader thread handle. Not started for the first shard, which is offloaded on the calling thread.
+        //
+        std::thread m_kernel_events_offloader_thread;
+
+    };
+
+    //
+    // Inotify shards, as many as configured through the replication manager.
+    //
+    std::vector<std::unique_ptr<inotify_shard>> m_inotify_shards;
+
+    //
+    // Source directory monitored through fanotify.
+    //
+    struct fanotify_source
+    {
+
+        //
+        // Canonical source directory path.
+        //
+        std::string m_path;
+
+        //
+        // Watch descriptor routing the filesystem events of the source directory to its replication engine.
+        //
+        file_descriptor m_routing_watch_descriptor;
+
+        //
+        // Open source directory used as mount reference for resolving file handles.
+        //
+        file_descriptor m_mount_file_descriptor;
+
+        //
+        // Identifier of the filesystem holding the source directory.
+        //
+        __kernel_fsid_t m_filesystem_identifier;
+
+    };
+
+    //
+    // File descriptor handle for the fanotify instance. Only started when a source directory is monitored through fanotify.
+    //
+    file_descriptor m_fanotify_handle;
+
+    //
+    // Source directories monitored through fanotify.
     //
-    std::vector<file_descriptor> m_watch_descriptors;
+    std::vector<fanotify_source> m_fanotify_sources;
 
     //
     // Replication tasks dispatcher thread handle.
@@ -150,24 +701,51 @@ private:
     static constexpr uint16 c_epoll_event_buffer_size = 1024u;
 
     //
-    // Number of threads to be used by the dispatcher thread pool.
+    // Max size in bytes for the read event buffer of the inotify instance.
     //
-    static constexpr uint16 c_dispatcher_thread_pool_size = 200u;
+    static constexpr uint16 c_read_event_buffer_size = 8192u;
 
     //
-    // Max size in bytes for the read event buffer of the inotify instance.
+    // Max number of fetched filesystem events for batch-processing. Whole batches are fetched, so the limit may be exceeded by one batch.
     //
-    static constexpr uint16 c_read_event_buffer_size = 8192u;
+    static constexpr uint32 c_max_number_fetched_filesystem_events = std::numeric_limits<uint16>::max();
+
+    //
+    // Inotify events watched on every directory of the source directory trees.
+    //
+    static constexpr uint32 c_directory_watch_mask = IN_CREATE | IN_MODIFY | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+    //
+    // Fanotify events marked on the filesystems holding source directories.
+    //
+    static constexpr uint64 c_fanotify_mark_mask = FAN_CREATE | FAN_MODIFY | FAN_DELETE | FAN_CLOSE_WRITE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_ONDIR;
+
+    //
+    // Max time in milliseconds to wait for the moved-to half of a rename. Both halves are
+    // queued back to back by the kernel, so only halves split across reads ever wait.
+    //
+    static constexpr uint32 c_move_pairing_timeout_ms = 10u;
+
+    //
+    // Time in milliseconds between capacity checks while the dispatcher defers ready filesystem events.
+    //
+    static constexpr uint32 c_backpressure_retry_interval_ms = 10u;
+
+    //
+    // Max age of a pending filesystem event, as a multiple of its coalescing window. Objects
+    // modified continuously are still replicated periodically instead of being held forever.
+    //
+    static constexpr uint32 c_max_coalescing_delay_factor = 10u;
 
     //
-    // Max number of fetched filesystem events for batch-processing.
+    // Max number of filesystem events batches held by the filesystem events queue.
     //
-    static constexpr uint16 c_max_number_fetched_filesystem_events = std::numeric_limits<uint16>::max();
+    static constexpr uint32 c_filesystem_events_queue_capacity = 256u;
 
     //
-    // Replication tasks dispatcher polling sleep duration in milliseconds.
+    // Max number of filesystem events appended to a single filesystem events batch before it is published.
     //
-    static constexpr uint8 c_replication_tasks_dispatcher_polling_sleep_ms = 1u;
+    static constexpr uint32 c_max_filesystem_events_per_batch = 4096u;
     
 };
 
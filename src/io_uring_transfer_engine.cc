@@ -0,0 +1,625 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'io_uring_transfer_engine.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "logger.hh"
+#include "io_uring_transfer_engine.hh"
+
+#include <poll.h>
+#include <cstring>
+#include <unistd.h>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+namespace modula
+{
+
+io_uring_transfer_awaitable::completion::completion()
+    : m_result{status::success, 0},
+      m_number_pending_parties(2)
+{}
+
+io_uring_transfer_awaitable::io_uring_transfer_awaitable(
+    std::shared_ptr<completion> p_completion)
+    : m_completion(std::move(p_completion))
+{}
+
+bool
+io_uring_transfer_awaitable::await_ready() const noexcept
+{
+    //
+    // Only the ring thread reaches the completion ahead of the awaiting coroutine.
+    //
+    return m_completion->m_number_pending_parties.load(std::memory_order_acquire) == 1;
+}
+
+bool
+io_uring_transfer_awaitable::await_suspend(
+    std::coroutine_handle<> p_coroutine) noexcept
+{
+    m_completion->m_continuation = p_coroutine;
+
+    //
+    // The transfer may have completed since it was checked; continue without suspending then.
+    //
+    return m_completion->m_number_pending_parties.fetch_sub(1, std::memory_order_acq_rel) != 1;
+}
+
+io_uring_transfer_result
+io_uring_transfer_awaitable::await_resume() const noexcept
+{
+    return m_completion->m_result;
+}
+
+io_uring_transfer_engine::io_uring_transfer_engine(
+    status_code* p_status) :
+    m_ring_handle(c_invalid_file_descriptor),
+    m_wakeup_handle(c_invalid_file_descriptor),
+    m_submission_queue_ring(nullptr),
+    m_submission_queue_ring_size(0),
+    m_completion_queue_ring(nullptr),
+    m_completion_queue_ring_size(0),
+    m_submission_queue_entries(nullptr),
+    m_submission_queue_entries_size(0),
+    m_parameters{},
+    m_number_unsubmitted_entries(0),
+    m_number_in_flight_operations(0),
+    m_wakeup_poll_armed(false),
+    m_stop(false)
+{
+    m_ring_handle = syscall(
+        __NR_io_uring_setup,
+        c_ring_number_entries,
+        &m_parameters);
+
+    if (!utilities::is_file_descriptor_valid(m_ring_handle))
+    {
+        *p_status = status::io_uring_startup_failed;
+
+        logger::log(log_level::error, std::format("Io_uring instance setup failed. {} (errno {}), Status={:#X}.",
+            std::strerror(errno),
+            errno,
+            *p_status));
+
+        return;
+    }
+
+    //
+    // Map the submission and completion rings; recent kernels share a single mapping for both.
+    //
+    m_submission_queue_ring_size = m_parameters.sq_off.array + m_parameters.sq_entries * sizeof(uint32);
+    m_completion_queue_ring_size = m_parameters.cq_off.cqes + m_parameters.cq_entries * sizeof(io_uring_cqe);
+
+    const bool single_mapping = m_parameters.features & IORING_FEAT_SINGLE_MMAP;
+
+    if (single_mapping)
+    {
+        m_submission_queue_ring_size = std::max(m_submission_queue_ring_size, m_completion_queue_ring_size);
+        m_completion_queue_ring_size = m_submission_queue_ring_size;
+    }
+
+    void* submission_queue_ring = mmap(
+        nullptr,
+        m_submission_queue_ring_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        m_ring_handle,
+        IORING_OFF_SQ_RING);
+
+    void* completion_queue_ring = single_mapping ? submission_queue_ring : mmap(
+        nullptr,
+        m_completion_queue_ring_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        m_ring_handle,
+        IORING_OFF_CQ_RING);
+
+    m_submission_queue_entries_size = m_parameters.sq_entries * sizeof(io_uring_sqe);
+
+    void* submission_queue_entries = mmap(
+        nullptr,
+        m_submission_queue_entries_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        m_ring_handle,
+        IORING_OFF_SQES);
+
+    m_submission_queue_ring = submission_queue_ring == MAP_FAILED ? nullptr : static_cast<byte*>(submission_queue_ring);
+    m_completion_queue_ring = completion_queue_ring == MAP_FAILED ? nullptr : static_cast<byte*>(completion_queue_ring);
+    m_submission_queue_entries = submission_queue_entries == MAP_FAILED ? nullptr : static_cast<io_uring_sqe*>(submission_queue_entries);
+
+    if (m_submission_queue_ring == nullptr ||
+        m_completion_queue_ring == nullptr ||
+        m_submission_queue_entries == nullptr)
+    {
+        *p_status = status::io_uring_startup_failed;
+
+        logger::log(log_level::error, std::format("Io_uring rings could not be mapped. {} (errno {}), Status={:#X}.",
+            std::strerror(errno),
+            errno,
+            *p_status));
+
+        return;
+    }
+
+    m_wakeup_handle = eventfd(
+        0,
+        EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (!utilities::is_file_descriptor_valid(m_wakeup_handle))
+    {
+        *p_status = status::file_descriptor_creation_failed;
+
+        logger::log(log_level::error, std::format("Io_uring wakeup file descriptor could not be created. {} (errno {}), Status={:#X}.",
+            std::strerror(errno),
+            errno,
+            *p_status));
+
+        return;
+    }
+
+    //
+    // Preallocate all chunk buffers up front; the ring thread never allocates on the data path.
+    //
+    m_buffers_memory = std::make_unique<byte[]>(static_cast<uint64>(c_number_chunks) * c_chunk_size);
+    m_chunks.resize(c_number_chunks);
+
+    for (uint32 chunk_index = 0; chunk_index < c_number_chunks; ++chunk_index)
+    {
+        m_chunks[chunk_index].m_buffer = m_buffers_memory.get() + static_cast<uint64>(chunk_index) * c_chunk_size;
+        m_free_chunks.push_back(&m_chunks[chunk_index]);
+    }
+
+    try
+    {
+        m_ring_thread = std::thread(
+            &io_uring_transfer_engine::ring_handler,
+            this);
+
+        if (!m_ring_thread.joinable())
+        {
+            *p_status = status::launch_thread_failed;
+
+            return;
+        }
+    }
+    catch (const std::system_error& exception)
+    {
+        *p_status = status::launch_thread_failed;
+
+        logger::log(log_level::error, std::format("Failed to start the io_uring ring thread. Exception='{}', Status={:#X}.",
+            exception.what(),
+            *p_status));
+
+        return;
+    }
+}
+
+io_uring_transfer_engine::~io_uring_transfer_engine()
+{
+    m_stop = true;
+
+    if (m_ring_thread.joinable())
+    {
+        const uint64 wakeup_value = 1u;
+        write(m_wakeup_handle, &wakeup_value, sizeof(wakeup_value));
+
+        m_ring_thread.join();
+    }
+
+    if (m_submission_queue_entries != nullptr)
+    {
+        munmap(m_submission_queue_entries, m_submission_queue_entries_size);
+    }
+
+    if (m_completion_queue_ring != nullptr &&
+        m_completion_queue_ring != m_submission_queue_ring)
+    {
+        munmap(m_completion_queue_ring, m_completion_queue_ring_size);
+    }
+
+    if (m_submission_queue_ring != nullptr)
+    {
+        munmap(m_submission_queue_ring, m_submission_queue_ring_size);
+    }
+
+    if (utilities::is_file_descriptor_valid(m_wakeup_handle))
+    {
+        close(m_wakeup_handle);
+    }
+
+    if (utilities::is_file_descriptor_valid(m_ring_handle))
+    {
+        close(m_ring_handle);
+    }
+}
+
+io_uring_transfer_awaitable
+io_uring_transfer_engine::submit_transfer(
+    const file_descriptor p_source_file_descriptor,
+    const file_descriptor p_target_file_descriptor,
+    const uint64 p_offset,
+    const uint64 p_number_bytes,
+    replication_task* p_replication_task)
+{
+    std::unique_ptr<transfer> new_transfer = std::make_unique<transfer>();
+    new_transfer->m_source_file_descriptor = p_source_file_descriptor;
+    new_transfer->m_target_file_descriptor = p_target_file_descriptor;
+    new_transfer->m_next_offset = p_offset;
+    new_transfer->m_end_offset = p_offset + p_number_bytes;
+    new_transfer->m_bytes_transferred = 0;
+    new_transfer->m_number_in_flight_chunks = 0;
+    new_transfer->m_status = status::success;
+    new_transfer->m_replication_task = p_replication_task;
+    new_transfer->m_completion = std::make_shared<io_uring_transfer_awaitable::completion>();
+
+    io_uring_transfer_awaitable transfer_awaitable(new_transfer->m_completion);
+
+    {
+        std::scoped_lock<std::mutex> lock(m_pending_transfers_lock);
+
+        //
+        // If the engine is in destruction process fail the submission.
+        //
+        if (m_stop ||
+            !m_ring_thread.joinable())
+        {
+            new_transfer->m_completion->m_result = {status::io_uring_transfer_failed, 0};
+            new_transfer->m_completion->m_number_pending_parties.fetch_sub(1, std::memory_order_acq_rel);
+
+            return transfer_awaitable;
+        }
+
+        m_pending_transfers.push_back(std::move(new_transfer));
+    }
+
+    //
+    // Wake up the ring thread through its armed poll operation.
+    //
+    const uint64 wakeup_value = 1u;
+    write(m_wakeup_handle, &wakeup_value, sizeof(wakeup_value));
+
+    return transfer_awaitable;
+}
+
+void
+io_uring_transfer_engine::ring_handler()
+{
+    uint32* completion_queue_head = reinterpret_cast<uint32*>(m_completion_queue_ring + m_parameters.cq_off.head);
+    uint32* completion_queue_tail = reinterpret_cast<uint32*>(m_completion_queue_ring + m_parameters.cq_off.tail);
+    const uint32 completion_queue_mask = *reinterpret_cast<uint32*>(m_completion_queue_ring + m_parameters.cq_off.ring_mask);
+    io_uring_cqe* completion_queue_entries = reinterpret_cast<io_uring_cqe*>(m_completion_queue_ring + m_parameters.cq_off.cqes);
+
+    forever
+    {
+        admit_pending_transfers();
+        issue_chunk_reads();
+
+        if (m_stop &&
+            m_active_transfers.empty() &&
+            m_number_in_flight_operations == 0)
+        {
+            std::scoped_lock<std::mutex> lock(m_pending_transfers_lock);
+
+            if (m_pending_transfers.empty())
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        if (!m_wakeup_poll_armed)
+        {
+            queue_wakeup_poll();
+        }
+
+        //
+        // Submit all queued operations and block until at least one completion arrives.
+        //
+        const int32 number_submitted_entries = syscall(
+            __NR_io_uring_enter,
+            m_ring_handle,
+            m_number_unsubmitted_entries,
+            1 /* Minimum number of completions. */,
+            IORING_ENTER_GETEVENTS,
+            nullptr,
+            0);
+
+        if (number_submitted_entries > 0)
+        {
+            m_number_unsubmitted_entries -= number_submitted_entries;
+        }
+        else if (utilities::system_call_failed(number_submitted_entries) &&
+            errno != EINTR &&
+            errno != EAGAIN &&
+            errno != EBUSY)
+        {
+            logger::log(log_level::error, std::format("Io_uring enter failed. {} (errno {}), Status={:#X}.",
+                std::strerror(errno),
+                errno,
+                status::io_uring_transfer_failed));
+        }
+
+        uint32 head = *completion_queue_head;
+        const uint32 tail = std::atomic_ref<uint32>(*completion_queue_tail).load(std::memory_order_acquire);
+
+        while (head != tail)
+        {
+            handle_completion(completion_queue_entries[head & completion_queue_mask]);
+
+            ++head;
+        }
+
+        std::atomic_ref<uint32>(*completion_queue_head).store(head, std::memory_order_release);
+    }
+}
+
+void
+io_uring_transfer_engine::admit_pending_transfers()
+{
+    std::deque<std::unique_ptr<transfer>> pending_transfers;
+
+    {
+        std::scoped_lock<std::mutex> lock(m_pending_transfers_lock);
+
+        pending_transfers.swap(m_pending_transfers);
+    }
+
+    for (std::unique_ptr<transfer>& pending_transfer : pending_transfers)
+    {
+        m_active_transfers.push_back(std::move(pending_transfer));
+
+        if (m_active_transfers.back()->m_next_offset >= m_active_transfers.back()->m_end_offset)
+        {
+            //
+            // Empty transfers complete right away.
+            //
+            complete_transfer(m_active_transfers.back().get());
+        }
+    }
+}
+
+void
+io_uring_transfer_engine::issue_chunk_reads()
+{
+    for (std::unique_ptr<transfer>& active_transfer : m_active_transfers)
+    {
+        while (!m_free_chunks.empty() &&
+            status::succeeded(active_transfer->m_status) &&
+            active_transfer->m_next_offset < active_transfer->m_end_offset &&
+            active_transfer->m_number_in_flight_chunks < c_max_number_in_flight_chunks_per_transfer)
+        {
+            chunk* free_chunk = m_free_chunks.back();
+            m_free_chunks.pop_back();
+
+            free_chunk->m_transfer = active_transfer.get();
+            free_chunk->m_offset = active_transfer->m_next_offset;
+            free_chunk->m_length = static_cast<uint32>(std::min<uint64>(c_chunk_size, active_transfer->m_end_offset - active_transfer->m_next_offset));
+            free_chunk->m_number_bytes_written = 0;
+            free_chunk->m_writing = false;
+
+            active_transfer->m_next_offset += free_chunk->m_length;
+            ++active_transfer->m_number_in_flight_chunks;
+
+            queue_chunk_operation(free_chunk);
+        }
+    }
+}
+
+void
+io_uring_transfer_engine::handle_completion(
+    const io_uring_cqe& p_completion)
+{
+    if (p_completion.user_data == c_wakeup_user_data)
+    {
+        //
+        // New transfers were submitted or the engine is stopping; consume the wakeup signal.
+        //
+        m_wakeup_poll_armed = false;
+
+        uint64 wakeup_value = 0;
+        read(m_wakeup_handle, &wakeup_value, sizeof(wakeup_value));
+
+        return;
+    }
+
+    chunk* completed_chunk = reinterpret_cast<chunk*>(p_completion.user_data);
+    transfer* chunk_transfer = completed_chunk->m_transfer;
+
+    --m_number_in_flight_operations;
+
+    if (p_completion.res == -EINTR ||
+        p_completion.res == -EAGAIN)
+    {
+        queue_chunk_operation(completed_chunk);
+
+        return;
+    }
+
+    if (p_completion.res < 0)
+    {
+        chunk_transfer->m_status = status::io_uring_transfer_failed;
+
+        logger::log(log_level::error, std::format("Io_uring transfer operation failed. Operation={}, Offset={}, {} (errno {}), Status={:#X}.",
+            completed_chunk->m_writing ? "Write" : "Read",
+            completed_chunk->m_offset,
+            std::strerror(-p_completion.res),
+            -p_completion.res,
+            chunk_transfer->m_status));
+
+        release_chunk(completed_chunk);
+
+        return;
+    }
+
+    if (!completed_chunk->m_writing)
+    {
+        if (static_cast<uint32>(p_completion.res) < completed_chunk->m_length)
+        {
+            //
+            // The source file was truncated midway; the follow-up event will replicate it again.
+            //
+            completed_chunk->m_length = p_completion.res;
+            chunk_transfer->m_end_offset = std::min(chunk_transfer->m_end_offset, completed_chunk->m_offset + p_completion.res);
+        }
+
+        if (completed_chunk->m_length == 0)
+        {
+            release_chunk(completed_chunk);
+
+            return;
+        }
+
+        completed_chunk->m_writing = true;
+        queue_chunk_operation(completed_chunk);
+
+        return;
+    }
+
+    completed_chunk->m_number_bytes_written += p_completion.res;
+
+    if (completed_chunk->m_number_bytes_written < completed_chunk->m_length)
+    {
+        //
+        // Short write; queue the remainder of the chunk.
+        //
+        queue_chunk_operation(completed_chunk);
+
+        return;
+    }
+
+    chunk_transfer->m_bytes_transferred += completed_chunk->m_length;
+
+    release_chunk(completed_chunk);
+}
+
+void
+io_uring_transfer_engine::queue_chunk_operation(
+    chunk* p_chunk)
+{
+    io_uring_sqe* submission_queue_entry = get_submission_queue_entry();
+
+    //
+    // Every chunk owns at most a single operation and the submission queue is larger
+    // than the number of chunks, so an entry is always available at this point.
+    //
+    if (p_chunk->m_writing)
+    {
+        submission_queue_entry->opcode = IORING_OP_WRITE;
+        submission_queue_entry->fd = p_chunk->m_transfer->m_target_file_descriptor;
+        submission_queue_entry->addr = reinterpret_cast<uint64>(p_chunk->m_buffer + p_chunk->m_number_bytes_written);
+        submission_queue_entry->len = p_chunk->m_length - p_chunk->m_number_bytes_written;
+        submission_queue_entry->off = p_chunk->m_offset + p_chunk->m_number_bytes_written;
+    }
+    else
+    {
+        submission_queue_entry->opcode = IORING_OP_READ;
+        submission_queue_entry->fd = p_chunk->m_transfer->m_source_file_descriptor;
+        submission_queue_entry->addr = reinterpret_cast<uint64>(p_chunk->m_buffer);
+        submission_queue_entry->len = p_chunk->m_length;
+        submission_queue_entry->off = p_chunk->m_offset;
+    }
+
+    submission_queue_entry->user_data = reinterpret_cast<uint64>(p_chunk);
+
+    ++m_number_in_flight_operations;
+}
+
+void
+io_uring_transfer_engine::queue_wakeup_poll()
+{
+    io_uring_sqe* submission_queue_entry = get_submission_queue_entry();
+
+    if (submission_queue_entry == nullptr)
+    {
+        return;
+    }
+
+    submission_queue_entry->opcode = IORING_OP_POLL_ADD;
+    submission_queue_entry->fd = m_wakeup_handle;
+    submission_queue_entry->poll32_events = POLLIN;
+    submission_queue_entry->user_data = c_wakeup_user_data;
+
+    m_wakeup_poll_armed = true;
+}
+
+io_uring_sqe*
+io_uring_transfer_engine::get_submission_queue_entry()
+{
+    uint32* submission_queue_head = reinterpret_cast<uint32*>(m_submission_queue_ring + m_parameters.sq_off.head);
+    uint32* submission_queue_tail = reinterpret_cast<uint32*>(m_submission_queue_ring + m_parameters.sq_off.tail);
+    uint32* submission_queue_array = reinterpret_cast<uint32*>(m_submission_queue_ring + m_parameters.sq_off.array);
+    const uint32 submission_queue_mask = *reinterpret_cast<uint32*>(m_submission_queue_ring + m_parameters.sq_off.ring_mask);
+
+    const uint32 tail = *submission_queue_tail;
+
+    if (tail - std::atomic_ref<uint32>(*submission_queue_head).load(std::memory_order_acquire) >= m_parameters.sq_entries)
+    {
+        return nullptr;
+    }
+
+    const uint32 index = tail & submission_queue_mask;
+    io_uring_sqe* submission_queue_entry = &m_submission_queue_entries[index];
+    std::memset(submission_queue_entry, 0, sizeof(io_uring_sqe));
+
+    submission_queue_array[index] = index;
+    std::atomic_ref<uint32>(*submission_queue_tail).store(tail + 1, std::memory_order_release);
+
+    ++m_number_unsubmitted_entries;
+
+    return submission_queue_entry;
+}
+
+void
+io_uring_transfer_engine::release_chunk(
+    chunk* p_chunk)
+{
+    transfer* chunk_transfer = p_chunk->m_transfer;
+
+    --chunk_transfer->m_number_in_flight_chunks;
+    m_free_chunks.push_back(p_chunk);
+
+    if (chunk_transfer->m_number_in_flight_chunks == 0 &&
+        (status::failed(chunk_transfer->m_status) ||
+        chunk_transfer->m_next_offset >= chunk_transfer->m_end_offset))
+    {
+        complete_transfer(chunk_transfer);
+    }
+}
+
+void
+io_uring_transfer_engine::complete_transfer(
+    transfer* p_transfer)
+{
+    if (status::failed(p_transfer->m_status) &&
+        p_transfer->m_replication_task != nullptr)
+    {
+        p_transfer->m_replication_task->set_last_error_timestamp(timestamp::get_current_time());
+    }
+
+    std::shared_ptr<io_uring_transfer_awaitable::completion> transfer_completion = std::move(p_transfer->m_completion);
+    transfer_completion->m_result = {p_transfer->m_status, p_transfer->m_bytes_transferred};
+
+    m_active_transfers.remove_if(
+        [p_transfer](const std::unique_ptr<transfer>& p_active_transfer)
+        {
+            return p_active_transfer.get() == p_transfer;
+        });
+
+    //
+    // The awaiting coroutine runs on the ring thread until it moves back onto its own thread pool, so it is only
+    // resumed once the transfer is released from the active set.
+    //
+    if (transfer_completion->m_number_pending_parties.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        transfer_completion->m_continuation.resume();
+    }
+}
+
+} // namespace modula.
@@ -0,0 +1,423 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'io_uring_transfer_engine.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef IO_URING_TRANSFER_ENGINE_
+#define IO_URING_TRANSFER_ENGINE_
+
+#include "status.hh"
+#include "utilities.hh"
+#include "replication_task.hh"
+
+#include <list>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <coroutine>
+#include <linux/io_uring.h>
+
+namespace modula
+{
+
+//
+// Result of a transfer executed by the io_uring transfer engine.
+//
+struct io_uring_transfer_result
+{
+
+    //
+    // Status of the transfer.
+    //
+    status_code m_status;
+
+    //
+    // Number of bytes written into the target file.
+    //
+    uint64 m_bytes_transferred;
+
+};
+
+//
+// Awaitable resuming the coroutine which submitted a transfer once all of its chunks complete. The awaiting
+// coroutine is resumed on the ring thread, so it is expected to move back onto its own thread pool afterwards.
+//
+class io_uring_transfer_awaitable
+{
+
+public:
+
+    //
+    // Completion of a transfer shared between the ring thread and the awaiting coroutine.
+    //
+    struct completion
+    {
+
+        //
+        // Constructor.
+        //
+        completion();
+
+        //
+        // Result of the transfer, set by the ring thread.
+        //
+        io_uring_transfer_result m_result;
+
+        //
+        // Coroutine awaiting the transfer.
+        //
+        std::coroutine_handle<> m_continuation;
+
+        //
+        // Number of parties yet to reach the completion, which are the ring thread and the awaiting
+        // coroutine. The last one to reach it resumes the awaiting coroutine exactly once.
+        //
+        std::atomic<uint32> m_number_pending_parties;
+
+    };
+
+    //
+    // Constructor.
+    //
+    explicit
+    io_uring_transfer_awaitable(
+        std::shared_ptr<completion> p_completion);
+
+    bool
+    await_ready() const noexcept;
+
+    bool
+    await_suspend(
+        std::coroutine_handle<> p_coroutine) noexcept;
+
+    io_uring_transfer_result
+    await_resume() const noexcept;
+
+private:
+
+    //
+    // Completion of the awaited transfer.
+    //
+    std::shared_ptr<completion> m_completion;
+
+};
+
+//
+// Io_uring transfer engine class for asynchronous replication transfers. A single ring thread
+// keeps the reads and writes of many replication tasks in flight, so deep I/O queues are
+// reached without blocking one thread per transfer on the kernel.
+//
+class io_uring_transfer_engine
+{
+
+public:
+
+    //
+    // Constructor. Sets up the io_uring instance and starts the ring thread.
+    //
+    io_uring_transfer_engine(
+        status_code* p_status);
+
+    //
+    // Destructor. Completes all in-flight transfers and releases the ring.
+    //
+    ~io_uring_transfer_engine();
+
+    //
+    // Submits the transfer of a byte range from the source file into the same range of the target file. The
+    // completion is bound to the replication task that requested it, and resumes the coroutine awaiting it.
+    //
+    io_uring_transfer_awaitable
+    submit_transfer(
+        const file_descriptor p_source_file_descriptor,
+        const file_descriptor p_target_file_descriptor,
+        const uint64 p_offset,
+        const uint64 p_number_bytes,
+        replication_task* p_replication_task);
+
+private:
+
+    //
+    // In-flight state of a submitted transfer.
+    //
+    struct transfer
+    {
+
+        //
+        // Source file to read from.
+        //
+        file_descriptor m_source_file_descriptor;
+
+        //
+        // Target file to write into.
+        //
+        file_descriptor m_target_file_descriptor;
+
+        //
+        // Next offset to be read from the source file.
+        //
+        uint64 m_next_offset;
+
+        //
+        // End offset of the transfer, exclusive.
+        //
+        uint64 m_end_offset;
+
+        //
+        // Number of bytes written so far.
+        //
+        uint64 m_bytes_transferred;
+
+        //
+        // Number of chunks currently owned by the ring.
+        //
+        uint32 m_number_in_flight_chunks;
+
+        //
+        // Status of the transfer.
+        //
+        status_code m_status;
+
+        //
+        // Replication task the completion maps back to.
+        //
+        replication_task* m_replication_task;
+
+        //
+        // Completion reached once all the chunks of the transfer complete.
+        //
+        std::shared_ptr<io_uring_transfer_awaitable::completion> m_completion;
+
+    };
+
+    //
+    // Chunk of a transfer moving through the ring; read first and then written.
+    //
+    struct chunk
+    {
+
+        //
+        // Owning transfer.
+        //
+        transfer* m_transfer;
+
+        //
+        // Buffer holding the chunk data.
+        //
+        byte* m_buffer;
+
+        //
+        // Offset of the chunk in both files.
+        //
+        uint64 m_offset;
+
+        //
+        // Number of valid bytes in the buffer.
+        //
+        uint32 m_length;
+
+        //
+        // Number of bytes of the chunk written so far.
+        //
+        uint32 m_number_bytes_written;
+
+        //
+        // Flag for determining whether the chunk is in its write phase.
+        //
+        bool m_writing;
+
+    };
+
+    //
+    // Ring thread loop for submitting operations and reaping their completions.
+    //
+    void
+    ring_handler();
+
+    //
+    // Moves newly submitted transfers into the set of active transfers.
+    //
+    void
+    admit_pending_transfers();
+
+    //
+    // Issues reads for active transfers while buffers and submission slots are available.
+    //
+    void
+    issue_chunk_reads();
+
+    //
+    // Handles a single completion queue entry.
+    //
+    void
+    handle_completion(
+        const io_uring_cqe& p_completion);
+
+    //
+    // Queues a read or write operation for a chunk.
+    //
+    void
+    queue_chunk_operation(
+        chunk* p_chunk);
+
+    //
+    // Queues the poll operation that wakes the ring thread on new submissions.
+    //
+    void
+    queue_wakeup_poll();
+
+    //
+    // Returns the next submission queue entry, or null when the submission queue is full.
+    //
+    io_uring_sqe*
+    get_submission_queue_entry();
+
+    //
+    // Releases a chunk and completes its transfer when no more work remains for it.
+    //
+    void
+    release_chunk(
+        chunk* p_chunk);
+
+    //
+    // Removes a transfer from the active set and resumes the coroutine awaiting it.
+    //
+    void
+    complete_transfer(
+        transfer* p_transfer);
+
+    //
+    // File descriptor handle for the io_uring instance.
+    //
+    file_descriptor m_ring_handle;
+
+    //
+    // Event file descriptor handle for waking the ring thread.
+    //
+    file_descriptor m_wakeup_handle;
+
+    //
+    // Mapped submission queue ring.
+    //
+    byte* m_submission_queue_ring;
+
+    //
+    // Size of the mapped submission queue ring.
+    //
+    uint64 m_submission_queue_ring_size;
+
+    //
+    // Mapped completion queue ring.
+    //
+    byte* m_completion_queue_ring;
+
+    //
+    // Size of the mapped completion queue ring.
+    //
+    uint64 m_completion_queue_ring_size;
+
+    //
+    // Mapped submission queue entries.
+    //
+    io_uring_sqe* m_submission_queue_entries;
+
+    //
+    // Size of the mapped submission queue entries.
+    //
+    uint64 m_submission_queue_entries_size;
+
+    //
+    // Parameters returned by the kernel on setup.
+    //
+    io_uring_params m_parameters;
+
+    //
+    // Number of submission queue entries queued but not yet submitted to the kernel.
+    //
+    uint32 m_number_unsubmitted_entries;
+
+    //
+    // Number of operations owned by the kernel, excluding the wakeup poll.
+    //
+    uint32 m_number_in_flight_operations;
+
+    //
+    // Flag for determining whether the wakeup poll is armed.
+    //
+    bool m_wakeup_poll_armed;
+
+    //
+    // Backing memory for the chunk buffers.
+    //
+    std::unique_ptr<byte[]> m_buffers_memory;
+
+    //
+    // Chunks which are not currently in flight.
+    //
+    std::vector<chunk*> m_free_chunks;
+
+    //
+    // Storage for all chunks.
+    //
+    std::vector<chunk> m_chunks;
+
+    //
+    // Transfers submitted and not yet admitted by the ring thread.
+    //
+    std::deque<std::unique_ptr<transfer>> m_pending_transfers;
+
+    //
+    // Transfers admitted by the ring thread.
+    //
+    std::list<std::unique_ptr<transfer>> m_active_transfers;
+
+    //
+    // Lock for synchronizing access to the pending transfers.
+    //
+    std::mutex m_pending_transfers_lock;
+
+    //
+    // Flag for stopping the ring thread.
+    //
+    std::atomic<bool> m_stop;
+
+    //
+    // Ring thread handle.
+    //
+    std::thread m_ring_thread;
+
+    //
+    // Number of submission queue entries requested for the ring.
+    //
+    static constexpr uint32 c_ring_number_entries = 256u;
+
+    //
+    // Number of chunks, which bounds the number of reads and writes in flight.
+    //
+    static constexpr uint32 c_number_chunks = 64u;
+
+    //
+    // Size in bytes of each chunk buffer.
+    //
+    static constexpr uint32 c_chunk_size = 256u * 1024u;
+
+    //
+    // Max number of chunks in flight for a single transfer, so that many transfers progress together.
+    //
+    static constexpr uint32 c_max_number_in_flight_chunks_per_transfer = 8u;
+
+    //
+    // User data value reserved for the wakeup poll completion.
+    //
+    static constexpr uint64 c_wakeup_user_data = 0u;
+
+};
+
+} // namespace modula.
+
+#endif
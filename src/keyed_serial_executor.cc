@@ -0,0 +1,357 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'keyed_serial_executor.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "keyed_serial_executor.hh"
+
+#include <algorithm>
+
+namespace modula
+{
+
+keyed_serial_executor::work_item::work_item(
+    std::vector<std::string>&& p_keys,
+    async_task<status_code>&& p_work,
+    const uint32 p_lane_index)
+    : m_keys(std::move(p_keys)),
+      m_work(std::move(p_work)),
+      m_lane_index(p_lane_index),
+      m_number_pending_dependencies(0),
+      m_completed(false),
+      m_status(status::success)
+{}
+
+keyed_serial_executor::capacity_awaitable::capacity_awaitable(
+    keyed_serial_executor* p_keyed_serial_executor,
+    const std::vector<std::string>* p_keys)
+    : m_keyed_serial_executor(p_keyed_serial_executor),
+      m_keys(p_keys)
+{}
+
+bool
+keyed_serial_executor::capacity_awaitable::await_ready() const
+{
+    std::scoped_lock<std::mutex> lock(m_keyed_serial_executor->m_lock);
+
+    return m_keyed_serial_executor->has_capacity(*m_keys);
+}
+
+bool
+keyed_serial_executor::capacity_awaitable::await_suspend(
+    std::coroutine_handle<> p_coroutine)
+{
+    std::scoped_lock<std::mutex> lock(m_keyed_serial_executor->m_lock);
+
+    //
+    // Work items may have completed since the capacity was checked; proceed without suspending then.
+    //
+    if (m_keyed_serial_executor->has_capacity(*m_keys))
+    {
+        return false;
+    }
+
+    m_keyed_serial_executor->m_suspended_submissions.emplace_back(p_coroutine, m_keys);
+
+    return true;
+}
+
+keyed_serial_executor::completion_awaitable::completion_awaitable(
+    keyed_serial_executor* p_keyed_serial_executor,
+    std::shared_ptr<work_item> p_work_item)
+    : m_keyed_serial_executor(p_keyed_serial_executor),
+      m_work_item(std::move(p_work_item))
+{}
+
+bool
+keyed_serial_executor::completion_awaitable::await_ready() const
+{
+    std::scoped_lock<std::mutex> lock(m_keyed_serial_executor->m_lock);
+
+    return m_work_item->m_completed;
+}
+
+bool
+keyed_serial_executor::completion_awaitable::await_suspend(
+    std::coroutine_handle<> p_coroutine)
+{
+    std::scoped_lock<std::mutex> lock(m_keyed_serial_executor->m_lock);
+
+    if (m_work_item->m_completed)
+    {
+        return false;
+    }
+
+    m_work_item->m_continuation = p_coroutine;
+
+    return true;
+}
+
+status_code
+keyed_serial_executor::completion_awaitable::await_resume() const
+{
+    return m_work_item->m_status;
+}
+
+keyed_serial_executor::keyed_serial_executor(
+    const std::vector<uint32>& p_lanes_parallelism,
+    const uint32 p_max_queue_depth_per_key)
+    : m_max_queue_depth_per_key(std::max(p_max_queue_depth_per_key, 1u))
+{
+    for (const uint32 lane_parallelism : p_lanes_parallelism)
+    {
+        lane_state& lane = m_lanes.emplace_back();
+        lane.m_parallelism = std::max(lane_parallelism, 1u);
+        lane.m_number_running_work_items = 0;
+    }
+}
+
+async_task<std::shared_ptr<keyed_serial_executor::work_item>>
+keyed_serial_executor::submit(
+    std::vector<std::string> p_keys,
+    async_task<status_code> p_work,
+    const uint32 p_lane_index)
+{
+    std::sort(p_keys.begin(), p_keys.end());
+    p_keys.erase(std::unique(p_keys.begin(), p_keys.end()), p_keys.end());
+
+    co_await capacity_awaitable(this, &p_keys);
+
+    std::shared_ptr<work_item> submitted_work_item = std::make_shared<work_item>(
+        std::move(p_keys),
+        std::move(p_work),
+        p_lane_index);
+
+    bool start = false;
+
+    {
+        std::scoped_lock<std::mutex> lock(m_lock);
+
+        register_work_item(submitted_work_item);
+
+        if (submitted_work_item->m_number_pending_dependencies == 0)
+        {
+            lane_state& lane = m_lanes[p_lane_index];
+
+            if (lane.m_number_running_work_items < lane.m_parallelism)
+            {
+                ++lane.m_number_running_work_items;
+                start = true;
+            }
+            else
+            {
+                lane.m_ready_work_items.push(submitted_work_item);
+            }
+        }
+    }
+
+    if (start)
+    {
+        start_detached(run_work_item(submitted_work_item));
+    }
+
+    co_return submitted_work_item;
+}
+
+keyed_serial_executor::completion_awaitable
+keyed_serial_executor::wait_for_completion(
+    const std::shared_ptr<work_item>& p_work_item)
+{
+    return completion_awaitable(this, p_work_item);
+}
+
+uint32
+keyed_serial_executor::get_number_running_work_items(
+    const uint32 p_lane_index)
+{
+    std::scoped_lock<std::mutex> lock(m_lock);
+
+    return m_lanes[p_lane_index].m_number_running_work_items;
+}
+
+bool
+keyed_serial_executor::has_capacity(
+    const std::vector<std::string>& p_keys) const
+{
+    return std::all_of(p_keys.begin(), p_keys.end(), [this](const std::string& p_key)
+    {
+        auto key = m_keys.find(p_key);
+
+        return key == m_keys.end() ||
+            key->second.m_number_queued_work_items < m_max_queue_depth_per_key;
+    });
+}
+
+void
+keyed_serial_executor::register_work_item(
+    const std::shared_ptr<work_item>& p_work_item)
+{
+    //
+    // Dependencies are collected for all paths before recording the work item under any of them.
+    //
+    for (const std::string& key : p_work_item->m_keys)
+    {
+        auto same_key = m_keys.find(key);
+
+        if (same_key != m_keys.end())
+        {
+            add_dependency(p_work_item, same_key->second.m_last_work_item);
+        }
+
+        if (key.empty())
+        {
+            //
+            // The root of the source directory conflicts with every other path.
+            //
+            for (const std::pair<const std::string, key_state>& other_key : m_keys)
+            {
+                add_dependency(p_work_item, other_key.second.m_last_work_item);
+            }
+
+            continue;
+        }
+
+        //
+        // Ancestor directories, the root included.
+        //
+        for (uint64 separator_position = 0; separator_position != std::string::npos; separator_position = key.find('/', separator_position + 1))
+        {
+            auto ancestor_key = m_keys.find(key.substr(0, separator_position));
+
+            if (ancestor_key != m_keys.end())
+            {
+                add_dependency(p_work_item, ancestor_key->second.m_last_work_item);
+            }
+        }
+
+        //
+        // Objects nested under the path, should it be a directory.
+        //
+        const std::string descendants_prefix = key + "/";
+
+        for (auto descendant_key = m_keys.lower_bound(descendants_prefix);
+            descendant_key != m_keys.end() && descendant_key->first.starts_with(descendants_prefix);
+            ++descendant_key)
+        {
+            add_dependency(p_work_item, descendant_key->second.m_last_work_item);
+        }
+    }
+
+    for (const std::string& key : p_work_item->m_keys)
+    {
+        key_state& state = m_keys[key];
+        ++state.m_number_queued_work_items;
+        state.m_last_work_item = p_work_item;
+    }
+}
+
+void
+keyed_serial_executor::add_dependency(
+    const std::shared_ptr<work_item>& p_work_item,
+    const std::shared_ptr<work_item>& p_earlier_work_item)
+{
+    std::vector<std::shared_ptr<work_item>>& dependent_work_items = p_earlier_work_item->m_dependent_work_items;
+
+    if (!dependent_work_items.empty() &&
+        dependent_work_items.back() == p_work_item)
+    {
+        return;
+    }
+
+    dependent_work_items.push_back(p_work_item);
+    ++p_work_item->m_number_pending_dependencies;
+}
+
+async_task<void>
+keyed_serial_executor::run_work_item(
+    std::shared_ptr<work_item> p_work_item)
+{
+    const status_code status = co_await std::move(p_work_item->m_work);
+
+    complete_work_item(p_work_item, status);
+}
+
+void
+keyed_serial_executor::complete_work_item(
+    const std::shared_ptr<work_item>& p_work_item,
+    const status_code p_status)
+{
+    std::vector<std::shared_ptr<work_item>> started_work_items;
+    std::vector<std::coroutine_handle<>> resumed_submissions;
+    std::coroutine_handle<> continuation;
+
+    {
+        std::scoped_lock<std::mutex> lock(m_lock);
+
+        p_work_item->m_completed = true;
+        p_work_item->m_status = p_status;
+        continuation = std::exchange(p_work_item->m_continuation, nullptr);
+
+        for (const std::string& key : p_work_item->m_keys)
+        {
+            auto completed_key = m_keys.find(key);
+
+            if (--completed_key->second.m_number_queued_work_items == 0)
+            {
+                m_keys.erase(completed_key);
+            }
+        }
+
+        for (const std::shared_ptr<work_item>& dependent_work_item : p_work_item->m_dependent_work_items)
+        {
+            if (--dependent_work_item->m_number_pending_dependencies == 0)
+            {
+                m_lanes[dependent_work_item->m_lane_index].m_ready_work_items.push(dependent_work_item);
+            }
+        }
+
+        p_work_item->m_dependent_work_items.clear();
+
+        --m_lanes[p_work_item->m_lane_index].m_number_running_work_items;
+
+        //
+        // Dependent work items may become ready on any lane, not only on the lane of the completed work item.
+        //
+        for (lane_state& lane : m_lanes)
+        {
+            while (!lane.m_ready_work_items.empty() &&
+                lane.m_number_running_work_items < lane.m_parallelism)
+            {
+                started_work_items.push_back(std::move(lane.m_ready_work_items.front()));
+                lane.m_ready_work_items.pop();
+                ++lane.m_number_running_work_items;
+            }
+        }
+
+        std::erase_if(m_suspended_submissions, [this, &resumed_submissions](const std::pair<std::coroutine_handle<>, const std::vector<std::string>*>& p_suspended_submission)
+        {
+            if (!has_capacity(*p_suspended_submission.second))
+            {
+                return false;
+            }
+
+            resumed_submissions.push_back(p_suspended_submission.first);
+
+            return true;
+        });
+    }
+
+    for (const std::shared_ptr<work_item>& started_work_item : started_work_items)
+    {
+        start_detached(run_work_item(started_work_item));
+    }
+
+    for (const std::coroutine_handle<> resumed_submission : resumed_submissions)
+    {
+        resumed_submission.resume();
+    }
+
+    if (continuation)
+    {
+        continuation.resume();
+    }
+}
+
+} // namespace modula.
@@ -0,0 +1,319 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'keyed_serial_executor.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef KEYED_SERIAL_EXECUTOR_
+#define KEYED_SERIAL_EXECUTOR_
+
+#include "status.hh"
+#include "utilities.hh"
+#include "async_task.hh"
+
+#include <map>
+#include <mutex>
+#include <queue>
+#include <memory>
+#include <string>
+#include <vector>
+#include <coroutine>
+
+namespace modula
+{
+
+//
+// Executor class for async tasks keyed by the relative paths they operate on. Work items run in submission order
+// with respect to every earlier work item sharing one of their paths, or holding an ancestor or a descendant of
+// one of them, so a directory is always replicated around the objects nested under it; work items on unrelated
+// paths run in parallel. Work items are submitted to lanes, each running up to its own parallelism, so that work
+// items of one lane never hold back those of another one beyond their path ordering. Each path admits a bounded
+// number of queued work items, beyond which submissions are suspended until earlier work items on the path complete.
+// Submissions must be serialized by the caller for the submission order to be meaningful.
+//
+class keyed_serial_executor
+{
+
+public:
+
+    //
+    // Unit of work submitted to the executor.
+    //
+    struct work_item
+    {
+
+        //
+        // Constructor.
+        //
+        work_item(
+            std::vector<std::string>&& p_keys,
+            async_task<status_code>&& p_work,
+            const uint32 p_lane_index);
+
+        //
+        // Paths the work item operates on, without duplicates.
+        //
+        std::vector<std::string> m_keys;
+
+        //
+        // Async task executing the work item.
+        //
+        async_task<status_code> m_work;
+
+        //
+        // Lane the work item runs on.
+        //
+        uint32 m_lane_index;
+
+        //
+        // Later work items waiting for this one to complete.
+        //
+        std::vector<std::shared_ptr<work_item>> m_dependent_work_items;
+
+        //
+        // Number of earlier work items yet to complete before this one may run.
+        //
+        uint32 m_number_pending_dependencies;
+
+        //
+        // Flag for determining whether the work item completed.
+        //
+        bool m_completed;
+
+        //
+        // Completion status of the work item.
+        //
+        status_code m_status;
+
+        //
+        // Coroutine awaiting the completion of the work item.
+        //
+        std::coroutine_handle<> m_continuation;
+
+    };
+
+    //
+    // Awaitable suspending a submission until every path it operates on admits another queued work item.
+    //
+    class capacity_awaitable
+    {
+
+    public:
+
+        //
+        // Constructor.
+        //
+        capacity_awaitable(
+            keyed_serial_executor* p_keyed_serial_executor,
+            const std::vector<std::string>* p_keys);
+
+        bool
+        await_ready() const;
+
+        bool
+        await_suspend(
+            std::coroutine_handle<> p_coroutine);
+
+        void
+        await_resume() const noexcept
+        {}
+
+    private:
+
+        //
+        // Executor to be submitted to.
+        //
+        keyed_serial_executor* m_keyed_serial_executor;
+
+        //
+        // Paths of the submission.
+        //
+        const std::vector<std::string>* m_keys;
+
+    };
+
+    //
+    // Awaitable resuming the awaiting coroutine with the status of a work item once it completes.
+    //
+    class completion_awaitable
+    {
+
+    public:
+
+        //
+        // Constructor.
+        //
+        completion_awaitable(
+            keyed_serial_executor* p_keyed_serial_executor,
+            std::shared_ptr<work_item> p_work_item);
+
+        bool
+        await_ready() const;
+
+        bool
+        await_suspend(
+            std::coroutine_handle<> p_coroutine);
+
+        status_code
+        await_resume() const;
+
+    private:
+
+        //
+        // Executor running the work item.
+        //
+        keyed_serial_executor* m_keyed_serial_executor;
+
+        //
+        // Work item to be awaited.
+        //
+        std::shared_ptr<work_item> m_work_item;
+
+    };
+
+    //
+    // Constructor. Creates one lane per parallelism entry.
+    //
+    keyed_serial_executor(
+        const std::vector<uint32>& p_lanes_parallelism,
+        const uint32 p_max_queue_depth_per_key);
+
+    //
+    // Submits an async task operating on a set of paths to a lane, suspending while any of the paths has no room for
+    // another queued work item. The work item is registered before the returned async task completes, and starts
+    // running on the calling thread as soon as it is ready. The async task must outlive the completion of the work item.
+    //
+    async_task<std::shared_ptr<work_item>>
+    submit(
+        std::vector<std::string> p_keys,
+        async_task<status_code> p_work,
+        const uint32 p_lane_index = 0);
+
+    //
+    // Returns an awaitable for the completion of a submitted work item.
+    //
+    completion_awaitable
+    wait_for_completion(
+        const std::shared_ptr<work_item>& p_work_item);
+
+    //
+    // Returns the number of work items currently running on a lane.
+    //
+    uint32
+    get_number_running_work_items(
+        const uint32 p_lane_index = 0);
+
+private:
+
+    //
+    // State of a path with queued work items.
+    //
+    struct key_state
+    {
+
+        //
+        // Number of queued work items operating on the path, running ones included.
+        //
+        uint32 m_number_queued_work_items;
+
+        //
+        // Most recently submitted work item operating on the path.
+        //
+        std::shared_ptr<work_item> m_last_work_item;
+
+    };
+
+    //
+    // Running state of a lane.
+    //
+    struct lane_state
+    {
+
+        //
+        // Max number of work items of the lane running at the same time.
+        //
+        uint32 m_parallelism;
+
+        //
+        // Number of work items of the lane currently running.
+        //
+        uint32 m_number_running_work_items;
+
+        //
+        // Work items of the lane without pending dependencies waiting for a running slot.
+        //
+        std::queue<std::shared_ptr<work_item>> m_ready_work_items;
+
+    };
+
+    //
+    // Returns whether every path admits another queued work item. Must be called with the executor lock held.
+    //
+    bool
+    has_capacity(
+        const std::vector<std::string>& p_keys) const;
+
+    //
+    // Makes a work item depend on the last earlier work items conflicting with any of its paths, and records
+    // it as the last work item of its paths. Must be called with the executor lock held.
+    //
+    void
+    register_work_item(
+        const std::shared_ptr<work_item>& p_work_item);
+
+    //
+    // Adds a dependency from a work item on an earlier one, unless already present.
+    //
+    static
+    void
+    add_dependency(
+        const std::shared_ptr<work_item>& p_work_item,
+        const std::shared_ptr<work_item>& p_earlier_work_item);
+
+    //
+    // Runs a ready work item to completion.
+    //
+    async_task<void>
+    run_work_item(
+        std::shared_ptr<work_item> p_work_item);
+
+    //
+    // Releases the paths and dependent work items of a completed work item, starting
+    // the work items and resuming the submissions it unblocked on the calling thread.
+    //
+    void
+    complete_work_item(
+        const std::shared_ptr<work_item>& p_work_item,
+        const status_code p_status);
+
+    //
+    // Lanes of the executor, indexed by lane index.
+    //
+    std::vector<lane_state> m_lanes;
+
+    //
+    // Max number of queued work items per path.
+    //
+    const uint32 m_max_queue_depth_per_key;
+
+    //
+    // Paths with queued work items, ordered so that the paths nested under a directory are contiguous.
+    //
+    std::map<std::string, key_state> m_keys;
+
+    //
+    // Submissions suspended until their paths admit another queued work item.
+    //
+    std::vector<std::pair<std::coroutine_handle<>, const std::vector<std::string>*>> m_suspended_submissions;
+
+    //
+    // Lock for synchronizing access to the executor state.
+    //
+    std::mutex m_lock;
+
+};
+
+} // namespace modula.
+
+#endif
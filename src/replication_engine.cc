@@ -7,25 +7,238 @@
 
 #include "logger.hh"
 #include "replication_engine.hh"
-#include "synchronization_manager.hh"
 
+#include <map>
+#include <fcntl.h>
+#include <charconv>
+#include <algorithm>
 #include <filesystem>
+#include <sys/stat.h>
 
 namespace modula
 {
 
+replication_engine_options::replication_engine_options()
+    : m_parallel_copy_minimum_file_size(c_default_parallel_copy_minimum_file_size),
+      m_monitoring_backend(monitoring_backend::inotify),
+      m_coalescing_window_ms(c_default_coalescing_window_ms),
+      m_parallelism(c_default_parallelism),
+      m_large_file_parallelism(c_default_large_file_parallelism),
+      m_large_file_minimum_size(c_default_large_file_minimum_size),
+      m_path_queue_depth(c_default_path_queue_depth),
+      m_weight(c_default_weight),
+      m_reserved_concurrency(c_default_reserved_concurrency)
+{}
+
+status_code
+replication_engine_options::set_option(
+    const std::string& p_key,
+    const std::string& p_value)
+{
+    if (p_key == c_parallel_copy_minimum_file_size_key ||
+        p_key == c_large_file_minimum_size_key)
+    {
+        uint64 file_size = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), file_size);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size())
+        {
+            return status::malformed_configuration_file;
+        }
+
+        if (p_key == c_parallel_copy_minimum_file_size_key)
+        {
+            m_parallel_copy_minimum_file_size = file_size;
+        }
+        else
+        {
+            m_large_file_minimum_size = file_size;
+        }
+
+        return status::success;
+    }
+
+    if (p_key == c_coalescing_window_ms_key)
+    {
+        uint32 coalescing_window_ms = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), coalescing_window_ms);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size())
+        {
+            return status::malformed_configuration_file;
+        }
+
+        m_coalescing_window_ms = coalescing_window_ms;
+
+        return status::success;
+    }
+
+    if (p_key == c_parallelism_key ||
+        p_key == c_large_file_parallelism_key ||
+        p_key == c_path_queue_depth_key ||
+        p_key == c_weight_key)
+    {
+        uint32 value = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), value);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size() ||
+            value == 0)
+        {
+            return status::malformed_configuration_file;
+        }
+
+        if (p_key == c_parallelism_key)
+        {
+            m_parallelism = value;
+        }
+        else if (p_key == c_large_file_parallelism_key)
+        {
+            m_large_file_parallelism = value;
+        }
+        else if (p_key == c_path_queue_depth_key)
+        {
+            m_path_queue_depth = value;
+        }
+        else
+        {
+            m_weight = value;
+        }
+
+        return status::success;
+    }
+
+    if (p_key == c_reserved_concurrency_key)
+    {
+        uint32 reserved_concurrency = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), reserved_concurrency);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size())
+        {
+            return status::malformed_configuration_file;
+        }
+
+        m_reserved_concurrency = reserved_concurrency;
+
+        return status::success;
+    }
+
+    if (p_key == c_monitor_key)
+    {
+        if (p_value == "inotify")
+        {
+            m_monitoring_backend = monitoring_backend::inotify;
+        }
+        else if (p_value == "fanotify")
+        {
+            m_monitoring_backend = monitoring_backend::fanotify;
+        }
+        else
+        {
+            return status::malformed_configuration_file;
+        }
+
+        return status::success;
+    }
+
+    return status::malformed_configuration_file;
+}
+
+replication_engine::replication_engine() :
+    m_weighted_fair_scheduler_lane_index(0),
+    m_keyed_serial_executor(
+        {replication_engine_options::c_default_parallelism, replication_engine_options::c_default_large_file_parallelism},
+        replication_engine_options::c_default_path_queue_depth),
+    m_rsync_batching_enabled(false),
+    m_fan_out_enabled(false)
+{}
+
 replication_engine::replication_engine(
     const directory&& p_source_directory,
-    const std::vector<directory>&& p_target_directories) :
+    const std::vector<directory>&& p_target_directories,
+    const replication_engine_options& p_replication_engine_options) :
+    m_weighted_fair_scheduler_lane_index(0),
+    m_keyed_serial_executor(
+        {p_replication_engine_options.m_parallelism, p_replication_engine_options.m_large_file_parallelism},
+        p_replication_engine_options.m_path_queue_depth),
     m_source_directory(std::move(p_source_directory)),
-    m_target_directories(std::move(p_target_directories))
-{}
+    m_target_directories(std::move(p_target_directories)),
+    m_rsync_batching_enabled(false),
+    m_fan_out_enabled(false),
+    m_replication_engine_options(p_replication_engine_options)
+{
+    for (directory& target_directory : m_target_directories)
+    {
+        const transport_profile& target_transport_profile = target_directory.get_transport_profile();
+
+        logger::log(log_level::info, std::format("Target directory transport profile configured. "
+            "SourceDirectoryPath={}, TargetDirectoryPath={}, TransportProfile=[{}].",
+            m_source_directory.get_path(),
+            target_directory.get_path(),
+            target_transport_profile.to_string()));
+
+        if (target_transport_profile.m_synchronization_strategy == synchronization_strategy::rsync)
+        {
+            continue;
+        }
+
+        //
+        // Reflink support is probed once per target directory so that
+        // the native copy path never has to rediscover it per file.
+        //
+        target_directory.detect_reflink_support(m_source_directory.get_path());
+
+        logger::log(log_level::info, std::format("Target directory reflink support detected. "
+            "SourceDirectoryPath={}, TargetDirectoryPath={}, ReflinkSupported={}.",
+            m_source_directory.get_path(),
+            target_directory.get_path(),
+            target_directory.is_reflink_supported()));
+
+        if (target_transport_profile.m_synchronization_strategy == synchronization_strategy::reflink &&
+            !target_directory.is_reflink_supported())
+        {
+            logger::log(log_level::warning, std::format("Target directory does not support reflinks. Files will be fully copied. "
+                "SourceDirectoryPath={}, TargetDirectoryPath={}.",
+                m_source_directory.get_path(),
+                target_directory.get_path()));
+        }
+    }
+
+    m_rsync_batching_enabled = !m_target_directories.empty() &&
+        std::all_of(m_target_directories.begin(), m_target_directories.end(), [](const directory& p_target_directory)
+        {
+            return p_target_directory.get_transport_profile().m_synchronization_strategy == synchronization_strategy::rsync;
+        });
+
+    //
+    // Reflinks are already free of source reads, and io_uring transfers
+    // go through their own ring; fan-out covers plain native copies.
+    //
+    m_fan_out_enabled = m_target_directories.size() > 1 &&
+        std::all_of(m_target_directories.begin(), m_target_directories.end(), [](const directory& p_target_directory)
+        {
+            return p_target_directory.get_transport_profile().m_synchronization_strategy == synchronization_strategy::native &&
+                !p_target_directory.is_reflink_supported();
+        });
+}
 
 replication_engine::replication_engine(
     replication_engine&& p_replication_engine) :
     m_replication_tasks_thread_pool(std::move(p_replication_engine.m_replication_tasks_thread_pool)),
+    m_weighted_fair_scheduler(std::move(p_replication_engine.m_weighted_fair_scheduler)),
+    m_weighted_fair_scheduler_lane_index(p_replication_engine.m_weighted_fair_scheduler_lane_index),
+    m_io_uring_transfer_engine(std::move(p_replication_engine.m_io_uring_transfer_engine)),
+    m_keyed_serial_executor(
+        {p_replication_engine.m_replication_engine_options.m_parallelism, p_replication_engine.m_replication_engine_options.m_large_file_parallelism},
+        p_replication_engine.m_replication_engine_options.m_path_queue_depth),
     m_source_directory(std::move(p_replication_engine.m_source_directory)),
-    m_target_directories(std::move(p_replication_engine.m_target_directories))
+    m_target_directories(std::move(p_replication_engine.m_target_directories)),
+    m_rsync_batching_enabled(p_replication_engine.m_rsync_batching_enabled),
+    m_fan_out_enabled(p_replication_engine.m_fan_out_enabled),
+    m_replication_engine_options(p_replication_engine.m_replication_engine_options)
 {}
 
 void
@@ -35,6 +248,34 @@ replication_engine::attach_replication_tasks_thread_pool(
     m_replication_tasks_thread_pool = p_replication_tasks_thread_pool;
 }
 
+void
+replication_engine::attach_weighted_fair_scheduler(
+    std::shared_ptr<weighted_fair_scheduler> p_weighted_fair_scheduler)
+{
+    m_weighted_fair_scheduler = p_weighted_fair_scheduler;
+
+    m_weighted_fair_scheduler_lane_index = m_weighted_fair_scheduler->register_lane(
+        m_source_directory.get_path(),
+        m_replication_engine_options.m_weight,
+        m_replication_engine_options.m_reserved_concurrency);
+}
+
+void
+replication_engine::attach_io_uring_transfer_engine(
+    std::shared_ptr<io_uring_transfer_engine> p_io_uring_transfer_engine)
+{
+    m_io_uring_transfer_engine = p_io_uring_transfer_engine;
+}
+
+bool
+replication_engine::requires_io_uring_transfer_engine() const
+{
+    return std::any_of(m_target_directories.begin(), m_target_directories.end(), [](const directory& p_target_directory)
+    {
+        return p_target_directory.get_transport_profile().m_synchronization_strategy == synchronization_strategy::io_uring;
+    });
+}
+
 status_code
 replication_engine::execute_full_sync()
 {
@@ -42,12 +283,322 @@ replication_engine::execute_full_sync()
     return status::success;
 }
 
-status_code
+async_task<status_code>
 replication_engine::execute_replication_task(
     std::unique_ptr<replication_task>& p_replication_task)
 {
-    std::scoped_lock<std::mutex> lock(m_replication_engine_lock);
+    status_code status = prepare_replication_task(p_replication_task);
+
+    if (status::failed(status))
+    {
+        co_return status;
+    }
+
+    std::shared_ptr<keyed_serial_executor::work_item> work_item;
+
+    {
+        async_mutex_lock lock = co_await m_submission_lock.scoped_lock();
+
+        work_item = co_await submit_replication_task(p_replication_task);
+    }
+
+    co_return co_await m_keyed_serial_executor.wait_for_completion(work_item);
+}
+
+async_mutex_turn
+replication_engine::reserve_submission_turn()
+{
+    return m_submission_lock.reserve_turn();
+}
+
+async_task<status_code>
+replication_engine::execute_replication_tasks_batch(
+    replication_tasks_batch& p_replication_tasks_batch,
+    async_mutex_turn p_submission_turn)
+{
+    status_code batch_status = status::success;
+
+    //
+    // Work items of the batch, awaited once all of them were submitted.
+    //
+    std::vector<std::shared_ptr<keyed_serial_executor::work_item>> work_items;
+
+    {
+        async_mutex_lock lock = co_await m_submission_lock.scoped_lock(std::move(p_submission_turn));
 
+        //
+        // Pending create and update tasks to be replicated through a single rsync process.
+        // Any other task flushes the pending ones first so that the batch order is preserved.
+        //
+        std::vector<replication_task*> pending_batched_replication_tasks;
+
+        for (std::unique_ptr<replication_task>& replication_task : p_replication_tasks_batch)
+        {
+            //
+            // The activity identifier is kept per thread, and the batch may have resumed on a different one.
+            //
+            logger::set_activity_id(replication_task->m_activity_id);
+
+            status_code status = prepare_replication_task(replication_task);
+
+            if (status::failed(status))
+            {
+                batch_status = status;
+
+                continue;
+            }
+
+            if (m_rsync_batching_enabled &&
+                (replication_task->get_replication_action() == replication_action::create ||
+                replication_task->get_replication_action() == replication_action::update))
+            {
+                pending_batched_replication_tasks.push_back(replication_task.get());
+
+                continue;
+            }
+
+            if (!pending_batched_replication_tasks.empty())
+            {
+                work_items.push_back(co_await submit_replication_tasks_batch(pending_batched_replication_tasks));
+                pending_batched_replication_tasks.clear();
+            }
+
+            work_items.push_back(co_await submit_replication_task(replication_task));
+        }
+
+        if (!pending_batched_replication_tasks.empty())
+        {
+            work_items.push_back(co_await submit_replication_tasks_batch(pending_batched_replication_tasks));
+        }
+    }
+
+    for (const std::shared_ptr<keyed_serial_executor::work_item>& work_item : work_items)
+    {
+        const status_code status = co_await m_keyed_serial_executor.wait_for_completion(work_item);
+
+        if (status::failed(status))
+        {
+            batch_status = status;
+        }
+    }
+
+    co_return batch_status;
+}
+
+const std::string&
+replication_engine::get_source_directory_path() const
+{
+    return m_source_directory.get_path();
+}
+
+monitoring_backend
+replication_engine::get_monitoring_backend() const
+{
+    return m_replication_engine_options.m_monitoring_backend;
+}
+
+std::chrono::milliseconds
+replication_engine::get_coalescing_window() const
+{
+    return std::chrono::milliseconds(m_replication_engine_options.m_coalescing_window_ms);
+}
+
+status_code
+replication_engine::collect_divergent_filesystem_objects(
+    std::vector<std::pair<std::string, replication_action>>* p_divergent_filesystem_objects) const
+{
+    const std::string& source_directory_path = get_source_directory_path();
+
+    //
+    // Divergent filesystem objects keyed by relative path. A parent path always sorts ahead of the paths nested under it.
+    //
+    std::map<std::string, replication_action> divergent_filesystem_objects;
+
+    std::error_code error;
+    std::filesystem::recursive_directory_iterator source_iterator(
+        source_directory_path,
+        std::filesystem::directory_options::skip_permission_denied,
+        error);
+
+    if (error)
+    {
+        logger::log(log_level::error, std::format("Failed to rescan the source directory. SourceDirectoryPath={}, Error='{}', Status={:#X}.",
+            source_directory_path,
+            error.message(),
+            status::rescan_failed));
+
+        return status::rescan_failed;
+    }
+
+    for (; !error && source_iterator != std::filesystem::recursive_directory_iterator(); source_iterator.increment(error))
+    {
+        const std::string source_filesystem_object_path = source_iterator->path().string();
+        const std::string relative_path = source_iterator->path().lexically_relative(source_directory_path).string();
+
+        struct stat source_stat;
+
+        if (utilities::system_call_failed(lstat(source_filesystem_object_path.c_str(), &source_stat)))
+        {
+            //
+            // The object is already gone; its removal is replicated through the live filesystem events.
+            //
+            continue;
+        }
+
+        for (const directory& target_directory : m_target_directories)
+        {
+            struct stat target_stat;
+            replication_action action = replication_action::invalid;
+
+            if (utilities::system_call_failed(lstat(std::format("{}/{}", target_directory.get_path(), relative_path).c_str(), &target_stat)))
+            {
+                action = replication_action::create;
+            }
+            else if ((source_stat.st_mode & S_IFMT) != (target_stat.st_mode & S_IFMT) ||
+                (S_ISREG(source_stat.st_mode) &&
+                    (source_stat.st_size != target_stat.st_size ||
+                    source_stat.st_mtim.tv_sec != target_stat.st_mtim.tv_sec ||
+                    source_stat.st_mtim.tv_nsec != target_stat.st_mtim.tv_nsec)))
+            {
+                action = replication_action::update;
+            }
+
+            if (action == replication_action::invalid)
+            {
+                continue;
+            }
+
+            auto [divergent_filesystem_object, inserted] = divergent_filesystem_objects.emplace(relative_path, action);
+
+            if (!inserted &&
+                action == replication_action::create)
+            {
+                divergent_filesystem_object->second = action;
+            }
+        }
+    }
+
+    if (error)
+    {
+        logger::log(log_level::warning, std::format("Source directory rescan stopped early. SourceDirectoryPath={}, Error='{}', Status={:#X}.",
+            source_directory_path,
+            error.message(),
+            status::rescan_failed));
+    }
+
+    for (const directory& target_directory : m_target_directories)
+    {
+        std::filesystem::recursive_directory_iterator target_iterator(
+            target_directory.get_path(),
+            std::filesystem::directory_options::skip_permission_denied,
+            error);
+
+        for (; !error && target_iterator != std::filesystem::recursive_directory_iterator(); target_iterator.increment(error))
+        {
+            if (synchronization_manager::is_temporary_file_name(target_iterator->path().filename().native()))
+            {
+                //
+                // Temporary files of in-flight replications are left to their owners.
+                //
+                continue;
+            }
+
+            const std::string relative_path = target_iterator->path().lexically_relative(target_directory.get_path()).string();
+
+            struct stat source_stat;
+
+            if (!utilities::system_call_failed(lstat(std::format("{}/{}", source_directory_path, relative_path).c_str(), &source_stat)) ||
+                errno != ENOENT)
+            {
+                continue;
+            }
+
+            divergent_filesystem_objects.emplace(relative_path, replication_action::remove);
+
+            //
+            // Removing a directory removes everything nested under it.
+            //
+            target_iterator.disable_recursion_pending();
+        }
+
+        if (error)
+        {
+            logger::log(log_level::warning, std::format("Failed to rescan a target directory. TargetDirectoryPath={}, Error='{}', Status={:#X}.",
+                target_directory.get_path(),
+                error.message(),
+                status::rescan_failed));
+
+            error.clear();
+        }
+    }
+
+    p_divergent_filesystem_objects->reserve(p_divergent_filesystem_objects->size() + divergent_filesystem_objects.size());
+
+    for (const std::pair<const std::string, replication_action>& divergent_filesystem_object : divergent_filesystem_objects)
+    {
+        p_divergent_filesystem_objects->emplace_back(
+            divergent_filesystem_object.first,
+            divergent_filesystem_object.second);
+    }
+
+    return status::success;
+}
+
+async_task<std::shared_ptr<keyed_serial_executor::work_item>>
+replication_engine::submit_replication_task(
+    std::unique_ptr<replication_task>& p_replication_task)
+{
+    std::vector<std::string> keys {p_replication_task->get_filesystem_object_name()};
+
+    if (p_replication_task->get_replication_action() == replication_action::move)
+    {
+        //
+        // A move is ordered against the replication tasks of both its previous and its new paths.
+        //
+        keys.push_back(p_replication_task->get_previous_filesystem_object_name());
+    }
+
+    //
+    // Only creations and updates transfer the contents of the filesystem object.
+    //
+    const bool contents_transferred = p_replication_task->get_replication_action() == replication_action::create ||
+        p_replication_task->get_replication_action() == replication_action::update;
+
+    const execution_lane lane = classify_execution_lane(contents_transferred ? p_replication_task->m_filesystem_object_size : 0);
+
+    co_return co_await m_keyed_serial_executor.submit(
+        std::move(keys),
+        enqueue_distributed_replication_tasks(p_replication_task),
+        static_cast<uint32>(lane));
+}
+
+async_task<std::shared_ptr<keyed_serial_executor::work_item>>
+replication_engine::submit_replication_tasks_batch(
+    const std::vector<replication_task*>& p_replication_tasks)
+{
+    std::vector<std::string> keys;
+    keys.reserve(p_replication_tasks.size());
+
+    uint64 filesystem_objects_size = 0;
+
+    for (const replication_task* replication_task : p_replication_tasks)
+    {
+        keys.push_back(replication_task->get_filesystem_object_name());
+        filesystem_objects_size += replication_task->m_filesystem_object_size;
+    }
+
+    const execution_lane lane = classify_execution_lane(filesystem_objects_size);
+
+    co_return co_await m_keyed_serial_executor.submit(
+        std::move(keys),
+        enqueue_distributed_replication_tasks_batch(p_replication_tasks),
+        static_cast<uint32>(lane));
+}
+
+status_code
+replication_engine::prepare_replication_task(
+    std::unique_ptr<replication_task>& p_replication_task)
+{
     status_code status = status::success;
 
     p_replication_task->m_filesystem_object_path = get_source_directory_path() + "/" + p_replication_task->get_filesystem_object_name();
@@ -58,7 +609,14 @@ replication_engine::execute_replication_task(
     //
     if (p_replication_task->get_replication_action() != replication_action::remove)
     {
-        if (!std::filesystem::exists(p_replication_task->m_filesystem_object_path))
+        struct statx filesystem_object_statx;
+
+        if (utilities::system_call_failed(statx(
+            AT_FDCWD,
+            p_replication_task->m_filesystem_object_path.c_str(),
+            AT_STATX_SYNC_AS_STAT,
+            STATX_TYPE | STATX_SIZE,
+            &filesystem_object_statx)))
         {
             status = status::filesystem_object_does_not_exist;
 
@@ -71,96 +629,302 @@ replication_engine::execute_replication_task(
 
             return status;
         }
+
+        //
+        // The size classifies the replication task into its execution lane when it is submitted.
+        //
+        p_replication_task->m_filesystem_object_size = S_ISREG(filesystem_object_statx.stx_mode) ? filesystem_object_statx.stx_size : 0;
     }
 
-    return enqueue_distributed_replication_tasks(p_replication_task);
+    return status;
 }
 
-const std::string&
-replication_engine::get_source_directory_path() const
+execution_lane
+replication_engine::classify_execution_lane(
+    const uint64 p_filesystem_objects_size) const
 {
-    return m_source_directory.get_path();
+    return p_filesystem_objects_size >= m_replication_engine_options.m_large_file_minimum_size ?
+        execution_lane::large_files :
+        execution_lane::small_files;
 }
 
-status_code
+async_task<status_code>
 replication_engine::enqueue_distributed_replication_tasks(
     std::unique_ptr<replication_task>& p_replication_task)
 {
+    if (m_fan_out_enabled &&
+        synchronization_manager::is_fan_out_applicable(p_replication_task.get()))
+    {
+        //
+        // The fan-out reader runs on the replication tasks thread pool, away from the thread which started the replication.
+        //
+        const weighted_fair_scheduler_slot slot = co_await m_weighted_fair_scheduler->schedule(m_weighted_fair_scheduler_lane_index);
+
+        if (!slot)
+        {
+            logger::log(log_level::error, std::format("Replication tasks distribution thread pool blocked replication task enqueue process. "
+                "Replication task may become partial or corrupted midway. FilesystemObjectPath={}, Status={:#X}.",
+                p_replication_task->m_filesystem_object_path.c_str(),
+                status::thread_pool_enqueue_process_failed));
+
+            co_return status::thread_pool_enqueue_process_failed;
+        }
+
+        co_return replicate_filesystem_object_fan_out(p_replication_task);
+    }
+
     status_code status = status::success;
 
-    std::unordered_map<std::string, std::optional<std::future<status_code>>> enqueue_status_responses;
+    std::vector<async_task<status_code>> replications;
+    replications.reserve(m_target_directories.size());
 
     for (const directory& target_directory : m_target_directories)
     {
-        const std::string& target_directory_path = target_directory.get_path(); 
+        replications.push_back(schedule_filesystem_object_replication(
+            target_directory,
+            p_replication_task));
+    }
 
-        std::optional<std::future<status_code>> enqueue_status = m_replication_tasks_thread_pool->enqueue_task(
-            [this, &target_directory_path, &p_replication_task]()
-            {
-                return this->replicate_filesystem_object(
-                    target_directory_path.c_str(),
-                    p_replication_task);
-            }
-        );
+    //
+    // The batch coroutine is suspended until the last target directory completes, instead of blocking its thread.
+    //
+    const std::vector<status_code> replication_statuses = co_await when_all(std::move(replications));
 
-        enqueue_status_responses.emplace(
-            target_directory_path,
-            std::move(enqueue_status));
+    for (const status_code replication_status : replication_statuses)
+    {
+        if (status::failed(replication_status))
+        {
+            status = replication_status;
+        }
     }
 
-    for (std::pair<const std::string, std::optional<std::future<status_code>>>& enqueue_status_response : enqueue_status_responses)
+    co_return status;
+}
+
+async_task<status_code>
+replication_engine::enqueue_distributed_replication_tasks_batch(
+    std::vector<replication_task*> p_replication_tasks)
+{
+    status_code status = status::success;
+
+    std::vector<async_task<status_code>> replications;
+    replications.reserve(m_target_directories.size());
+
+    for (const directory& target_directory : m_target_directories)
     {
-        if (enqueue_status_response.second == std::nullopt)
-        {
-            //
-            // Even if the enqueue process failed, the system must wait for all pending tasks to complete.
-            //
-            status = status::thread_pool_enqueue_process_failed;
+        replications.push_back(schedule_filesystem_objects_batch_replication(
+            target_directory,
+            p_replication_tasks));
+    }
 
-            logger::log(log_level::error, std::format("Replication tasks distribution thread pool blocked replication task enqueue process. "
-                "Replication task may become partial or corrupted midway. Status={:#X}.",
-                status));
-        }
-        else
+    const std::vector<status_code> batch_statuses = co_await when_all(std::move(replications));
+
+    for (const status_code batch_status : batch_statuses)
+    {
+        if (status::failed(batch_status))
         {
-            enqueue_status_response.second.value().wait();
+            status = batch_status;
         }
     }
 
-    return status;
+    co_return status;
 }
 
-status_code
+async_task<status_code>
+replication_engine::schedule_filesystem_object_replication(
+    const directory& p_target_directory,
+    std::unique_ptr<replication_task>& p_replication_task)
+{
+    const weighted_fair_scheduler_slot slot = co_await m_weighted_fair_scheduler->schedule(m_weighted_fair_scheduler_lane_index);
+
+    if (!slot)
+    {
+        logger::log(log_level::error, std::format("Replication tasks distribution thread pool blocked replication task enqueue process. "
+            "Replication task may become partial or corrupted midway. TargetDirectoryPath={}, Status={:#X}.",
+            p_target_directory.get_path(),
+            status::thread_pool_enqueue_process_failed));
+
+        co_return status::thread_pool_enqueue_process_failed;
+    }
+
+    co_return co_await replicate_filesystem_object(
+        p_target_directory,
+        p_replication_task);
+}
+
+async_task<status_code>
+replication_engine::schedule_filesystem_objects_batch_replication(
+    const directory& p_target_directory,
+    const std::vector<replication_task*>& p_replication_tasks)
+{
+    const weighted_fair_scheduler_slot slot = co_await m_weighted_fair_scheduler->schedule(m_weighted_fair_scheduler_lane_index);
+
+    if (!slot)
+    {
+        logger::log(log_level::error, std::format("Replication tasks distribution thread pool blocked replication tasks batch enqueue process. "
+            "Replication tasks may become partial or corrupted midway. TargetDirectoryPath={}, Status={:#X}.",
+            p_target_directory.get_path(),
+            status::thread_pool_enqueue_process_failed));
+
+        co_return status::thread_pool_enqueue_process_failed;
+    }
+
+    co_return replicate_filesystem_objects_batch(
+        p_target_directory,
+        p_replication_tasks);
+}
+
+async_task<status_code>
 replication_engine::replicate_filesystem_object(
-    const character* p_target_directory_path,
+    const directory& p_target_directory,
     std::unique_ptr<replication_task>& p_replication_task)
 {
+    const character* target_directory_path = p_target_directory.get_path().c_str();
+
     logger::set_activity_id(p_replication_task->m_activity_id);
 
     logger::log(log_level::info, std::format("Starting filesystem object replication. "
         "FilesystemObjectPath={}, TargetDirectoryPath={}.",
         p_replication_task->m_filesystem_object_path.c_str(),
-        p_target_directory_path));
+        target_directory_path));
 
     //
-    // Send an rsync synchronization command for handling replications.
+    // Synchronize the filesystem object through the transport selected for the replication engine.
     //
-    synchronization_result filesytem_object_synchronization_result = synchronization_manager::execute_synchronization_task(
-        p_target_directory_path,
-        p_replication_task);
+    const synchronization_options options = get_synchronization_options();
+
+    synchronization_result filesytem_object_synchronization_result = co_await synchronization_manager::execute_synchronization_task(
+        p_target_directory,
+        p_replication_task,
+        options);
+
+    log_synchronization_result(
+        target_directory_path,
+        p_replication_task.get(),
+        filesytem_object_synchronization_result);
+
+    co_return filesytem_object_synchronization_result.m_status;
+}
+
+status_code
+replication_engine::replicate_filesystem_object_fan_out(
+    std::unique_ptr<replication_task>& p_replication_task)
+{
+    status_code status = status::success;
+
+    logger::set_activity_id(p_replication_task->m_activity_id);
+
+    for (const directory& target_directory : m_target_directories)
+    {
+        logger::log(log_level::info, std::format("Starting fan-out filesystem object replication. "
+            "FilesystemObjectPath={}, TargetDirectoryPath={}, NumberTargetDirectories={}.",
+            p_replication_task->m_filesystem_object_path.c_str(),
+            target_directory.get_path(),
+            m_target_directories.size()));
+    }
+
+    //
+    // The writers of the fan-out pipeline run on the replication tasks thread pool.
+    //
+    std::vector<synchronization_result> synchronization_results = synchronization_manager::execute_fan_out_synchronization_task(
+        m_target_directories,
+        p_replication_task,
+        m_replication_tasks_thread_pool.get());
+
+    for (uint32 target_index = 0; target_index < m_target_directories.size(); ++target_index)
+    {
+        log_synchronization_result(
+            m_target_directories[target_index].get_path().c_str(),
+            p_replication_task.get(),
+            synchronization_results[target_index]);
+
+        if (status::failed(synchronization_results[target_index].m_status))
+        {
+            status = synchronization_results[target_index].m_status;
+        }
+    }
+
+    return status;
+}
+
+status_code
+replication_engine::replicate_filesystem_objects_batch(
+    const directory& p_target_directory,
+    const std::vector<replication_task*>& p_replication_tasks)
+{
+    status_code status = status::success;
+
+    const character* target_directory_path = p_target_directory.get_path().c_str();
 
-    status_code& status = filesytem_object_synchronization_result.m_status;
+    for (const replication_task* replication_task : p_replication_tasks)
+    {
+        logger::set_activity_id(replication_task->m_activity_id);
+
+        logger::log(log_level::info, std::format("Starting batched filesystem object replication. "
+            "FilesystemObjectPath={}, TargetDirectoryPath={}, BatchSize={}.",
+            replication_task->m_filesystem_object_path.c_str(),
+            target_directory_path,
+            p_replication_tasks.size()));
+    }
+
+    std::vector<synchronization_result> synchronization_results = synchronization_manager::execute_batched_synchronization_task(
+        get_source_directory_path().c_str(),
+        p_target_directory,
+        p_replication_tasks);
+
+    for (uint32 replication_task_index = 0; replication_task_index < p_replication_tasks.size(); ++replication_task_index)
+    {
+        logger::set_activity_id(p_replication_tasks[replication_task_index]->m_activity_id);
+
+        log_synchronization_result(
+            target_directory_path,
+            p_replication_tasks[replication_task_index],
+            synchronization_results[replication_task_index]);
+
+        if (status::failed(synchronization_results[replication_task_index].m_status))
+        {
+            status = synchronization_results[replication_task_index].m_status;
+        }
+    }
+
+    return status;
+}
+
+synchronization_options
+replication_engine::get_synchronization_options() const
+{
+    synchronization_options options;
+    options.m_io_uring_transfer_engine = m_io_uring_transfer_engine.get();
+    options.m_thread_pool = m_replication_tasks_thread_pool.get();
+    options.m_parallel_copy_minimum_file_size = m_replication_engine_options.m_parallel_copy_minimum_file_size;
+
+    return options;
+}
+
+void
+replication_engine::log_synchronization_result(
+    const character* p_target_directory_path,
+    const replication_task* p_replication_task,
+    synchronization_result& p_synchronization_result)
+{
+    const status_code& status = p_synchronization_result.m_status;
 
     if (status::succeeded(status))
     {
         logger::log(log_level::info, std::format("Filesystem object replication succeeded. "
-            "FilesystemObjectPath={}, TargetDirectoryPath={}, StartTime={}, EndTime={}, BytesTransferred={}, BytesPerSecond={:.2f}.",
+            "FilesystemObjectPath={}, TargetDirectoryPath={}, StartTime={}, EndTime={}, BytesTransferred={}, BytesPerSecond={:.2f}, "
+            "DeltaBytes={}, LiteralBytes={}, ReflinkedBytes={}, LogicalBytes={}, AllocatedBytes={}.",
             p_replication_task->m_filesystem_object_path.c_str(),
             p_target_directory_path,
-            filesytem_object_synchronization_result.m_start_timestamp.to_string(),
-            filesytem_object_synchronization_result.m_end_timestamp.to_string(),
-            filesytem_object_synchronization_result.m_bytes_transferred,
-            filesytem_object_synchronization_result.m_bytes_per_second));
+            p_synchronization_result.m_start_timestamp.to_string(),
+            p_synchronization_result.m_end_timestamp.to_string(),
+            p_synchronization_result.m_bytes_transferred,
+            p_synchronization_result.m_bytes_per_second,
+            p_synchronization_result.m_delta_bytes,
+            p_synchronization_result.m_literal_bytes,
+            p_synchronization_result.m_reflinked_bytes,
+            p_synchronization_result.m_logical_bytes,
+            p_synchronization_result.m_allocated_bytes));
     }
     else
     {
@@ -168,12 +932,10 @@ replication_engine::replicate_filesystem_object(
             "FilesystemObjectPath={}, TargetDirectoryPath={}, StartTime={}, EndTime={}. Status={:#X}.",
             p_replication_task->m_filesystem_object_path.c_str(),
             p_target_directory_path,
-            filesytem_object_synchronization_result.m_start_timestamp.to_string(),
-            filesytem_object_synchronization_result.m_end_timestamp.to_string(),
+            p_synchronization_result.m_start_timestamp.to_string(),
+            p_synchronization_result.m_end_timestamp.to_string(),
             status));
     }
-
-    return status;
 }
 
 } // namespace modula.
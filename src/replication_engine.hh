@@ -10,12 +10,211 @@
 
 #include "status.hh"
 #include "directory.hh"
+#include "async_task.hh"
+#include "async_mutex.hh"
 #include "thread_pool.hh"
 #include "replication_task.hh"
+#include "keyed_serial_executor.hh"
+#include "weighted_fair_scheduler.hh"
+#include "synchronization_manager.hh"
+
+#include <chrono>
 
 namespace modula
 {
 
+//
+// Monitoring backend enum class for selecting how filesystem events of a source directory are collected.
+//
+enum class monitoring_backend : uint8
+{
+
+    //
+    // One inotify watch per directory of the source directory tree.
+    //
+    inotify = 0,
+
+    //
+    // One fanotify mark per filesystem holding the source directory, with
+    // events resolved into paths through their directory file handles.
+    //
+    fanotify = 1
+
+};
+
+//
+// Execution lane enum class for separating the replication of large files from everything
+// else, so that bulk transfers never hold back the replication of small filesystem objects.
+//
+enum class execution_lane : uint8
+{
+
+    //
+    // Directories, removals, moves and files below the large file minimum size.
+    //
+    small_files = 0,
+
+    //
+    // Files of at least the large file minimum size.
+    //
+    large_files = 1
+
+};
+
+//
+// Replication engine options struct for the settings of a source directory.
+//
+struct replication_engine_options
+{
+
+    //
+    // Constructor. Defaults the values for the replication engine options.
+    //
+    replication_engine_options();
+
+    //
+    // Sets a replication engine option out of its configuration key and value.
+    //
+    status_code
+    set_option(
+        const std::string& p_key,
+        const std::string& p_value);
+
+    //
+    // Minimum file size in bytes for replicating files through parallel chunked copies.
+    //
+    uint64 m_parallel_copy_minimum_file_size;
+
+    //
+    // Backend collecting the filesystem events of the source directory.
+    //
+    monitoring_backend m_monitoring_backend;
+
+    //
+    // Window in milliseconds for coalescing the filesystem events of a filesystem object
+    // before replicating it. Zero only coalesces events fetched together by the dispatcher.
+    //
+    uint32 m_coalescing_window_ms;
+
+    //
+    // Max number of filesystem objects replicated at the same time by the replication engine on the small files lane.
+    //
+    uint32 m_parallelism;
+
+    //
+    // Max number of filesystem objects replicated at the same time by the replication engine on the large files lane.
+    //
+    uint32 m_large_file_parallelism;
+
+    //
+    // Minimum size in bytes of the files replicated on the large files lane. Batches
+    // of files replicated together are classified by their combined size.
+    //
+    uint64 m_large_file_minimum_size;
+
+    //
+    // Max number of replication tasks queued for the same filesystem object before
+    // the replication engine stops taking further replication tasks in.
+    //
+    uint32 m_path_queue_depth;
+
+    //
+    // Share of the replication tasks thread pool taken by the replication engine relative to the other replication engines.
+    //
+    uint32 m_weight;
+
+    //
+    // Running slots of the replication tasks thread pool kept available for the replication engine at all times.
+    //
+    uint32 m_reserved_concurrency;
+
+    //
+    // Configuration key for the minimum file size of parallel chunked copies.
+    //
+    static constexpr const character* c_parallel_copy_minimum_file_size_key = "parallel_copy_minimum_file_size";
+
+    //
+    // Configuration key for the monitoring backend.
+    //
+    static constexpr const character* c_monitor_key = "monitor";
+
+    //
+    // Configuration key for the coalescing window.
+    //
+    static constexpr const character* c_coalescing_window_ms_key = "coalescing_window_ms";
+
+    //
+    // Configuration key for the parallelism.
+    //
+    static constexpr const character* c_parallelism_key = "parallelism";
+
+    //
+    // Configuration key for the large file parallelism.
+    //
+    static constexpr const character* c_large_file_parallelism_key = "large_file_parallelism";
+
+    //
+    // Configuration key for the large file minimum size.
+    //
+    static constexpr const character* c_large_file_minimum_size_key = "large_file_minimum_size";
+
+    //
+    // Configuration key for the path queue depth.
+    //
+    static constexpr const character* c_path_queue_depth_key = "path_queue_depth";
+
+    //
+    // Configuration key for the weight.
+    //
+    static constexpr const character* c_weight_key = "weight";
+
+    //
+    // Configuration key for the reserved concurrency.
+    //
+    static constexpr const character* c_reserved_concurrency_key = "reserved_concurrency";
+
+    //
+    // Default minimum file size in bytes for parallel chunked copies.
+    //
+    static constexpr uint64 c_default_parallel_copy_minimum_file_size = 1024u * 1024u * 1024u;
+
+    //
+    // Default coalescing window in milliseconds.
+    //
+    static constexpr uint32 c_default_coalescing_window_ms = 100u;
+
+    //
+    // Default parallelism.
+    //
+    static constexpr uint32 c_default_parallelism = 16u;
+
+    //
+    // Default large file parallelism.
+    //
+    static constexpr uint32 c_default_large_file_parallelism = 2u;
+
+    //
+    // Default minimum size in bytes of the files replicated on the large files lane.
+    //
+    static constexpr uint64 c_default_large_file_minimum_size = 64u * 1024u * 1024u;
+
+    //
+    // Default path queue depth.
+    //
+    static constexpr uint32 c_default_path_queue_depth = 64u;
+
+    //
+    // Default weight.
+    //
+    static constexpr uint32 c_default_weight = 1u;
+
+    //
+    // Default reserved concurrency.
+    //
+    static constexpr uint32 c_default_reserved_concurrency = 0u;
+
+};
+
 //
 // Replication engine class for managing directory-level filesystem replication.
 //
@@ -27,14 +226,15 @@ public:
     //
     // Default constructor for container compatibility.
     //
-    replication_engine() = default;
+    replication_engine();
 
     //
     // Constructor. Initializes the replication engine class.
     //
     replication_engine(
         const directory&& p_source_directory,
-        const std::vector<directory>&& m_target_directories);
+        const std::vector<directory>&& m_target_directories,
+        const replication_engine_options& p_replication_engine_options = replication_engine_options());
 
     //
     // Move constructor. Transfers instance ownership.
@@ -49,6 +249,27 @@ public:
     attach_replication_tasks_thread_pool(
         std::shared_ptr<thread_pool> p_replication_tasks_thread_pool);
 
+    //
+    // Attaches the weighted fair scheduler in front of the replication tasks thread pool,
+    // registering the lane of the replication engine with its weight and reserved concurrency.
+    //
+    void
+    attach_weighted_fair_scheduler(
+        std::shared_ptr<weighted_fair_scheduler> p_weighted_fair_scheduler);
+
+    //
+    // Attaches the shared io_uring transfer engine used by the io_uring synchronization strategy.
+    //
+    void
+    attach_io_uring_transfer_engine(
+        std::shared_ptr<io_uring_transfer_engine> p_io_uring_transfer_engine);
+
+    //
+    // Returns whether any target directory of the replication engine is synchronized through io_uring.
+    //
+    bool
+    requires_io_uring_transfer_engine() const;
+
     //
     // Performs a directory-level full sync.
     //
@@ -58,34 +279,160 @@ public:
     //
     // Executes a replication task.
     //
-    status_code
+    async_task<status_code>
     execute_replication_task(
         std::unique_ptr<replication_task>& p_replication_task);
 
+    //
+    // Reserves the next turn for submitting a replication tasks batch. Batches are submitted in the order their turns
+    // were reserved, regardless of the order in which they reach the replication engine.
+    //
+    async_mutex_turn
+    reserve_submission_turn();
+
+    //
+    // Executes a batch of replication tasks in order. Replication tasks of the batch are submitted to the
+    // keyed serial executor on the reserved submission turn. The executor replicates filesystem objects on
+    // unrelated paths in parallel while keeping the replication tasks of the same path, and of its ancestors
+    // and descendants, in order. When rsync is the transport of every target directory, consecutive create and
+    // update tasks are replicated through a single rsync process per target directory. The replication tasks batch
+    // must outlive the returned async task.
+    //
+    async_task<status_code>
+    execute_replication_tasks_batch(
+        replication_tasks_batch& p_replication_tasks_batch,
+        async_mutex_turn p_submission_turn);
+
     //
     // Returns the path for the source directory of the replication engine.
     //
     const std::string&
     get_source_directory_path() const;
 
+    //
+    // Returns the backend collecting the filesystem events of the source directory.
+    //
+    monitoring_backend
+    get_monitoring_backend() const;
+
+    //
+    // Returns the window for coalescing the filesystem events of the source directory.
+    //
+    std::chrono::milliseconds
+    get_coalescing_window() const;
+
+    //
+    // Compares the metadata of the source directory tree against every target directory and collects the
+    // paths, relative to the source directory, of the filesystem objects which diverged along with the
+    // replication action reconciling them. Objects missing from a target directory are created, objects whose
+    // type, size or modification time differ are updated and objects missing from the source are removed.
+    // Parent directories are always collected ahead of the objects nested under them.
+    //
+    status_code
+    collect_divergent_filesystem_objects(
+        std::vector<std::pair<std::string, replication_action>>* p_divergent_filesystem_objects) const;
+
 private:
 
     //
-    // Distributes the replication task into sub-tasks across
-    // the replication tasks thread pool for parallel execution.
+    // Submits a replication task to the keyed serial executor under the paths it operates on.
+    //
+    async_task<std::shared_ptr<keyed_serial_executor::work_item>>
+    submit_replication_task(
+        std::unique_ptr<replication_task>& p_replication_task);
+
+    //
+    // Submits a batch of create and update replication tasks to the keyed serial executor under all of their paths.
+    //
+    async_task<std::shared_ptr<keyed_serial_executor::work_item>>
+    submit_replication_tasks_batch(
+        const std::vector<replication_task*>& p_replication_tasks);
+
+    //
+    // Resolves the source path of the replication task, validates it can still be replicated and records the size of the filesystem object.
     //
     status_code
+    prepare_replication_task(
+        std::unique_ptr<replication_task>& p_replication_task);
+
+    //
+    // Distributes the replication task into sub-tasks across the replication tasks
+    // thread pool for parallel execution and awaits all of them to complete.
+    //
+    async_task<status_code>
     enqueue_distributed_replication_tasks(
         std::unique_ptr<replication_task>& p_replication_task);
 
     //
-    // Replicates a filesystem object to a target directory.
+    // Replicates a filesystem object to all target directories out of a single read of the source file.
     //
     status_code
+    replicate_filesystem_object_fan_out(
+        std::unique_ptr<replication_task>& p_replication_task);
+
+    //
+    // Distributes a batch of replication tasks into one batched sub-task per target
+    // directory across the replication tasks thread pool and awaits all of them to complete.
+    //
+    async_task<status_code>
+    enqueue_distributed_replication_tasks_batch(
+        std::vector<replication_task*> p_replication_tasks);
+
+    //
+    // Replicates a filesystem object to a target directory on the replication tasks thread pool, once the lane of the replication engine is granted a running slot.
+    //
+    async_task<status_code>
+    schedule_filesystem_object_replication(
+        const directory& p_target_directory,
+        std::unique_ptr<replication_task>& p_replication_task);
+
+    //
+    // Replicates a batch of filesystem objects to a target directory on the replication tasks thread pool, once the lane of the replication engine is granted a running slot.
+    //
+    async_task<status_code>
+    schedule_filesystem_objects_batch_replication(
+        const directory& p_target_directory,
+        const std::vector<replication_task*>& p_replication_tasks);
+
+    //
+    // Replicates a filesystem object to a target directory. Suspends while the synchronization awaits io_uring transfers.
+    //
+    async_task<status_code>
     replicate_filesystem_object(
-        const character* p_target_directory_path,
+        const directory& p_target_directory,
         std::unique_ptr<replication_task>& p_replication_task);
 
+    //
+    // Replicates a batch of filesystem objects to a target directory.
+    //
+    status_code
+    replicate_filesystem_objects_batch(
+        const directory& p_target_directory,
+        const std::vector<replication_task*>& p_replication_tasks);
+
+    //
+    // Returns the execution lane for replicating filesystem objects of a given combined size.
+    //
+    execution_lane
+    classify_execution_lane(
+        const uint64 p_filesystem_objects_size) const;
+
+    //
+    // Builds the synchronization options applied to the synchronization tasks of the replication engine.
+    //
+    synchronization_options
+    get_synchronization_options() const;
+
+    //
+    // Logs the outcome of a filesystem object replication to a target directory.
+    //
+    static
+    void
+    log_synchronization_result(
+        const character* p_target_directory_path,
+        const replication_task* p_replication_task,
+        synchronization_result& p_synchronization_result);
+
     //
     // Thread pool for handling concurrent directory replication.
     // This is shared among all replication engines in the system.
@@ -93,9 +440,33 @@ private:
     std::shared_ptr<thread_pool> m_replication_tasks_thread_pool;
 
     //
-    // Lock for synchronizing replication tasks for each replication engine.
+    // Scheduler sharing the replication tasks thread pool fairly among the replication engines.
+    // This is shared among all replication engines in the system.
+    //
+    std::shared_ptr<weighted_fair_scheduler> m_weighted_fair_scheduler;
+
+    //
+    // Lane of the replication engine within the weighted fair scheduler.
+    //
+    uint32 m_weighted_fair_scheduler_lane_index;
+
+    //
+    // Io_uring transfer engine for asynchronous transfers.
+    // This is shared among all replication engines in the system.
+    //
+    std::shared_ptr<io_uring_transfer_engine> m_io_uring_transfer_engine;
+
+    //
+    // Executor replicating the filesystem objects of the replication engine in per-path order, with one lane per execution lane.
+    //
+    keyed_serial_executor m_keyed_serial_executor;
+
+    //
+    // Lock for serializing the submission of replication tasks batches to the keyed serial executor, so that
+    // replication tasks are ordered as they were dispatched. Batches take their turn on the dispatcher thread,
+    // before hopping onto any thread pool. Only held while submitting, not while replicating.
     //
-    std::mutex m_replication_engine_lock;
+    async_mutex m_submission_lock;
 
     //
     // Directory component of the replication engine.
@@ -107,6 +478,21 @@ private:
     // Container for all target directories associated to the replication engine.
     //
     std::vector<directory> m_target_directories;
+
+    //
+    // Flag for determining whether create and update tasks of a batch are replicated through a single rsync process per target directory.
+    //
+    bool m_rsync_batching_enabled;
+
+    //
+    // Flag for determining whether regular files are fanned out to all target directories out of a single source read.
+    //
+    bool m_fan_out_enabled;
+
+    //
+    // Settings of the source directory.
+    //
+    replication_engine_options m_replication_engine_options;
     
 };
 
@@ -8,12 +8,21 @@
 #include "logger.hh"
 #include "replication_manager.hh"
 
+#include <fstream>
+#include <sstream>
+#include <charconv>
+#include <algorithm>
+
 namespace modula
 {
 
 replication_manager::replication_manager(
     const std::string& p_initial_configuration_file,
     status_code* p_status)
+    : m_number_inotify_shards(1),
+      m_max_number_in_flight_replications(c_default_max_number_in_flight_replications),
+      m_replication_tasks_thread_pool_options(c_default_max_number_replication_tasks_threads),
+      m_dispatcher_thread_pool_options(c_default_max_number_dispatcher_threads)
 {
     *p_status = parse_initial_configuration_file_into_memory(
         p_initial_configuration_file);
@@ -27,6 +36,11 @@ replication_manager::replication_manager(
         return;
     }
 
+    //
+    // Shards without any source directory would only hold an idle offloader thread.
+    //
+    m_number_inotify_shards = std::min<uint32>(m_number_inotify_shards, m_replication_engines.size());
+
     // NOTE: This has to be taken out from here and moved to the initialization segment after the initialization of the filesystem monitor.
     //
     // Initiate an initial full sync on all directories on startup.
@@ -47,7 +61,7 @@ replication_manager::replication_manager(
     //
     m_replication_tasks_thread_pool = std::make_shared<thread_pool>(
         p_status,
-        c_replication_tasks_thread_pool_size);
+        m_replication_tasks_thread_pool_options);
 
     if (status::failed(*p_status))
     {
@@ -57,10 +71,51 @@ replication_manager::replication_manager(
         return;
     }
 
+    //
+    // Every worker thread of the replication tasks thread pool is a running slot of the weighted fair scheduler.
+    //
+    m_weighted_fair_scheduler = std::make_shared<weighted_fair_scheduler>(
+        m_replication_tasks_thread_pool,
+        m_replication_tasks_thread_pool_options.m_max_number_threads);
+
     for (replication_engine& replication_engine : m_replication_engines)
     {
         replication_engine.attach_replication_tasks_thread_pool(
             m_replication_tasks_thread_pool);
+
+        replication_engine.attach_weighted_fair_scheduler(
+            m_weighted_fair_scheduler);
+    }
+
+    const bool io_uring_transfer_engine_required = std::any_of(m_replication_engines.begin(), m_replication_engines.end(),
+        [](const replication_engine& p_replication_engine)
+        {
+            return p_replication_engine.requires_io_uring_transfer_engine();
+        });
+
+    if (io_uring_transfer_engine_required)
+    {
+        status_code io_uring_status = status::success;
+
+        m_io_uring_transfer_engine = std::make_shared<io_uring_transfer_engine>(
+            &io_uring_status);
+
+        if (status::failed(io_uring_status))
+        {
+            //
+            // Io_uring may be unavailable or restricted; engines fall back to the native copy path.
+            //
+            m_io_uring_transfer_engine.reset();
+
+            logger::log(log_level::warning, std::format("Io_uring transfer engine could not be started; falling back to native transfers. Status={:#X}.",
+                io_uring_status));
+        }
+
+        for (replication_engine& replication_engine : m_replication_engines)
+        {
+            replication_engine.attach_io_uring_transfer_engine(
+                m_io_uring_transfer_engine);
+        }
     }
 }
 
@@ -92,31 +147,82 @@ replication_manager::execute_full_sync()
     return status;
 }
 
+const thread_pool_options&
+replication_manager::get_dispatcher_thread_pool_options() const
+{
+    return m_dispatcher_thread_pool_options;
+}
+
+const std::shared_ptr<thread_pool>&
+replication_manager::get_replication_tasks_thread_pool() const
+{
+    return m_replication_tasks_thread_pool;
+}
+
+uint32
+replication_manager::get_number_inotify_shards() const
+{
+    return m_number_inotify_shards;
+}
+
+uint32
+replication_manager::get_max_number_in_flight_replications() const
+{
+    return m_max_number_in_flight_replications;
+}
+
+uint32
+replication_manager::get_inotify_shard_index(
+    uint32 p_replication_engine_index) const
+{
+    return p_replication_engine_index % m_number_inotify_shards;
+}
+
+file_descriptor
+replication_manager::get_routing_watch_descriptor(
+    uint32 p_inotify_shard_index,
+    file_descriptor p_watch_descriptor)
+{
+    return (p_watch_descriptor << c_inotify_shard_index_bits) | static_cast<file_descriptor>(p_inotify_shard_index);
+}
+
 void
 replication_manager::append_entry_to_replication_engines_router(
+    uint32 p_inotify_shard_index,
     file_descriptor p_watch_descriptor,
     uint32 p_replication_engine_index)
 {
     m_replication_engines_router.emplace(
-        p_watch_descriptor,
+        get_routing_watch_descriptor(p_inotify_shard_index, p_watch_descriptor),
         p_replication_engine_index);
 }
 
-void
+async_task<void>
 replication_manager::replication_tasks_entry_point(
     file_descriptor p_watch_descriptor,
-    std::unique_ptr<replication_task>&& p_replication_task)
+    replication_tasks_batch p_replication_tasks_batch,
+    async_mutex_turn p_submission_turn)
 {
-    logger::set_activity_id(p_replication_task->m_activity_id);
+    for (const std::unique_ptr<replication_task>& replication_task : p_replication_tasks_batch)
+    {
+        logger::set_activity_id(replication_task->m_activity_id);
 
-    logger::log(log_level::info, std::format("Received replication task to process. FilesystemObjectName={}.",
-        p_replication_task->get_filesystem_object_name()));
+        logger::log(log_level::info, std::format("Received replication task to process. FilesystemObjectName={}, BatchSize={}.",
+            replication_task->get_filesystem_object_name(),
+            p_replication_tasks_batch.size()));
+    }
 
-    status_code status = send_replication_task(
+    status_code status = co_await send_replication_tasks_batch(
         p_watch_descriptor,
-        p_replication_task);
+        p_replication_tasks_batch,
+        std::move(p_submission_turn));
 
-    p_replication_task->m_end_timestamp = timestamp::get_current_time();
+    const timestamp end_timestamp = timestamp::get_current_time();
+
+    for (std::unique_ptr<replication_task>& replication_task : p_replication_tasks_batch)
+    {
+        replication_task->m_end_timestamp = end_timestamp;
+    }
 
     if (status::succeeded(status))
     {
@@ -132,26 +238,275 @@ status_code
 replication_manager::parse_initial_configuration_file_into_memory(
     const std::string& p_initial_configuration_file)
 {
-    // Mock for now.
-    
-    directory source_directory("/home/jcjuarez/mock1");
+    std::ifstream configuration_file(p_initial_configuration_file);
+
+    if (!configuration_file.is_open())
+    {
+        logger::log(log_level::warning, std::format("Initial configuration file '{}' could not be opened; using the default mock directories.",
+            p_initial_configuration_file.c_str()));
+
+        // Mock for now.
+
+        directory source_directory("/home/jcjuarez/mock1");
+
+        std::vector<directory> target_directories {directory("/home/jcjuarez/mock2", true), directory("/home/jcjuarez/mock3", true)};
+
+        replication_engine replication_engine(
+            std::move(source_directory),
+            std::move(target_directories));
+
+        m_replication_engines.emplace_back(std::move(replication_engine));
+
+        return status::success;
+    }
+
+    //
+    // Each source line opens a replication engine which collects all target lines following it:
+    //
+    //   source <path> [parallel_copy_minimum_file_size=<bytes>] [monitor=inotify|fanotify] [coalescing_window_ms=<ms>]
+    //          [parallelism=<count>] [path_queue_depth=<count>] [weight=<count>] [reserved_concurrency=<count>]
+    //          [large_file_parallelism=<count>] [large_file_minimum_size=<bytes>]
+    //   target <path> [strategy=...] [compression=...] [compression_level=...] [checksum=...] [durability=...]
+    //          [delta_application=temporary|in_place]
+    //
+    // A standalone line shards the inotify monitored replication engines across several inotify instances:
+    //
+    //   inotify_shards <count>
+    //
+    // A standalone line bounds the replication tasks batches and rescans in flight, zero leaving them unbounded.
+    // Batches suspended off the thread pools still count, so the dispatcher holds ready filesystem events back
+    // once the bound is reached, just as it does on saturated thread pools:
+    //
+    //   max_in_flight_replications <count>
+    //
+    // Standalone lines size the replication tasks and dispatcher thread pools between their min and max number of threads:
+    //
+    //   replication_thread_pool|dispatcher_thread_pool [min_threads=<count>] [max_threads=<count>] [growth_queue_latency_ms=<ms>] [idle_timeout_ms=<ms>]
+    //          [max_queued_tasks=<count>] [overflow_policy=block|reject|spill]
+    //
+    std::string source_directory_path;
+    std::vector<directory> target_directories;
+    replication_engine_options source_replication_engine_options;
+    std::string line;
+    uint64 line_number = 0;
 
-    std::vector<directory> target_directories {directory("/home/jcjuarez/mock2"), directory("/home/jcjuarez/mock3")};
+    while (std::getline(configuration_file, line))
+    {
+        ++line_number;
 
-    replication_engine replication_engine(
-        std::move(source_directory),
-        std::move(target_directories));
+        std::istringstream line_stream(line);
+        std::string keyword;
+        std::string path;
 
-    // Create move constuctor for replication engine as well.
-    m_replication_engines.emplace_back(std::move(replication_engine));
+        if (!(line_stream >> keyword) ||
+            keyword.starts_with('#'))
+        {
+            continue;
+        }
+
+        if (keyword == c_replication_thread_pool_keyword ||
+            keyword == c_dispatcher_thread_pool_keyword)
+        {
+            status_code status = parse_thread_pool_options(
+                line_stream,
+                keyword == c_replication_thread_pool_keyword ? &m_replication_tasks_thread_pool_options : &m_dispatcher_thread_pool_options);
+
+            if (status::failed(status))
+            {
+                return report_malformed_configuration_line(
+                    p_initial_configuration_file,
+                    line_number);
+            }
+
+            continue;
+        }
+
+        if (!(line_stream >> path) ||
+            (keyword != c_source_keyword && keyword != c_target_keyword && keyword != c_inotify_shards_keyword &&
+            keyword != c_max_in_flight_replications_keyword) ||
+            (keyword == c_target_keyword && source_directory_path.empty()))
+        {
+            return report_malformed_configuration_line(
+                p_initial_configuration_file,
+                line_number);
+        }
+
+        if (keyword == c_inotify_shards_keyword ||
+            keyword == c_max_in_flight_replications_keyword)
+        {
+            uint32 count = 0;
+            const std::from_chars_result parse_result = std::from_chars(path.data(), path.data() + path.size(), count);
+            std::string trailing_token;
+
+            if (parse_result.ec != std::errc() ||
+                parse_result.ptr != path.data() + path.size() ||
+                (keyword == c_inotify_shards_keyword && (count == 0 || count > c_max_number_inotify_shards)) ||
+                line_stream >> trailing_token)
+            {
+                return report_malformed_configuration_line(
+                    p_initial_configuration_file,
+                    line_number);
+            }
+
+            if (keyword == c_inotify_shards_keyword)
+            {
+                m_number_inotify_shards = count;
+            }
+            else
+            {
+                m_max_number_in_flight_replications = count;
+            }
+
+            continue;
+        }
+
+        if (keyword == c_source_keyword)
+        {
+            if (!source_directory_path.empty())
+            {
+                status_code status = add_replication_engine(
+                    source_directory_path,
+                    std::move(target_directories),
+                    source_replication_engine_options);
+
+                return_status_if_failed(status)
+            }
+
+            source_directory_path = path;
+            target_directories.clear();
+            source_replication_engine_options = replication_engine_options();
+        }
+
+        transport_profile target_transport_profile;
+        std::string option;
+
+        while (line_stream >> option)
+        {
+            const std::size_t separator_position = option.find('=');
+
+            if (separator_position == std::string::npos)
+            {
+                return report_malformed_configuration_line(
+                    p_initial_configuration_file,
+                    line_number);
+            }
+
+            const std::string key = option.substr(0, separator_position);
+            const std::string value = option.substr(separator_position + 1);
+
+            status_code status = status::success;
+
+            if (keyword == c_source_keyword)
+            {
+                status = source_replication_engine_options.set_option(key, value);
+            }
+            else
+            {
+                status = target_transport_profile.set_option(key, value);
+            }
+
+            if (status::failed(status))
+            {
+                return report_malformed_configuration_line(
+                    p_initial_configuration_file,
+                    line_number);
+            }
+        }
+
+        if (keyword == c_target_keyword)
+        {
+            directory target_directory(path, true);
+            target_directory.set_transport_profile(target_transport_profile);
+            target_directories.push_back(std::move(target_directory));
+        }
+    }
+
+    if (source_directory_path.empty())
+    {
+        return report_malformed_configuration_line(
+            p_initial_configuration_file,
+            line_number);
+    }
+
+    return add_replication_engine(
+        source_directory_path,
+        std::move(target_directories),
+        source_replication_engine_options);
+}
+
+status_code
+replication_manager::add_replication_engine(
+    const std::string& p_source_directory_path,
+    std::vector<directory>&& p_target_directories,
+    const replication_engine_options& p_replication_engine_options)
+{
+    if (p_target_directories.empty())
+    {
+        status_code status = status::malformed_configuration_file;
+
+        logger::log(log_level::error, std::format("Source directory has no target directories configured. "
+            "SourceDirectoryPath={}, Status={:#X}.",
+            p_source_directory_path,
+            status));
+
+        return status;
+    }
+
+    m_replication_engines.emplace_back(
+        directory(p_source_directory_path),
+        std::move(p_target_directories),
+        p_replication_engine_options);
 
     return status::success;
 }
 
 status_code
-replication_manager::send_replication_task(
+replication_manager::parse_thread_pool_options(
+    std::istringstream& p_line_stream,
+    thread_pool_options* p_thread_pool_options)
+{
+    std::string option;
+
+    while (p_line_stream >> option)
+    {
+        const std::size_t separator_position = option.find('=');
+
+        if (separator_position == std::string::npos)
+        {
+            return status::malformed_configuration_file;
+        }
+
+        status_code status = p_thread_pool_options->set_option(
+            option.substr(0, separator_position),
+            option.substr(separator_position + 1));
+
+        return_status_if_failed(status)
+    }
+
+    return p_thread_pool_options->validate();
+}
+
+status_code
+replication_manager::report_malformed_configuration_line(
+    const std::string& p_configuration_file,
+    const uint64 p_line_number)
+{
+    status_code status = status::malformed_configuration_file;
+
+    logger::log(log_level::error, std::format("Malformed initial configuration file line. "
+        "ConfigurationFile={}, LineNumber={}, Status={:#X}.",
+        p_configuration_file,
+        p_line_number,
+        status));
+
+    return status;
+}
+
+async_task<status_code>
+replication_manager::send_replication_tasks_batch(
     file_descriptor p_watch_descriptor,
-    std::unique_ptr<replication_task>& p_replication_task)
+    replication_tasks_batch& p_replication_tasks_batch,
+    async_mutex_turn p_submission_turn)
 {
     status_code status = status::success;
 
@@ -162,20 +517,63 @@ replication_manager::send_replication_task(
     {
         status = status::unknown_watch_descriptor;
 
-        p_replication_task->set_last_error_timestamp(timestamp::get_current_time());
+        const timestamp failure_time = timestamp::get_current_time();
 
-        logger::log(log_level::error, std::format("Watch descriptor is not present in the replication engines router. "
-            "FilesystemObjectName={}, WatchDescriptor={}, Status={:#X}.",
-            p_replication_task->get_filesystem_object_name(),
-            p_watch_descriptor,
-            status));
+        for (std::unique_ptr<replication_task>& replication_task : p_replication_tasks_batch)
+        {
+            replication_task->set_last_error_timestamp(failure_time);
 
-        return status;
+            logger::set_activity_id(replication_task->m_activity_id);
+
+            logger::log(log_level::error, std::format("Watch descriptor is not present in the replication engines router. "
+                "FilesystemObjectName={}, WatchDescriptor={}, Status={:#X}.",
+                replication_task->get_filesystem_object_name(),
+                p_watch_descriptor,
+                status));
+        }
+
+        co_return status;
     }
 
     replication_engine& replication_engine = m_replication_engines[m_replication_engines_router[p_watch_descriptor]];
     
-    return replication_engine.execute_replication_task(p_replication_task);
+    co_return co_await replication_engine.execute_replication_tasks_batch(
+        p_replication_tasks_batch,
+        std::move(p_submission_turn));
+}
+
+async_mutex_turn
+replication_manager::reserve_submission_turn(
+    file_descriptor p_watch_descriptor)
+{
+    auto replication_engine_index = m_replication_engines_router.find(p_watch_descriptor);
+
+    if (replication_engine_index == m_replication_engines_router.end())
+    {
+        return async_mutex_turn();
+    }
+
+    return m_replication_engines[replication_engine_index->second].reserve_submission_turn();
+}
+
+status_code
+replication_manager::collect_divergent_filesystem_objects(
+    file_descriptor p_watch_descriptor,
+    std::vector<std::pair<std::string, replication_action>>* p_divergent_filesystem_objects)
+{
+    auto replication_engine_index = m_replication_engines_router.find(p_watch_descriptor);
+
+    if (replication_engine_index == m_replication_engines_router.end())
+    {
+        logger::log(log_level::error, std::format("Watch descriptor is not present in the replication engines router. "
+            "WatchDescriptor={}, Status={:#X}.",
+            p_watch_descriptor,
+            status::unknown_watch_descriptor));
+
+        return status::unknown_watch_descriptor;
+    }
+
+    return m_replication_engines[replication_engine_index->second].collect_divergent_filesystem_objects(p_divergent_filesystem_objects);
 }
 
 } // namespace modula.
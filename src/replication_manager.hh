@@ -12,6 +12,7 @@
 #include "thread_pool.hh"
 #include "replication_engine.hh"
 
+#include <sstream>
 #include <unordered_map>
 
 namespace modula
@@ -45,22 +46,86 @@ public:
     execute_full_sync();
 
     //
-    // Appends an entry to the replication engines router.
+    // Returns the sizing options of the filesystem monitor dispatcher thread pool.
+    //
+    const thread_pool_options&
+    get_dispatcher_thread_pool_options() const;
+
+    //
+    // Returns the replication tasks thread pool shared by all replication engines.
+    //
+    const std::shared_ptr<thread_pool>&
+    get_replication_tasks_thread_pool() const;
+
+    //
+    // Returns the number of inotify instances the replication engines are sharded across.
+    //
+    uint32
+    get_number_inotify_shards() const;
+
+    //
+    // Returns the max number of replication tasks batches and rescans in flight before the
+    // filesystem monitor defers dispatching ready filesystem events. Zero leaves them unbounded.
+    //
+    uint32
+    get_max_number_in_flight_replications() const;
+
+    //
+    // Returns the inotify shard monitoring the source directory of a replication engine.
+    //
+    uint32
+    get_inotify_shard_index(
+        uint32 p_replication_engine_index) const;
+
+    //
+    // Returns the routing watch descriptor of a source directory watch descriptor. Watch descriptors are
+    // only unique within their inotify instance, so the shard index is folded into the low bits of the
+    // watch descriptor to keep routing watch descriptors unique across all inotify shards.
+    //
+    static
+    file_descriptor
+    get_routing_watch_descriptor(
+        uint32 p_inotify_shard_index,
+        file_descriptor p_watch_descriptor);
+
+    //
+    // Appends an entry to the replication engines router for a source directory watch descriptor of an inotify shard.
     // Must be called only from the filesystem monitor side.
     //
     void
     append_entry_to_replication_engines_router(
+        uint32 p_inotify_shard_index,
         file_descriptor p_watch_descriptor,
         uint32 p_replication_engine_index);
 
     //
-    // Replication entry point for replication tasks. Resources
-    // ownership is transfered from the filesystem monitor to this method.
+    // Replication entry point for batches of replication tasks targeting the same watch descriptor. Resources
+    // ownership is transfered from the filesystem monitor to the coroutine frame, which keeps the batch alive
+    // while its replication is in flight.
     //
-    void
+    async_task<void>
     replication_tasks_entry_point(
         file_descriptor p_watch_descriptor,
-        std::unique_ptr<replication_task>&& p_replication_task);
+        replication_tasks_batch p_replication_tasks_batch,
+        async_mutex_turn p_submission_turn);
+
+    //
+    // Reserves the next submission turn of the replication engine a watch descriptor is routed to. Replication tasks
+    // batches are submitted to a replication engine in the order their turns were reserved, so the turn is to be reserved
+    // where the batch order is decided. Holds no turn when the watch descriptor is unknown.
+    //
+    async_mutex_turn
+    reserve_submission_turn(
+        file_descriptor p_watch_descriptor);
+
+    //
+    // Collects the filesystem objects which diverged between the source directory and the
+    // target directories of the replication engine routed by the provided watch descriptor.
+    //
+    status_code
+    collect_divergent_filesystem_objects(
+        file_descriptor p_watch_descriptor,
+        std::vector<std::pair<std::string, replication_action>>* p_divergent_filesystem_objects);
 
 private:
 
@@ -73,12 +138,40 @@ private:
         const std::string& p_configuration_file);
 
     //
-    // Sends a replication task to its corresponding replication engine for execution.
+    // Creates a replication engine for a parsed source directory and its target directories.
     //
     status_code
-    send_replication_task(
+    add_replication_engine(
+        const std::string& p_source_directory_path,
+        std::vector<directory>&& p_target_directories,
+        const replication_engine_options& p_replication_engine_options);
+
+    //
+    // Parses the options of a thread pool configuration line.
+    //
+    static
+    status_code
+    parse_thread_pool_options(
+        std::istringstream& p_line_stream,
+        thread_pool_options* p_thread_pool_options);
+
+    //
+    // Logs a malformed line of the initial configuration file.
+    //
+    static
+    status_code
+    report_malformed_configuration_line(
+        const std::string& p_configuration_file,
+        const uint64 p_line_number);
+
+    //
+    // Sends a batch of replication tasks to its corresponding replication engine for execution.
+    //
+    async_task<status_code>
+    send_replication_tasks_batch(
         file_descriptor p_watch_descriptor,
-        std::unique_ptr<replication_task>& p_replication_task);
+        replication_tasks_batch& p_replication_tasks_batch,
+        async_mutex_turn p_submission_turn);
 
     //
     // Container for holding replication engines.
@@ -86,10 +179,21 @@ private:
     std::vector<replication_engine> m_replication_engines;
 
     //
-    // Map router for replication engines. Maps a watch descriptor to the replication engine index.
+    // Map router for replication engines. Maps a routing watch descriptor to the replication engine index.
     //
     std::unordered_map<file_descriptor, uint32> m_replication_engines_router;
 
+    //
+    // Number of inotify instances the replication engines are sharded across. Replication
+    // engines are assigned to inotify shards in a round-robin fashion, in configuration order.
+    //
+    uint32 m_number_inotify_shards;
+
+    //
+    // Max number of replication tasks batches and rescans in flight. Zero leaves them unbounded.
+    //
+    uint32 m_max_number_in_flight_replications;
+
     //
     // Thread pool for executing concurrent replication tasks by replication engines.
     // This is shared across all instances of replication engines present in the system.
@@ -97,9 +201,80 @@ private:
     std::shared_ptr<thread_pool> m_replication_tasks_thread_pool;
 
     //
-    // Number of threads to be used by the replication tasks thread pool.
+    // Scheduler sharing the replication tasks thread pool among the replication engines in proportion to their weights.
+    //
+    std::shared_ptr<weighted_fair_scheduler> m_weighted_fair_scheduler;
+
+    //
+    // Sizing options of the replication tasks thread pool.
+    //
+    thread_pool_options m_replication_tasks_thread_pool_options;
+
+    //
+    // Sizing options of the filesystem monitor dispatcher thread pool.
+    //
+    thread_pool_options m_dispatcher_thread_pool_options;
+
+    //
+    // Io_uring transfer engine shared by all replication engines using the io_uring synchronization strategy.
+    // Only started when at least one replication engine requires it.
+    //
+    std::shared_ptr<io_uring_transfer_engine> m_io_uring_transfer_engine;
+
+    //
+    // Default max number of threads of the replication tasks thread pool.
+    //
+    static constexpr uint16 c_default_max_number_replication_tasks_threads = 500u;
+
+    //
+    // Default max number of threads of the filesystem monitor dispatcher thread pool.
+    //
+    static constexpr uint16 c_default_max_number_dispatcher_threads = 200u;
+
+    //
+    // Default max number of replication tasks batches and rescans in flight.
+    //
+    static constexpr uint32 c_default_max_number_in_flight_replications = 1024u;
+
+    //
+    // Configuration file keyword for declaring a source directory.
+    //
+    static constexpr const character* c_source_keyword = "source";
+
+    //
+    // Configuration file keyword for declaring a target directory of the last declared source directory.
+    //
+    static constexpr const character* c_target_keyword = "target";
+
+    //
+    // Configuration file keyword for declaring the number of inotify shards.
+    //
+    static constexpr const character* c_inotify_shards_keyword = "inotify_shards";
+
+    //
+    // Configuration file keyword for declaring the max number of in-flight replications.
+    //
+    static constexpr const character* c_max_in_flight_replications_keyword = "max_in_flight_replications";
+
+    //
+    // Configuration file keyword for sizing the replication tasks thread pool.
+    //
+    static constexpr const character* c_replication_thread_pool_keyword = "replication_thread_pool";
+
+    //
+    // Configuration file keyword for sizing the filesystem monitor dispatcher thread pool.
+    //
+    static constexpr const character* c_dispatcher_thread_pool_keyword = "dispatcher_thread_pool";
+
+    //
+    // Number of low bits of a routing watch descriptor holding the inotify shard index.
+    //
+    static constexpr uint32 c_inotify_shard_index_bits = 6u;
+
+    //
+    // Max number of inotify shards.
     //
-    static constexpr uint16 c_replication_tasks_thread_pool_size = 500u;
+    static constexpr uint32 c_max_number_inotify_shards = 1u << c_inotify_shard_index_bits;
     
 };
 
@@ -13,14 +13,17 @@ namespace modula
 replication_task::replication_task(
     const replication_action p_replication_action,
     const std::string& p_filesystem_object_name,
-    const std::string& p_activity_id)
-     : m_replication_action(p_replication_action),
-       m_filesystem_object_name(p_filesystem_object_name),
+    const std::string& p_activity_id,
+    const std::string& p_previous_filesystem_object_name)
+     : m_end_timestamp(timestamp::generate_invalid_timestamp()),
+       m_filesystem_object_path(""),
+       m_filesystem_object_size(0),
        m_activity_id(p_activity_id),
-       m_creation_timestamp(timestamp::get_current_time()),
-       m_end_timestamp(timestamp::generate_invalid_timestamp()),
+       m_replication_action(p_replication_action),
+       m_filesystem_object_name(p_filesystem_object_name),
+       m_previous_filesystem_object_name(p_previous_filesystem_object_name),
        m_last_error_timestamp(timestamp::generate_invalid_timestamp()),
-       m_filesystem_object_path("")
+       m_creation_timestamp(timestamp::get_current_time())
 {}
 
 replication_action
@@ -35,6 +38,12 @@ replication_task::get_filesystem_object_name() const
     return m_filesystem_object_name.c_str();
 }
 
+const character*
+replication_task::get_previous_filesystem_object_name() const
+{
+    return m_previous_filesystem_object_name.c_str();
+}
+
 timestamp
 replication_task::get_creation_time() const
 {
@@ -13,6 +13,7 @@
 
 #include <mutex>
 #include <string>
+#include <vector>
 #include <memory>
 
 namespace modula
@@ -44,10 +45,15 @@ enum class replication_action : uint8
     //
     full_sync = 3,
 
+    //
+    // File needs to be renamed from its previous name.
+    //
+    move = 4,
+
     //
     // Invalid replication action.
     //
-    invalid = 4
+    invalid = 5
     
 };
 
@@ -65,7 +71,8 @@ public:
     replication_task(
         const replication_action p_replication_action,
         const std::string& p_filesystem_object_name,
-        const std::string& p_activity_id);
+        const std::string& p_activity_id,
+        const std::string& p_previous_filesystem_object_name = "");
 
     //
     // Gets the replication action of the replication task.
@@ -79,6 +86,12 @@ public:
     const character*
     get_filesystem_object_name() const;
 
+    //
+    // Gets the name the filesystem object had before being moved. Empty for any other replication action.
+    //
+    const character*
+    get_previous_filesystem_object_name() const;
+
     //
     // Gets the creation time of the replication task.
     //
@@ -108,6 +121,11 @@ public:
     //
     std::string m_filesystem_object_path;
 
+    //
+    // Size in bytes of the filesystem object to replicate when the replication task was prepared. Zero for anything but regular files.
+    //
+    uint64 m_filesystem_object_size;
+
     //
     // Activity ID corresponding to the replication task.
     //
@@ -125,6 +143,11 @@ private:
     //
     std::string m_filesystem_object_name;
 
+    //
+    // Name of the filesystem object before being moved.
+    //
+    std::string m_previous_filesystem_object_name;
+
     //
     // Lock for synchronizing access across threads.
     //
@@ -143,6 +166,11 @@ private:
     
 };
 
+//
+// Batch of replication tasks gathered within a single dispatching window for the same replication engine.
+//
+using replication_tasks_batch = std::vector<std::unique_ptr<replication_task>>;
+
 } // namespace modula.
 
 #endif
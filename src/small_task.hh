@@ -0,0 +1,254 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'small_task.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef SMALL_TASK_
+#define SMALL_TASK_
+
+#include "utilities.hh"
+
+#include <new>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+namespace modula
+{
+
+//
+// Move-only type-erased callable taking no arguments. Callables fitting the inline buffer are stored within the
+// small task itself, so wrapping a lambda with a few captures, a coroutine handle or a packaged task never reaches
+// the heap; larger callables, or those which may throw when moved, are allocated separately instead.
+// Unlike std::function, the callable is not required to be copyable.
+//
+class small_task
+{
+
+public:
+
+    //
+    // Size of the inline buffer, leaving the whole small task within a cache line.
+    //
+    static constexpr uint64 c_inline_buffer_size = 48u;
+
+    //
+    // Constructor. Creates an empty small task.
+    //
+    small_task() noexcept
+        : m_operations(nullptr)
+    {}
+
+    //
+    // Constructor. Takes ownership of a callable.
+    //
+    template<typename Function>
+    requires (!std::is_same_v<std::decay_t<Function>, small_task> &&
+        std::is_invocable_v<std::decay_t<Function>&>)
+    small_task(
+        Function&& p_function)
+        : m_operations(&c_operations<std::decay_t<Function>>)
+    {
+        using callable = std::decay_t<Function>;
+
+        if constexpr (is_stored_inline<callable>())
+        {
+            ::new (static_cast<void*>(m_buffer)) callable(std::forward<Function>(p_function));
+        }
+        else
+        {
+            ::new (static_cast<void*>(m_buffer)) callable*(new callable(std::forward<Function>(p_function)));
+        }
+    }
+
+    //
+    // Move constructor. Leaves the moved-from small task empty.
+    //
+    small_task(
+        small_task&& p_small_task) noexcept
+        : m_operations(std::exchange(p_small_task.m_operations, nullptr))
+    {
+        if (m_operations != nullptr)
+        {
+            m_operations->m_move(m_buffer, p_small_task.m_buffer);
+        }
+    }
+
+    //
+    // Move assignment operator. Leaves the moved-from small task empty.
+    //
+    small_task&
+    operator=(
+        small_task&& p_small_task) noexcept
+    {
+        if (this != &p_small_task)
+        {
+            reset();
+
+            m_operations = std::exchange(p_small_task.m_operations, nullptr);
+
+            if (m_operations != nullptr)
+            {
+                m_operations->m_move(m_buffer, p_small_task.m_buffer);
+            }
+        }
+
+        return *this;
+    }
+
+    small_task(
+        const small_task&) = delete;
+
+    small_task&
+    operator=(
+        const small_task&) = delete;
+
+    //
+    // Destructor. Releases the owned callable.
+    //
+    ~small_task()
+    {
+        reset();
+    }
+
+    //
+    // Invokes the owned callable. The small task must not be empty.
+    //
+    void
+    operator()()
+    {
+        m_operations->m_invoke(m_buffer);
+    }
+
+    //
+    // Returns whether the small task owns a callable.
+    //
+    explicit
+    operator bool() const noexcept
+    {
+        return m_operations != nullptr;
+    }
+
+    //
+    // Releases the owned callable, leaving the small task empty.
+    //
+    void
+    reset() noexcept
+    {
+        if (m_operations != nullptr)
+        {
+            m_operations->m_destroy(m_buffer);
+            m_operations = nullptr;
+        }
+    }
+
+private:
+
+    //
+    // Operations on the callable type held by a small task.
+    //
+    struct operations
+    {
+
+        //
+        // Invokes the callable stored in the buffer.
+        //
+        void (*m_invoke)(std::byte*);
+
+        //
+        // Moves the callable stored in the source buffer into the destination buffer, destroying the source one.
+        //
+        void (*m_move)(std::byte*, std::byte*) noexcept;
+
+        //
+        // Destroys the callable stored in the buffer.
+        //
+        void (*m_destroy)(std::byte*) noexcept;
+
+    };
+
+    //
+    // Returns whether a callable type is stored within the inline buffer.
+    //
+    template<typename Callable>
+    static constexpr
+    bool
+    is_stored_inline()
+    {
+        return sizeof(Callable) <= c_inline_buffer_size &&
+            alignof(Callable) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible_v<Callable>;
+    }
+
+    //
+    // Returns the callable stored in a buffer.
+    //
+    template<typename Callable>
+    static
+    Callable*
+    get_callable(
+        std::byte* p_buffer) noexcept
+    {
+        if constexpr (is_stored_inline<Callable>())
+        {
+            return std::launder(reinterpret_cast<Callable*>(p_buffer));
+        }
+        else
+        {
+            return *std::launder(reinterpret_cast<Callable**>(p_buffer));
+        }
+    }
+
+    //
+    // Operations on a callable type, shared by all small tasks holding it.
+    //
+    template<typename Callable>
+    static constexpr operations c_operations
+    {
+        [](std::byte* p_buffer)
+        {
+            (*get_callable<Callable>(p_buffer))();
+        },
+        [](std::byte* p_destination_buffer, std::byte* p_source_buffer) noexcept
+        {
+            if constexpr (is_stored_inline<Callable>())
+            {
+                Callable* source_callable = get_callable<Callable>(p_source_buffer);
+                ::new (static_cast<void*>(p_destination_buffer)) Callable(std::move(*source_callable));
+                source_callable->~Callable();
+            }
+            else
+            {
+                ::new (static_cast<void*>(p_destination_buffer)) Callable*(get_callable<Callable>(p_source_buffer));
+            }
+        },
+        [](std::byte* p_buffer) noexcept
+        {
+            if constexpr (is_stored_inline<Callable>())
+            {
+                get_callable<Callable>(p_buffer)->~Callable();
+            }
+            else
+            {
+                delete get_callable<Callable>(p_buffer);
+            }
+        }
+    };
+
+    //
+    // Storage for the callable, or for a pointer to it when allocated separately.
+    //
+    alignas(std::max_align_t) std::byte m_buffer[c_inline_buffer_size];
+
+    //
+    // Operations on the owned callable type, or null when the small task is empty.
+    //
+    const operations* m_operations;
+
+};
+
+} // namespace modula.
+
+#endif
@@ -0,0 +1,184 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'spsc_ring_buffer.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef SPSC_RING_BUFFER_
+#define SPSC_RING_BUFFER_
+
+#include "utilities.hh"
+
+#include <atomic>
+#include <vector>
+#include <utility>
+
+namespace modula
+{
+
+//
+// Bounded lock-free ring buffer class for handing elements from a single producer thread to a single consumer thread.
+// The capacity is rounded up to a power of two so that slot indexes are computed through masking.
+//
+template<typename T>
+class spsc_ring_buffer
+{
+
+public:
+
+    //
+    // Constructor. Preallocates all slots of the ring buffer.
+    //
+    explicit
+    spsc_ring_buffer(
+        const uint64 p_capacity)
+        : m_slots(round_up_to_power_of_two(p_capacity)),
+          m_mask(m_slots.size() - 1),
+          m_head(0),
+          m_cached_tail(0),
+          m_tail(0),
+          m_cached_head(0)
+    {}
+
+    //
+    // Pushes an element into the ring buffer. Only callable from the producer thread.
+    // Returns false without consuming the element when the ring buffer is full.
+    //
+    bool
+    try_push(
+        T&& p_element)
+    {
+        const uint64 tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_cached_head == m_slots.size())
+        {
+            //
+            // Refresh the consumer position only when the ring buffer looks full.
+            //
+            m_cached_head = m_head.load(std::memory_order_acquire);
+
+            if (tail - m_cached_head == m_slots.size())
+            {
+                return false;
+            }
+        }
+
+        m_slots[tail & m_mask] = std::move(p_element);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //
+    // Pops an element from the ring buffer. Only callable from the consumer thread.
+    // Returns false when the ring buffer is empty.
+    //
+    bool
+    try_pop(
+        T* p_element)
+    {
+        const uint64 head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_cached_tail)
+        {
+            //
+            // Refresh the producer position only when the ring buffer looks empty.
+            //
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+
+            if (head == m_cached_tail)
+            {
+                return false;
+            }
+        }
+
+        *p_element = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //
+    // Returns the number of elements held by the ring buffer. Callable from any thread;
+    // the value is a snapshot which may be stale by the time it is observed.
+    //
+    uint64
+    get_size() const
+    {
+        const uint64 head = m_head.load(std::memory_order_acquire);
+        const uint64 tail = m_tail.load(std::memory_order_acquire);
+
+        return tail > head ? tail - head : 0;
+    }
+
+    //
+    // Returns the max number of elements the ring buffer can hold.
+    //
+    uint64
+    get_capacity() const
+    {
+        return m_slots.size();
+    }
+
+private:
+
+    //
+    // Cache line size used for separating the producer and consumer positions.
+    //
+    static constexpr uint64 c_cache_line_size = 64u;
+
+    //
+    // Rounds a capacity up to the next power of two.
+    //
+    static
+    uint64
+    round_up_to_power_of_two(
+        const uint64 p_capacity)
+    {
+        uint64 capacity = 1;
+
+        while (capacity < p_capacity)
+        {
+            capacity <<= 1;
+        }
+
+        return capacity;
+    }
+
+    //
+    // Preallocated slots of the ring buffer.
+    //
+    std::vector<T> m_slots;
+
+    //
+    // Mask for mapping positions into slot indexes.
+    //
+    const uint64 m_mask;
+
+    //
+    // Consumer position. Kept on its own cache line along with the consumer
+    // copy of the producer position to avoid false sharing across threads.
+    //
+    alignas(c_cache_line_size) std::atomic<uint64> m_head;
+
+    //
+    // Last producer position observed by the consumer.
+    //
+    uint64 m_cached_tail;
+
+    //
+    // Producer position, along with the producer copy of the consumer position.
+    //
+    alignas(c_cache_line_size) std::atomic<uint64> m_tail;
+
+    //
+    // Last consumer position observed by the producer.
+    //
+    uint64 m_cached_head;
+
+};
+
+} // namespace modula.
+
+#endif
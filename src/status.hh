@@ -190,6 +190,76 @@ public:
     //
     static constexpr status_code rsync_spawned_process_failed = 0x8'0000021;
 
+    //
+    // The native synchronization failed to copy a filesystem object.
+    //
+    static constexpr status_code native_copy_failed = 0x8'0000022;
+
+    //
+    // The native synchronization failed to remove a filesystem object.
+    //
+    static constexpr status_code native_remove_failed = 0x8'0000023;
+
+    //
+    // The filesystem object type is not supported by the native synchronization.
+    //
+    static constexpr status_code unsupported_filesystem_object_type = 0x8'0000024;
+
+    //
+    // Failed to create the files list for a batched rsync process.
+    //
+    static constexpr status_code rsync_files_list_creation_failed = 0x8'0000025;
+
+    //
+    // The delta transfer engine failed to compute or apply a file delta.
+    //
+    static constexpr status_code delta_transfer_failed = 0x8'0000026;
+
+    //
+    // Failed to set up the io_uring instance.
+    //
+    static constexpr status_code io_uring_startup_failed = 0x8'0000027;
+
+    //
+    // An io_uring transfer operation failed.
+    //
+    static constexpr status_code io_uring_transfer_failed = 0x8'0000028;
+
+    //
+    // The configuration file could not be parsed.
+    //
+    static constexpr status_code malformed_configuration_file = 0x8'0000029;
+
+    //
+    // The content of a replicated file does not match its source file.
+    //
+    static constexpr status_code checksum_verification_failed = 0x8'0000030;
+
+    //
+    // The eventfd instance could not be started.
+    //
+    static constexpr status_code eventfd_startup_failed = 0x8'0000031;
+
+    //
+    // The fanotify instance could not be started or could not mark a source directory filesystem.
+    //
+    static constexpr status_code fanotify_startup_failed = 0x8'0000032;
+
+    //
+    // The kernel filesystem events queue overflowed and filesystem events were lost.
+    //
+    static constexpr status_code kernel_events_queue_overflow = 0x8'0000033;
+
+    //
+    // A source or target directory could not be rescanned.
+    //
+    static constexpr status_code rescan_failed = 0x8'0000034;
+
+    //
+    // A moved filesystem object could not be brought up to date on a target directory through a rename alone.
+    //
+    static constexpr status_code move_fallback_required = 0x8'0000035;
+
 };
 
 } // namespace modula.
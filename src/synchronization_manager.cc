@@ -6,11 +6,24 @@
 // *************************************
 
 #include "logger.hh"
+#include "fan_out_pipeline.hh"
 #include "replication_task.hh"
+#include "delta_transfer_engine.hh"
 #include "synchronization_manager.hh"
 
 #include <regex>
+#include <chrono>
+#include <sstream>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <sys/stat.h>
+#include <filesystem>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <unordered_map>
 
 namespace modula
 {
@@ -20,54 +33,374 @@ synchronization_result::synchronization_result()
       m_start_timestamp(timestamp::generate_invalid_timestamp()),
       m_end_timestamp(timestamp::generate_invalid_timestamp()),
       m_bytes_transferred(0),
-      m_bytes_per_second(0.0)
+      m_bytes_per_second(0.0),
+      m_delta_bytes(0),
+      m_literal_bytes(0),
+      m_reflinked_bytes(0),
+      m_logical_bytes(0),
+      m_allocated_bytes(0)
 {}
 
-synchronization_result
+synchronization_options::synchronization_options()
+    : m_io_uring_transfer_engine(nullptr),
+      m_thread_pool(nullptr),
+      m_parallel_copy_minimum_file_size(0)
+{}
+
+async_task<synchronization_result>
 synchronization_manager::execute_synchronization_task(
-    const character* p_target_directory_path,
-    std::unique_ptr<replication_task>& p_replication_task)
+    const directory& p_target_directory,
+    std::unique_ptr<replication_task>& p_replication_task,
+    const synchronization_options& p_synchronization_options)
 {
-    static thread_local character rsync_result_buffer[c_rsync_result_buffer_size];
+    const character* target_directory_path = p_target_directory.get_path().c_str();
 
-    std::string rsync_result;
+    if (p_replication_task->get_replication_action() == replication_action::move)
+    {
+        synchronization_result move_synchronization_result = execute_move_synchronization_task(
+            p_target_directory,
+            p_replication_task);
+
+        if (!status::is_same(move_synchronization_result.m_status, status::move_fallback_required))
+        {
+            co_return move_synchronization_result;
+        }
+
+        logger::log(log_level::info, std::format("Moved filesystem object could not be replicated through a rename alone; copying it instead. "
+            "FilesystemObjectPath={}, PreviousFilesystemObjectName={}, TargetDirectoryPath={}.",
+            p_replication_task->m_filesystem_object_path,
+            p_replication_task->get_previous_filesystem_object_name(),
+            target_directory_path));
+    }
+
+    if (p_target_directory.get_transport_profile().m_synchronization_strategy == synchronization_strategy::rsync)
+    {
+        co_return execute_rsync_synchronization_task(
+            p_target_directory,
+            p_replication_task);
+    }
+
+    synchronization_result filesytem_object_synchronization_result = co_await execute_native_synchronization_task(
+        p_target_directory,
+        p_replication_task,
+        p_synchronization_options);
+
+    if (status::is_same(filesytem_object_synchronization_result.m_status, status::unsupported_filesystem_object_type))
+    {
+        //
+        // Special filesystem objects are left to rsync, which knows how to replicate them.
+        //
+        logger::log(log_level::warning, std::format("Filesystem object type is not supported by the native synchronization; falling back to rsync. "
+            "FilesystemObjectPath={}, TargetDirectoryPath={}.",
+            p_replication_task->m_filesystem_object_path,
+            target_directory_path));
+
+        co_return execute_rsync_synchronization_task(
+            p_target_directory,
+            p_replication_task);
+    }
+
+    co_return filesytem_object_synchronization_result;
+}
+
+bool
+synchronization_manager::is_temporary_file_name(
+    const std::string_view p_filesystem_object_name)
+{
+    //
+    // The template suffix is replaced by mkostemp with as many random characters.
+    //
+    const std::string_view temporary_file_name_template = c_temporary_file_name_template;
+    const std::string_view temporary_file_name_prefix = temporary_file_name_template.substr(0, temporary_file_name_template.find('X'));
+
+    return p_filesystem_object_name.size() == temporary_file_name_template.size() &&
+        p_filesystem_object_name.starts_with(temporary_file_name_prefix);
+}
+
+bool
+synchronization_manager::is_fan_out_applicable(
+    const replication_task* p_replication_task)
+{
+    if (p_replication_task->get_replication_action() == replication_action::remove ||
+        p_replication_task->get_replication_action() == replication_action::move)
+    {
+        return false;
+    }
+
+    struct stat source_stat;
+
+    if (utilities::system_call_failed(lstat(p_replication_task->m_filesystem_object_path.c_str(), &source_stat)) ||
+        !S_ISREG(source_stat.st_mode))
+    {
+        return false;
+    }
+
+    return p_replication_task->get_replication_action() != replication_action::update ||
+        static_cast<uint64>(source_stat.st_size) < c_delta_transfer_minimum_file_size;
+}
+
+std::vector<synchronization_result>
+synchronization_manager::execute_fan_out_synchronization_task(
+    const std::vector<directory>& p_target_directories,
+    std::unique_ptr<replication_task>& p_replication_task,
+    thread_pool* p_thread_pool)
+{
+    std::vector<synchronization_result> synchronization_results(p_target_directories.size());
+    const std::string& source_filesystem_object_path = p_replication_task->m_filesystem_object_path;
+
+    //
+    // Set synchronozation start time.
+    //
+    const timestamp start_timestamp = timestamp::get_current_time();
+    const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    for (synchronization_result& target_synchronization_result : synchronization_results)
+    {
+        target_synchronization_result.m_start_timestamp = start_timestamp;
+    }
+
+    status_code source_status = status::success;
+    struct stat source_stat;
+
+    file_descriptor source_file_descriptor = open(
+        source_filesystem_object_path.c_str(),
+        O_RDONLY | O_CLOEXEC);
+
+    if (!utilities::is_file_descriptor_valid(source_file_descriptor) ||
+        utilities::system_call_failed(fstat(source_file_descriptor, &source_stat)))
+    {
+        source_status = errno == ENOENT ? status::filesystem_object_does_not_exist : status::native_copy_failed;
+
+        logger::log(log_level::error, std::format("Failed to open the source file for fan-out replication. "
+            "FilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+            source_filesystem_object_path,
+            std::strerror(errno),
+            errno,
+            source_status));
+    }
+
+    //
+    // Open one temporary file per target directory; only the targets with a
+    // temporary file take part in the pipeline, in the same relative order.
+    //
+    std::vector<std::string> target_filesystem_object_paths(p_target_directories.size());
+    std::vector<std::string> temporary_file_paths(p_target_directories.size());
+    std::vector<file_descriptor> target_file_descriptors;
+    std::vector<uint32> pipeline_target_indices;
+
+    for (uint32 target_index = 0; target_index < p_target_directories.size() && status::succeeded(source_status); ++target_index)
+    {
+        target_filesystem_object_paths[target_index] = std::format("{}/{}",
+            p_target_directories[target_index].get_path(),
+            p_replication_task->get_filesystem_object_name());
+
+        file_descriptor target_file_descriptor = create_temporary_file(
+            target_filesystem_object_paths[target_index],
+            &temporary_file_paths[target_index]);
+
+        if (!utilities::is_file_descriptor_valid(target_file_descriptor))
+        {
+            synchronization_results[target_index].m_status = status::native_copy_failed;
+
+            logger::log(log_level::error, std::format("Failed to create a temporary file for fan-out replication. "
+                "FilesystemObjectPath={}, TargetFilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+                source_filesystem_object_path,
+                target_filesystem_object_paths[target_index],
+                std::strerror(errno),
+                errno,
+                synchronization_results[target_index].m_status));
+
+            continue;
+        }
+
+        target_file_descriptors.push_back(target_file_descriptor);
+        pipeline_target_indices.push_back(target_index);
+    }
+
+    if (status::succeeded(source_status))
+    {
+        fan_out_pipeline pipeline(
+            source_file_descriptor,
+            source_stat.st_size,
+            target_file_descriptors);
+
+        source_status = pipeline.execute(p_thread_pool);
+
+        for (uint32 pipeline_index = 0; pipeline_index < pipeline_target_indices.size(); ++pipeline_index)
+        {
+            const uint32 target_index = pipeline_target_indices[pipeline_index];
+            synchronization_result& target_synchronization_result = synchronization_results[target_index];
+
+            status_code status = status::failed(source_status) ? source_status : pipeline.get_target_status(pipeline_index);
+
+            target_synchronization_result.m_literal_bytes = pipeline.get_target_bytes_transferred(pipeline_index);
+            target_synchronization_result.m_bytes_transferred = target_synchronization_result.m_literal_bytes;
+            target_synchronization_result.m_logical_bytes = source_stat.st_size;
+            target_synchronization_result.m_allocated_bytes = utilities::get_allocated_size(target_file_descriptors[pipeline_index]);
+
+            if (status::succeeded(status))
+            {
+                status = commit_temporary_file(
+                    target_file_descriptors[pipeline_index],
+                    temporary_file_paths[target_index],
+                    target_filesystem_object_paths[target_index],
+                    source_file_descriptor,
+                    source_stat,
+                    p_target_directories[target_index].get_transport_profile());
+            }
+            else
+            {
+                close(target_file_descriptors[pipeline_index]);
+                unlink(temporary_file_paths[target_index].c_str());
+            }
+
+            if (status::failed(status))
+            {
+                logger::log(log_level::error, std::format("Failed to replicate the file into the target path through the fan-out pipeline. "
+                    "FilesystemObjectPath={}, TargetFilesystemObjectPath={}, Status={:#X}.",
+                    source_filesystem_object_path,
+                    target_filesystem_object_paths[target_index],
+                    status));
+            }
+
+            target_synchronization_result.m_status = status;
+        }
+    }
+
+    if (utilities::is_file_descriptor_valid(source_file_descriptor))
+    {
+        close(source_file_descriptor);
+    }
+
+    const timestamp end_timestamp = timestamp::get_current_time();
+    const double_precision elapsed_seconds = std::chrono::duration<double_precision>(std::chrono::steady_clock::now() - start_time).count();
+
+    for (synchronization_result& target_synchronization_result : synchronization_results)
+    {
+        target_synchronization_result.m_end_timestamp = end_timestamp;
+
+        if (status::failed(source_status))
+        {
+            target_synchronization_result.m_status = source_status;
+        }
+
+        if (status::failed(target_synchronization_result.m_status))
+        {
+            p_replication_task->set_last_error_timestamp(end_timestamp);
+        }
+        else if (elapsed_seconds > 0.0)
+        {
+            target_synchronization_result.m_bytes_per_second = static_cast<single_precision>(
+                target_synchronization_result.m_bytes_transferred / elapsed_seconds);
+        }
+    }
+
+    return synchronization_results;
+}
+
+async_task<synchronization_result>
+synchronization_manager::execute_native_synchronization_task(
+    const directory& p_target_directory,
+    std::unique_ptr<replication_task>& p_replication_task,
+    const synchronization_options& p_synchronization_options)
+{
     synchronization_result filesytem_object_synchronization_result;
 
     //
     // Set synchronozation start time.
     //
     filesytem_object_synchronization_result.m_start_timestamp = timestamp::get_current_time();
+    const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    const std::string target_filesystem_object_path = std::format("{}/{}",
+        p_target_directory.get_path(),
+        p_replication_task->get_filesystem_object_name());
+
+    status_code status = status::success;
+
+    if (p_replication_task->get_replication_action() == replication_action::remove)
+    {
+        status = remove_filesystem_object(target_filesystem_object_path);
+    }
+    else
+    {
+        status = co_await copy_filesystem_object(
+            p_replication_task.get(),
+            p_target_directory,
+            target_filesystem_object_path,
+            p_synchronization_options,
+            &filesytem_object_synchronization_result);
+    }
+
+    filesytem_object_synchronization_result.m_status = status;
+    filesytem_object_synchronization_result.m_end_timestamp = timestamp::get_current_time();
+
+    if (status::failed(status))
+    {
+        p_replication_task->set_last_error_timestamp(filesytem_object_synchronization_result.m_end_timestamp);
+
+        co_return filesytem_object_synchronization_result;
+    }
+
+    const double_precision elapsed_seconds = std::chrono::duration<double_precision>(std::chrono::steady_clock::now() - start_time).count();
+
+    if (elapsed_seconds > 0.0)
+    {
+        filesytem_object_synchronization_result.m_bytes_per_second = static_cast<single_precision>(
+            filesytem_object_synchronization_result.m_bytes_transferred / elapsed_seconds);
+    }
+
+    co_return filesytem_object_synchronization_result;
+}
+
+synchronization_result
+synchronization_manager::execute_rsync_synchronization_task(
+    const directory& p_target_directory,
+    std::unique_ptr<replication_task>& p_replication_task)
+{
+    const character* target_directory_path = p_target_directory.get_path().c_str();
+    std::string rsync_result;
+    int32 rsync_process_exit_status = 0;
+    synchronization_result filesytem_object_synchronization_result;
 
     //
-    // Construct synchronization command to be executed.
+    // Set synchronozation start time.
     //
-    std::string rsync_command = std::format(
-        "rsync -avz {} {} 2>&1",
-        p_replication_task->m_filesystem_object_path,
-        p_target_directory_path);
+    filesytem_object_synchronization_result.m_start_timestamp = timestamp::get_current_time();
 
     //
-    // The pipe wrapper will only invoke the destructor in case of a midway
-    // processing error; the internal file handle will be released if possible.
+    // Construct synchronization command to be executed. Object names are paths relative to the source directory,
+    // which is marked with a dot directory so that rsync recreates them under the same relative path on the target.
     //
-    std::unique_ptr<FILE, decltype(&pclose)> rsync_pipe(
-        popen(rsync_command.c_str(), "r"),
-        pclose);
+    const std::string& filesystem_object_path = p_replication_task->m_filesystem_object_path;
+    const std::string_view filesystem_object_name = p_replication_task->get_filesystem_object_name();
 
-    if (!rsync_pipe)
+    std::string rsync_command = std::format(
+        "rsync {} --relative {}./{} {} 2>&1",
+        build_rsync_options(p_target_directory.get_transport_profile()),
+        std::string_view(filesystem_object_path).substr(0, filesystem_object_path.size() - filesystem_object_name.size()),
+        filesystem_object_name,
+        target_directory_path);
+
+    status_code status = run_rsync_process(
+        rsync_command,
+        &rsync_result,
+        &rsync_process_exit_status);
+
+    if (status::is_same(status, status::rsync_pipe_connection_failed))
     {
         //
         // Failed to open rsync IPC pipe.
         //
         const timestamp failure_time = timestamp::get_current_time();
-        filesytem_object_synchronization_result.m_status = status::rsync_pipe_connection_failed;
+        filesytem_object_synchronization_result.m_status = status;
         filesytem_object_synchronization_result.m_end_timestamp = failure_time;
         p_replication_task->set_last_error_timestamp(failure_time);
 
         logger::log(log_level::error, std::format("Failed to open an IPC connection for the rsync process. "
             "FilesystemObjectPath={}, TargetDirectoryPath={}, {} (errno {}), Status={:#X}.",
             p_replication_task->m_filesystem_object_path,
-            p_target_directory_path,
+            target_directory_path,
             std::strerror(errno),
             errno,
             filesytem_object_synchronization_result.m_status));
@@ -75,36 +408,20 @@ synchronization_manager::execute_synchronization_task(
         return filesytem_object_synchronization_result;
     }
 
-    while (fgets(rsync_result_buffer, sizeof(rsync_result_buffer), rsync_pipe.get()) != nullptr)
-    {
-        rsync_result += rsync_result_buffer;
-    }
-
-    //
-    // Obtain detached process exit code before releasing internal file handle.
-    //
-    int32 rsync_process_exit_status = pclose(rsync_pipe.get());
-
-    //
-    // Release internal file handle for avoiding calling the pipe wrapper destructor.
-    //
-    rsync_pipe.release();
-
-    if (!WIFEXITED(rsync_process_exit_status) ||
-        status::failed(rsync_process_exit_status))
+    if (status::failed(status))
     {
         //
         // The spawned rsync process exited with an error code; the synchronization task failed.
         //
         const timestamp failure_time = timestamp::get_current_time();
-        filesytem_object_synchronization_result.m_status = status::rsync_spawned_process_failed;
+        filesytem_object_synchronization_result.m_status = status;
         filesytem_object_synchronization_result.m_end_timestamp = failure_time;
         p_replication_task->set_last_error_timestamp(failure_time);
 
         logger::log(log_level::error, std::format("The spawned rsync process failed the synchronization task. "
             "FilesystemObjectPath={}, TargetDirectoryPath={}, RsyncProcessExitStatus={}, Status={:#X}.",
             p_replication_task->m_filesystem_object_path,
-            p_target_directory_path,
+            target_directory_path,
             rsync_process_exit_status,
             filesytem_object_synchronization_result.m_status));
 
@@ -116,29 +433,1254 @@ synchronization_manager::execute_synchronization_task(
     //
     filesytem_object_synchronization_result.m_end_timestamp = timestamp::get_current_time();
 
-    std::smatch data_matches;
-    std::regex data_pattern(c_rsync_data_pattern);
+    parse_rsync_transfer_statistics(
+        rsync_result,
+        &filesytem_object_synchronization_result);
+
+    return filesytem_object_synchronization_result;
+}
+
+std::vector<synchronization_result>
+synchronization_manager::execute_batched_synchronization_task(
+    const character* p_source_directory_path,
+    const directory& p_target_directory,
+    const std::vector<replication_task*>& p_replication_tasks)
+{
+    const character* target_directory_path = p_target_directory.get_path().c_str();
+    synchronization_result batch_synchronization_result;
+    batch_synchronization_result.m_start_timestamp = timestamp::get_current_time();
+
+    //
+    // The files list is handed to rsync through a NUL-separated file so
+    // that any filesystem object name can be transferred unambiguously.
+    //
+    std::string files_list_path = (std::filesystem::temp_directory_path() / c_rsync_files_list_name_template).string();
+
+    file_descriptor files_list_file_descriptor = mkostemp(
+        files_list_path.data(),
+        O_CLOEXEC);
+
+    if (!utilities::is_file_descriptor_valid(files_list_file_descriptor))
+    {
+        batch_synchronization_result.m_status = status::rsync_files_list_creation_failed;
+
+        logger::log(log_level::error, std::format("Failed to create the files list for the batched rsync process. "
+            "SourceDirectoryPath={}, TargetDirectoryPath={}, {} (errno {}), Status={:#X}.",
+            p_source_directory_path,
+            target_directory_path,
+            std::strerror(errno),
+            errno,
+            batch_synchronization_result.m_status));
+    }
+    else
+    {
+        std::string files_list;
+
+        for (const replication_task* replication_task : p_replication_tasks)
+        {
+            files_list.append(replication_task->get_filesystem_object_name());
+            files_list.push_back('\0');
+        }
+
+        uint64 number_bytes_written = 0;
+
+        while (number_bytes_written < files_list.size())
+        {
+            const ssize_t write_result = write(
+                files_list_file_descriptor,
+                files_list.data() + number_bytes_written,
+                files_list.size() - number_bytes_written);
 
-    if (std::regex_search(rsync_result, data_matches, data_pattern))
+            if (write_result == -1)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                batch_synchronization_result.m_status = status::rsync_files_list_creation_failed;
+
+                logger::log(log_level::error, std::format("Failed to write the files list for the batched rsync process. "
+                    "SourceDirectoryPath={}, TargetDirectoryPath={}, {} (errno {}), Status={:#X}.",
+                    p_source_directory_path,
+                    target_directory_path,
+                    std::strerror(errno),
+                    errno,
+                    batch_synchronization_result.m_status));
+
+                break;
+            }
+
+            number_bytes_written += write_result;
+        }
+
+        close(files_list_file_descriptor);
+    }
+
+    std::string rsync_result;
+    int32 rsync_process_exit_status = 0;
+
+    if (status::succeeded(batch_synchronization_result.m_status))
     {
         //
-        // Parse bytes transferred, if possible.
+        // A trailing separator on the source directory makes every listed name relative to it.
         //
-        if (data_matches.size() >= 2)
+        std::string rsync_command = std::format(
+            "rsync {} --from0 --files-from={} --out-format='{}%n{}%b' {}/ {} 2>&1",
+            build_rsync_options(p_target_directory.get_transport_profile()),
+            files_list_path,
+            c_rsync_transferred_file_marker,
+            c_rsync_transferred_file_separator,
+            p_source_directory_path,
+            target_directory_path);
+
+        batch_synchronization_result.m_status = run_rsync_process(
+            rsync_command,
+            &rsync_result,
+            &rsync_process_exit_status);
+
+        if (status::failed(batch_synchronization_result.m_status))
+        {
+            logger::log(log_level::error, std::format("The spawned batched rsync process failed the synchronization task. "
+                "SourceDirectoryPath={}, TargetDirectoryPath={}, NumberFilesystemObjects={}, RsyncProcessExitStatus={}, Status={:#X}.",
+                p_source_directory_path,
+                target_directory_path,
+                p_replication_tasks.size(),
+                rsync_process_exit_status,
+                batch_synchronization_result.m_status));
+        }
+    }
+
+    unlink(files_list_path.c_str());
+
+    batch_synchronization_result.m_end_timestamp = timestamp::get_current_time();
+
+    parse_rsync_transfer_statistics(
+        rsync_result,
+        &batch_synchronization_result);
+
+    //
+    // Collect the per-file transferred bytes reported through the rsync output format.
+    //
+    std::unordered_map<std::string, uint64> transferred_filesystem_objects;
+    std::istringstream rsync_result_stream(rsync_result);
+    std::string rsync_result_line;
+
+    while (std::getline(rsync_result_stream, rsync_result_line))
+    {
+        if (!rsync_result_line.starts_with(c_rsync_transferred_file_marker))
+        {
+            continue;
+        }
+
+        const std::size_t separator_position = rsync_result_line.rfind(c_rsync_transferred_file_separator);
+
+        if (separator_position == std::string::npos)
         {
-            filesytem_object_synchronization_result.m_bytes_transferred = std::stoi(data_matches[1].str());
+            continue;
         }
 
+        std::string filesystem_object_name = rsync_result_line.substr(
+            std::strlen(c_rsync_transferred_file_marker),
+            separator_position - std::strlen(c_rsync_transferred_file_marker));
+
         //
-        // Parse bytes per second transferred, if possible.
+        // Directories are reported with a trailing slash.
         //
-        if (data_matches.size() >= 3)
+        if (filesystem_object_name.ends_with('/'))
         {
-            filesytem_object_synchronization_result.m_bytes_per_second = std::stod(data_matches[2].str());
+            filesystem_object_name.pop_back();
         }
+
+        transferred_filesystem_objects[filesystem_object_name] += std::strtoull(
+            rsync_result_line.c_str() + separator_position + 1,
+            nullptr,
+            10);
     }
 
-    return filesytem_object_synchronization_result;
+    //
+    // Produce an individual result for each of the original replication tasks.
+    //
+    std::vector<synchronization_result> synchronization_results;
+    synchronization_results.reserve(p_replication_tasks.size());
+
+    for (replication_task* replication_task : p_replication_tasks)
+    {
+        synchronization_result filesytem_object_synchronization_result = batch_synchronization_result;
+        filesytem_object_synchronization_result.m_bytes_transferred = 0;
+
+        auto transferred_filesystem_object = transferred_filesystem_objects.find(replication_task->get_filesystem_object_name());
+
+        if (transferred_filesystem_object != transferred_filesystem_objects.end())
+        {
+            //
+            // A reported file has been replicated even if the batch as a whole partially failed.
+            //
+            filesytem_object_synchronization_result.m_status = status::success;
+            filesytem_object_synchronization_result.m_bytes_transferred = transferred_filesystem_object->second;
+        }
+
+        if (status::failed(filesytem_object_synchronization_result.m_status))
+        {
+            replication_task->set_last_error_timestamp(filesytem_object_synchronization_result.m_end_timestamp);
+        }
+
+        synchronization_results.emplace_back(std::move(filesytem_object_synchronization_result));
+    }
+
+    return synchronization_results;
+}
+
+std::string
+synchronization_manager::build_rsync_options(
+    const transport_profile& p_transport_profile)
+{
+    std::string rsync_options = "-av";
+
+    //
+    // Compression only pays off for remote targets; local targets leave it disabled in their profile.
+    //
+    if (p_transport_profile.m_compression_codec != compression_codec::none)
+    {
+        rsync_options.append(std::format(" --compress --compress-choice={}",
+            p_transport_profile.get_compression_codec_name()));
+
+        if (p_transport_profile.m_compression_level > 0)
+        {
+            rsync_options.append(std::format(" --compress-level={}",
+                static_cast<uint32>(p_transport_profile.m_compression_level)));
+        }
+    }
+
+    if (p_transport_profile.m_checksum_policy == checksum_policy::content)
+    {
+        rsync_options.append(" --checksum");
+    }
+
+    if (p_transport_profile.m_durability_mode != durability_mode::none)
+    {
+        rsync_options.append(" --fsync");
+    }
+
+    return rsync_options;
+}
+
+status_code
+synchronization_manager::run_rsync_process(
+    const std::string& p_rsync_command,
+    std::string* p_rsync_result,
+    int32* p_rsync_process_exit_status)
+{
+    static thread_local character rsync_result_buffer[c_rsync_result_buffer_size];
+
+    //
+    // The pipe wrapper will only invoke the destructor in case of a midway
+    // processing error; the internal file handle will be released if possible.
+    //
+    std::unique_ptr<FILE, decltype(&pclose)> rsync_pipe(
+        popen(p_rsync_command.c_str(), "r"),
+        pclose);
+
+    if (!rsync_pipe)
+    {
+        return status::rsync_pipe_connection_failed;
+    }
+
+    while (fgets(rsync_result_buffer, sizeof(rsync_result_buffer), rsync_pipe.get()) != nullptr)
+    {
+        *p_rsync_result += rsync_result_buffer;
+    }
+
+    //
+    // Obtain detached process exit code before releasing internal file handle.
+    //
+    *p_rsync_process_exit_status = pclose(rsync_pipe.get());
+
+    //
+    // Release internal file handle for avoiding calling the pipe wrapper destructor.
+    //
+    rsync_pipe.release();
+
+    if (!WIFEXITED(*p_rsync_process_exit_status) ||
+        WEXITSTATUS(*p_rsync_process_exit_status) != 0)
+    {
+        return status::rsync_spawned_process_failed;
+    }
+
+    return status::success;
+}
+
+void
+synchronization_manager::parse_rsync_transfer_statistics(
+    const std::string& p_rsync_result,
+    synchronization_result* p_synchronization_result)
+{
+    std::smatch data_matches;
+    std::regex data_pattern(c_rsync_data_pattern);
+
+    if (std::regex_search(p_rsync_result, data_matches, data_pattern))
+    {
+        //
+        // Parse bytes transferred, if possible.
+        //
+        if (data_matches.size() >= 2)
+        {
+            p_synchronization_result->m_bytes_transferred = std::stoull(data_matches[1].str());
+        }
+
+        //
+        // Parse bytes per second transferred, if possible.
+        //
+        if (data_matches.size() >= 3)
+        {
+            p_synchronization_result->m_bytes_per_second = std::stod(data_matches[2].str());
+        }
+    }
+}
+
+async_task<status_code>
+synchronization_manager::copy_filesystem_object(
+    replication_task* p_replication_task,
+    const directory& p_target_directory,
+    const std::string& p_target_filesystem_object_path,
+    const synchronization_options& p_synchronization_options,
+    synchronization_result* p_synchronization_result)
+{
+    status_code status = status::success;
+    const std::string& source_filesystem_object_path = p_replication_task->m_filesystem_object_path;
+
+    struct stat source_stat;
+
+    if (utilities::system_call_failed(lstat(source_filesystem_object_path.c_str(), &source_stat)))
+    {
+        status = errno == ENOENT ? status::filesystem_object_does_not_exist : status::native_copy_failed;
+
+        logger::log(log_level::error, std::format("Failed to retrieve the source filesystem object metadata. "
+            "FilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+            source_filesystem_object_path,
+            std::strerror(errno),
+            errno,
+            status));
+
+        co_return status;
+    }
+
+    if (S_ISREG(source_stat.st_mode))
+    {
+        co_return co_await copy_regular_file(
+            p_replication_task,
+            p_target_directory,
+            p_target_filesystem_object_path,
+            p_synchronization_options,
+            p_synchronization_result);
+    }
+
+    if (S_ISDIR(source_stat.st_mode))
+    {
+        std::error_code error;
+        std::filesystem::create_directories(p_target_filesystem_object_path, error);
+
+        if (error ||
+            utilities::system_call_failed(chmod(p_target_filesystem_object_path.c_str(), source_stat.st_mode & 07777)))
+        {
+            status = status::native_copy_failed;
+
+            logger::log(log_level::error, std::format("Failed to replicate the directory into the target path. "
+                "FilesystemObjectPath={}, TargetFilesystemObjectPath={}, Error='{}', Status={:#X}.",
+                source_filesystem_object_path,
+                p_target_filesystem_object_path,
+                error ? error.message() : std::strerror(errno),
+                status));
+        }
+
+        co_return status;
+    }
+
+    if (S_ISLNK(source_stat.st_mode))
+    {
+        std::error_code error;
+        const std::filesystem::path symbolic_link_target = std::filesystem::read_symlink(source_filesystem_object_path, error);
+
+        if (!error)
+        {
+            //
+            // Symbolic links cannot be overwritten in place.
+            //
+            std::filesystem::remove(p_target_filesystem_object_path, error);
+            std::filesystem::create_symlink(symbolic_link_target, p_target_filesystem_object_path, error);
+        }
+
+        if (error)
+        {
+            status = status::native_copy_failed;
+
+            logger::log(log_level::error, std::format("Failed to replicate the symbolic link into the target path. "
+                "FilesystemObjectPath={}, TargetFilesystemObjectPath={}, Error='{}', Status={:#X}.",
+                source_filesystem_object_path,
+                p_target_filesystem_object_path,
+                error.message(),
+                status));
+        }
+
+        co_return status;
+    }
+
+    co_return status::unsupported_filesystem_object_type;
+}
+
+async_task<status_code>
+synchronization_manager::copy_regular_file(
+    replication_task* p_replication_task,
+    const directory& p_target_directory,
+    const std::string& p_target_filesystem_object_path,
+    const synchronization_options& p_synchronization_options,
+    synchronization_result* p_synchronization_result)
+{
+    status_code status = status::success;
+    const std::string& source_filesystem_object_path = p_replication_task->m_filesystem_object_path;
+
+    file_descriptor source_file_descriptor = open(
+        source_filesystem_object_path.c_str(),
+        O_RDONLY | O_CLOEXEC);
+
+    if (!utilities::is_file_descriptor_valid(source_file_descriptor))
+    {
+        status = errno == ENOENT ? status::filesystem_object_does_not_exist : status::native_copy_failed;
+
+        logger::log(log_level::error, std::format("Failed to open the source file for replication. "
+            "FilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+            source_filesystem_object_path,
+            std::strerror(errno),
+            errno,
+            status));
+
+        co_return status;
+    }
+
+    struct stat source_stat;
+
+    if (utilities::system_call_failed(fstat(source_file_descriptor, &source_stat)))
+    {
+        status = status::native_copy_failed;
+
+        logger::log(log_level::error, std::format("Failed to retrieve the source file metadata. "
+            "FilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+            source_filesystem_object_path,
+            std::strerror(errno),
+            errno,
+            status));
+
+        close(source_file_descriptor);
+
+        co_return status;
+    }
+
+    //
+    // Updates of large files are replicated through the delta transfer engine using the current target file as basis.
+    // Reflinks are cheaper than any delta, so targets supporting them skip the delta computation altogether.
+    //
+    std::vector<delta_instruction> delta_instructions;
+    file_descriptor basis_file_descriptor = c_invalid_file_descriptor;
+    const bool reflink_supported = p_target_directory.is_reflink_supported();
+
+    //
+    // A moved file which still differs once renamed has its previous content in place, which makes for a good basis.
+    //
+    if (!reflink_supported &&
+        (p_replication_task->get_replication_action() == replication_action::update ||
+        p_replication_task->get_replication_action() == replication_action::move) &&
+        static_cast<uint64>(source_stat.st_size) >= c_delta_transfer_minimum_file_size)
+    {
+        basis_file_descriptor = open_delta_transfer_basis(
+            source_file_descriptor,
+            p_target_filesystem_object_path,
+            &delta_instructions);
+    }
+
+    //
+    // Delta transfers are reconstructed into a temporary file like any other copy, unless the
+    // transport profile opted into patching the target file itself to skip the unchanged blocks.
+    //
+    if (utilities::is_file_descriptor_valid(basis_file_descriptor) &&
+        p_target_directory.get_transport_profile().m_delta_application_mode == delta_application_mode::in_place &&
+        delta_transfer_engine::is_in_place_applicable(delta_instructions))
+    {
+        //
+        // All unchanged blocks are already in place; only the literal data is written into the target file.
+        //
+        status = delta_transfer_engine::apply_delta_instructions(
+            source_file_descriptor,
+            basis_file_descriptor,
+            basis_file_descriptor,
+            delta_instructions,
+            true /* In place. */,
+            &p_synchronization_result->m_delta_bytes,
+            &p_synchronization_result->m_literal_bytes);
+
+        if (status::succeeded(status))
+        {
+            status = finalize_target_file(
+                basis_file_descriptor,
+                source_file_descriptor,
+                source_stat,
+                p_target_directory.get_transport_profile());
+        }
+
+        p_synchronization_result->m_bytes_transferred = p_synchronization_result->m_literal_bytes;
+        p_synchronization_result->m_logical_bytes = source_stat.st_size;
+        p_synchronization_result->m_allocated_bytes = utilities::get_allocated_size(basis_file_descriptor);
+
+        close(source_file_descriptor);
+        close(basis_file_descriptor);
+
+        if (status::failed(status))
+        {
+            logger::log(log_level::error, std::format("Failed to apply the file delta into the target path. "
+                "FilesystemObjectPath={}, TargetFilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+                source_filesystem_object_path,
+                p_target_filesystem_object_path,
+                std::strerror(errno),
+                errno,
+                status));
+        }
+
+        co_return status;
+    }
+
+    std::string temporary_file_path;
+
+    file_descriptor target_file_descriptor = create_temporary_file(
+        p_target_filesystem_object_path,
+        &temporary_file_path);
+
+    if (!utilities::is_file_descriptor_valid(target_file_descriptor))
+    {
+        status = status::native_copy_failed;
+
+        logger::log(log_level::error, std::format("Failed to create a temporary file for replication. "
+            "FilesystemObjectPath={}, TargetFilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+            source_filesystem_object_path,
+            p_target_filesystem_object_path,
+            std::strerror(errno),
+            errno,
+            status));
+
+        close(source_file_descriptor);
+
+        if (utilities::is_file_descriptor_valid(basis_file_descriptor))
+        {
+            close(basis_file_descriptor);
+        }
+
+        co_return status;
+    }
+
+    if (reflink_supported &&
+        !utilities::system_call_failed(ioctl(target_file_descriptor, FICLONE, source_file_descriptor)))
+    {
+        //
+        // The target file shares the source extents; no file data is copied.
+        //
+        p_synchronization_result->m_reflinked_bytes = source_stat.st_size;
+    }
+    else if (utilities::is_file_descriptor_valid(basis_file_descriptor))
+    {
+        //
+        // Reconstruct the file out of the matched blocks of the basis and the literal data.
+        //
+        status = delta_transfer_engine::apply_delta_instructions(
+            source_file_descriptor,
+            basis_file_descriptor,
+            target_file_descriptor,
+            delta_instructions,
+            false /* Not in place. */,
+            &p_synchronization_result->m_delta_bytes,
+            &p_synchronization_result->m_literal_bytes);
+
+        close(basis_file_descriptor);
+    }
+    else if (p_target_directory.get_transport_profile().m_synchronization_strategy == synchronization_strategy::io_uring &&
+        p_synchronization_options.m_io_uring_transfer_engine != nullptr)
+    {
+        //
+        // Hand the data extents over to the io_uring ring thread; the coroutine is suspended until the transfers complete.
+        //
+        std::vector<io_uring_transfer_awaitable> transfers;
+        uint64 data_offset = 0;
+        uint64 data_end_offset = 0;
+
+        while (utilities::find_next_data_extent(source_file_descriptor, data_end_offset, source_stat.st_size, &data_offset, &data_end_offset))
+        {
+            transfers.push_back(p_synchronization_options.m_io_uring_transfer_engine->submit_transfer(
+                source_file_descriptor,
+                target_file_descriptor,
+                data_offset,
+                data_end_offset - data_offset,
+                p_replication_task));
+        }
+
+        for (io_uring_transfer_awaitable& transfer : transfers)
+        {
+            const io_uring_transfer_result transfer_result = co_await transfer;
+
+            if (status::failed(transfer_result.m_status))
+            {
+                status = transfer_result.m_status;
+            }
+
+            p_synchronization_result->m_literal_bytes += transfer_result.m_bytes_transferred;
+        }
+
+        //
+        // Completions resume the coroutine on the ring thread; the target file is committed back on the thread
+        // pool, or on the ring thread itself when the thread pool is already in destruction process.
+        //
+        if (!transfers.empty() &&
+            p_synchronization_options.m_thread_pool != nullptr)
+        {
+            co_await p_synchronization_options.m_thread_pool->schedule();
+
+            logger::set_activity_id(p_replication_task->m_activity_id);
+        }
+    }
+    else if (p_synchronization_options.m_thread_pool != nullptr &&
+        p_synchronization_options.m_parallel_copy_minimum_file_size > 0 &&
+        static_cast<uint64>(source_stat.st_size) >= p_synchronization_options.m_parallel_copy_minimum_file_size)
+    {
+        //
+        // Very large files are split into chunks copied concurrently with the idle workers of the thread pool.
+        //
+        status = copy_file_data_parallel(
+            source_file_descriptor,
+            target_file_descriptor,
+            source_stat.st_size,
+            p_synchronization_options.m_thread_pool,
+            &p_synchronization_result->m_literal_bytes);
+    }
+    else
+    {
+        status = copy_sparse_file_data(
+            source_file_descriptor,
+            target_file_descriptor,
+            source_stat.st_size,
+            &p_synchronization_result->m_literal_bytes);
+    }
+
+    p_synchronization_result->m_bytes_transferred = p_synchronization_result->m_literal_bytes;
+    p_synchronization_result->m_logical_bytes = source_stat.st_size;
+    p_synchronization_result->m_allocated_bytes = utilities::get_allocated_size(target_file_descriptor);
+
+    if (status::succeeded(status))
+    {
+        status = commit_temporary_file(
+            target_file_descriptor,
+            temporary_file_path,
+            p_target_filesystem_object_path,
+            source_file_descriptor,
+            source_stat,
+            p_target_directory.get_transport_profile());
+    }
+    else
+    {
+        close(target_file_descriptor);
+        unlink(temporary_file_path.c_str());
+    }
+
+    close(source_file_descriptor);
+
+    if (status::failed(status))
+    {
+        logger::log(log_level::error, std::format("Failed to replicate the file into the target path. "
+            "FilesystemObjectPath={}, TargetFilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+            source_filesystem_object_path,
+            p_target_filesystem_object_path,
+            std::strerror(errno),
+            errno,
+            status));
+    }
+
+    co_return status;
+}
+
+file_descriptor
+synchronization_manager::create_temporary_file(
+    const std::string& p_target_filesystem_object_path,
+    std::string* p_temporary_file_path)
+{
+    //
+    // The temporary file lives in the same directory as the target
+    // path so that the final rename never crosses filesystems.
+    //
+    const std::filesystem::path target_parent_directory_path = std::filesystem::path(p_target_filesystem_object_path).parent_path();
+
+    *p_temporary_file_path = (target_parent_directory_path / c_temporary_file_name_template).string();
+
+    file_descriptor temporary_file_descriptor = mkostemp(
+        p_temporary_file_path->data(),
+        O_CLOEXEC);
+
+    if (!utilities::is_file_descriptor_valid(temporary_file_descriptor) &&
+        errno == ENOENT)
+    {
+        //
+        // Nested objects may be replicated before their parent directories reached the target directory.
+        //
+        std::error_code error;
+        std::filesystem::create_directories(target_parent_directory_path, error);
+
+        *p_temporary_file_path = (target_parent_directory_path / c_temporary_file_name_template).string();
+
+        temporary_file_descriptor = mkostemp(
+            p_temporary_file_path->data(),
+            O_CLOEXEC);
+    }
+
+    return temporary_file_descriptor;
+}
+
+status_code
+synchronization_manager::commit_temporary_file(
+    const file_descriptor p_temporary_file_descriptor,
+    const std::string& p_temporary_file_path,
+    const std::string& p_target_filesystem_object_path,
+    const file_descriptor p_source_file_descriptor,
+    const struct stat& p_source_stat,
+    const transport_profile& p_transport_profile)
+{
+    status_code status = status::success;
+
+    //
+    // Extend the file up to the source size, which recreates any trailing hole of the source file.
+    //
+    if (utilities::system_call_failed(ftruncate(p_temporary_file_descriptor, p_source_stat.st_size)))
+    {
+        status = status::native_copy_failed;
+    }
+
+    if (status::succeeded(status))
+    {
+        status = finalize_target_file(
+            p_temporary_file_descriptor,
+            p_source_file_descriptor,
+            p_source_stat,
+            p_transport_profile);
+    }
+
+    if (utilities::system_call_failed(close(p_temporary_file_descriptor)) &&
+        status::succeeded(status))
+    {
+        status = status::native_copy_failed;
+    }
+
+    if (status::succeeded(status) &&
+        utilities::system_call_failed(rename(p_temporary_file_path.c_str(), p_target_filesystem_object_path.c_str())))
+    {
+        status = status::native_copy_failed;
+    }
+
+    if (status::failed(status))
+    {
+        unlink(p_temporary_file_path.c_str());
+
+        return status;
+    }
+
+    if (p_transport_profile.m_durability_mode == durability_mode::full)
+    {
+        //
+        // Persist the rename itself through the parent directory entry.
+        //
+        const std::string parent_directory_path = std::filesystem::path(p_target_filesystem_object_path).parent_path().string();
+
+        file_descriptor parent_directory_file_descriptor = open(
+            parent_directory_path.c_str(),
+            O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+        if (!utilities::is_file_descriptor_valid(parent_directory_file_descriptor) ||
+            utilities::system_call_failed(fsync(parent_directory_file_descriptor)))
+        {
+            status = status::native_copy_failed;
+        }
+
+        if (utilities::is_file_descriptor_valid(parent_directory_file_descriptor))
+        {
+            close(parent_directory_file_descriptor);
+        }
+    }
+
+    return status;
+}
+
+status_code
+synchronization_manager::finalize_target_file(
+    const file_descriptor p_target_file_descriptor,
+    const file_descriptor p_source_file_descriptor,
+    const struct stat& p_source_stat,
+    const transport_profile& p_transport_profile)
+{
+    status_code status = status::success;
+
+    if (p_transport_profile.m_checksum_policy == checksum_policy::content)
+    {
+        status = verify_file_content(
+            p_source_file_descriptor,
+            p_target_file_descriptor,
+            p_source_stat.st_size);
+
+        return_status_if_failed(status)
+    }
+
+    status = copy_file_metadata(
+        p_target_file_descriptor,
+        p_source_stat);
+
+    return_status_if_failed(status)
+
+    if (p_transport_profile.m_durability_mode != durability_mode::none &&
+        utilities::system_call_failed(fdatasync(p_target_file_descriptor)))
+    {
+        return status::native_copy_failed;
+    }
+
+    return status;
+}
+
+status_code
+synchronization_manager::verify_file_content(
+    const file_descriptor p_source_file_descriptor,
+    const file_descriptor p_target_file_descriptor,
+    const uint64 p_number_bytes)
+{
+    static thread_local byte source_buffer[c_native_copy_buffer_size];
+    static thread_local byte target_buffer[c_native_copy_buffer_size];
+
+    uint64 offset = 0;
+
+    while (offset < p_number_bytes)
+    {
+        const uint64 number_bytes_requested = std::min<uint64>(p_number_bytes - offset, c_native_copy_buffer_size);
+
+        const ssize_t source_bytes_read = pread(p_source_file_descriptor, source_buffer, number_bytes_requested, offset);
+        const ssize_t target_bytes_read = pread(p_target_file_descriptor, target_buffer, number_bytes_requested, offset);
+
+        if (source_bytes_read <= 0 ||
+            source_bytes_read != target_bytes_read ||
+            std::memcmp(source_buffer, target_buffer, source_bytes_read) != 0)
+        {
+            return status::checksum_verification_failed;
+        }
+
+        offset += source_bytes_read;
+    }
+
+    return status::success;
+}
+
+file_descriptor
+synchronization_manager::open_delta_transfer_basis(
+    const file_descriptor p_source_file_descriptor,
+    const std::string& p_target_filesystem_object_path,
+    std::vector<delta_instruction>* p_delta_instructions)
+{
+    file_descriptor basis_file_descriptor = open(
+        p_target_filesystem_object_path.c_str(),
+        O_RDWR | O_CLOEXEC);
+
+    if (!utilities::is_file_descriptor_valid(basis_file_descriptor))
+    {
+        //
+        // There is no basis to compute a delta against; the file is fully copied.
+        //
+        return c_invalid_file_descriptor;
+    }
+
+    struct stat basis_stat;
+
+    if (utilities::system_call_failed(fstat(basis_file_descriptor, &basis_stat)) ||
+        !S_ISREG(basis_stat.st_mode))
+    {
+        close(basis_file_descriptor);
+
+        return c_invalid_file_descriptor;
+    }
+
+    status_code status = delta_transfer_engine::compute_delta_instructions(
+        p_source_file_descriptor,
+        basis_file_descriptor,
+        basis_stat.st_size,
+        p_delta_instructions);
+
+    if (status::failed(status))
+    {
+        logger::log(log_level::warning, std::format("Failed to compute the file delta; falling back to a full copy. "
+            "TargetFilesystemObjectPath={}, {} (errno {}), Status={:#X}.",
+            p_target_filesystem_object_path,
+            std::strerror(errno),
+            errno,
+            status));
+
+        p_delta_instructions->clear();
+        close(basis_file_descriptor);
+
+        return c_invalid_file_descriptor;
+    }
+
+    return basis_file_descriptor;
+}
+
+status_code
+synchronization_manager::copy_file_metadata(
+    const file_descriptor p_target_file_descriptor,
+    const struct stat& p_source_stat)
+{
+    //
+    // Preserve permissions and modification times as rsync '-a' would.
+    //
+    const struct timespec file_times[2] = {p_source_stat.st_atim, p_source_stat.st_mtim};
+
+    if (utilities::system_call_failed(fchmod(p_target_file_descriptor, p_source_stat.st_mode & 07777)) ||
+        utilities::system_call_failed(futimens(p_target_file_descriptor, file_times)))
+    {
+        return status::native_copy_failed;
+    }
+
+    return status::success;
+}
+
+status_code
+synchronization_manager::copy_file_data(
+    const file_descriptor p_source_file_descriptor,
+    const file_descriptor p_target_file_descriptor,
+    const uint64 p_number_bytes,
+    uint64* p_bytes_transferred)
+{
+    static thread_local byte copy_buffer[c_native_copy_buffer_size];
+
+    bool copy_file_range_supported = true;
+    bool sendfile_supported = true;
+    uint64 number_bytes_transferred = 0;
+
+    while (number_bytes_transferred < p_number_bytes)
+    {
+        const uint64 number_bytes_requested = std::min(p_number_bytes - number_bytes_transferred, c_native_copy_chunk_size);
+        ssize_t number_bytes_copied = 0;
+
+        if (copy_file_range_supported)
+        {
+            number_bytes_copied = copy_file_range(
+                p_source_file_descriptor,
+                nullptr,
+                p_target_file_descriptor,
+                nullptr,
+                number_bytes_requested,
+                0 /* No flags. */);
+
+            if (number_bytes_copied == -1 &&
+                (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL))
+            {
+                //
+                // Cross-filesystem or unsupported copy; fall back to sendfile from the current offsets.
+                //
+                copy_file_range_supported = false;
+
+                continue;
+            }
+        }
+        else if (sendfile_supported)
+        {
+            number_bytes_copied = sendfile(
+                p_target_file_descriptor,
+                p_source_file_descriptor,
+                nullptr,
+                number_bytes_requested);
+
+            if (number_bytes_copied == -1 &&
+                (errno == ENOSYS || errno == EINVAL))
+            {
+                sendfile_supported = false;
+
+                continue;
+            }
+        }
+        else
+        {
+            number_bytes_copied = read(
+                p_source_file_descriptor,
+                copy_buffer,
+                std::min<uint64>(number_bytes_requested, c_native_copy_buffer_size));
+
+            ssize_t number_bytes_written = 0;
+
+            while (number_bytes_written < number_bytes_copied)
+            {
+                const ssize_t write_result = write(
+                    p_target_file_descriptor,
+                    copy_buffer + number_bytes_written,
+                    number_bytes_copied - number_bytes_written);
+
+                if (write_result == -1)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    return status::native_copy_failed;
+                }
+
+                number_bytes_written += write_result;
+            }
+        }
+
+        if (number_bytes_copied == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return status::native_copy_failed;
+        }
+
+        if (number_bytes_copied == 0)
+        {
+            //
+            // The source file was truncated midway; the follow-up event will replicate it again.
+            //
+            break;
+        }
+
+        number_bytes_transferred += number_bytes_copied;
+        *p_bytes_transferred += number_bytes_copied;
+    }
+
+    return status::success;
+}
+
+status_code
+synchronization_manager::copy_file_data_parallel(
+    const file_descriptor p_source_file_descriptor,
+    const file_descriptor p_target_file_descriptor,
+    const uint64 p_number_bytes,
+    thread_pool* p_thread_pool,
+    uint64* p_bytes_transferred)
+{
+    std::shared_ptr<parallel_copy> file_parallel_copy = std::make_shared<parallel_copy>();
+    file_parallel_copy->m_source_file_descriptor = p_source_file_descriptor;
+    file_parallel_copy->m_target_file_descriptor = p_target_file_descriptor;
+    file_parallel_copy->m_number_bytes = p_number_bytes;
+    file_parallel_copy->m_number_chunks = (p_number_bytes + c_parallel_copy_chunk_size - 1) / c_parallel_copy_chunk_size;
+    file_parallel_copy->m_next_chunk = 0;
+    file_parallel_copy->m_bytes_transferred = 0;
+    file_parallel_copy->m_number_completed_chunks = 0;
+    file_parallel_copy->m_status = status::success;
+
+    //
+    // The calling thread copies chunks as well, so one helper less than the number of chunks is enough.
+    //
+    const uint64 number_helpers = std::min<uint64>(file_parallel_copy->m_number_chunks - 1, c_parallel_copy_max_number_helpers);
+
+    for (uint64 helper_index = 0; helper_index < number_helpers; ++helper_index)
+    {
+        //
+        // A rejected helper is not an error; its chunks are claimed by the other workers.
+        //
+        p_thread_pool->post(
+            [file_parallel_copy]()
+            {
+                copy_file_chunks(file_parallel_copy.get());
+            });
+    }
+
+    copy_file_chunks(file_parallel_copy.get());
+
+    {
+        std::unique_lock<std::mutex> lock(file_parallel_copy->m_lock);
+
+        file_parallel_copy->m_chunks_completed_condition.wait(lock, [&file_parallel_copy]()
+        {
+            return file_parallel_copy->m_number_completed_chunks == file_parallel_copy->m_number_chunks;
+        });
+    }
+
+    *p_bytes_transferred += file_parallel_copy->m_bytes_transferred;
+
+    return file_parallel_copy->m_status;
+}
+
+void
+synchronization_manager::copy_file_chunks(
+    parallel_copy* p_parallel_copy)
+{
+    forever
+    {
+        const uint64 chunk_index = p_parallel_copy->m_next_chunk.fetch_add(1);
+
+        if (chunk_index >= p_parallel_copy->m_number_chunks)
+        {
+            return;
+        }
+
+        const uint64 chunk_offset = chunk_index * c_parallel_copy_chunk_size;
+        uint64 number_bytes_copied = 0;
+        status_code status = status::success;
+
+        {
+            std::scoped_lock<std::mutex> lock(p_parallel_copy->m_lock);
+            status = p_parallel_copy->m_status;
+        }
+
+        //
+        // Once a chunk failed the rest are only marked as completed.
+        //
+        if (status::succeeded(status))
+        {
+            status = utilities::copy_data_extents(
+                p_parallel_copy->m_source_file_descriptor,
+                chunk_offset,
+                p_parallel_copy->m_target_file_descriptor,
+                chunk_offset,
+                std::min(p_parallel_copy->m_number_bytes - chunk_offset, c_parallel_copy_chunk_size),
+                false /* Empty target file. */,
+                &number_bytes_copied);
+        }
+
+        p_parallel_copy->m_bytes_transferred += number_bytes_copied;
+
+        bool chunks_completed = false;
+
+        {
+            std::scoped_lock<std::mutex> lock(p_parallel_copy->m_lock);
+
+            if (status::failed(status))
+            {
+                p_parallel_copy->m_status = status::native_copy_failed;
+            }
+
+            chunks_completed = ++p_parallel_copy->m_number_completed_chunks == p_parallel_copy->m_number_chunks;
+        }
+
+        if (chunks_completed)
+        {
+            p_parallel_copy->m_chunks_completed_condition.notify_all();
+        }
+    }
+}
+
+status_code
+synchronization_manager::copy_sparse_file_data(
+    const file_descriptor p_source_file_descriptor,
+    const file_descriptor p_target_file_descriptor,
+    const uint64 p_number_bytes,
+    uint64* p_bytes_transferred)
+{
+    uint64 data_offset = 0;
+    uint64 data_end_offset = 0;
+
+    //
+    // Holes are skipped in the empty target file; the target size is set once the file is committed.
+    //
+    while (utilities::find_next_data_extent(p_source_file_descriptor, data_end_offset, p_number_bytes, &data_offset, &data_end_offset))
+    {
+        if (lseek(p_source_file_descriptor, data_offset, SEEK_SET) == -1 ||
+            lseek(p_target_file_descriptor, data_offset, SEEK_SET) == -1)
+        {
+            return status::native_copy_failed;
+        }
+
+        status_code status = copy_file_data(
+            p_source_file_descriptor,
+            p_target_file_descriptor,
+            data_end_offset - data_offset,
+            p_bytes_transferred);
+
+        return_status_if_failed(status)
+    }
+
+    return status::success;
+}
+
+synchronization_result
+synchronization_manager::execute_move_synchronization_task(
+    const directory& p_target_directory,
+    std::unique_ptr<replication_task>& p_replication_task)
+{
+    synchronization_result move_synchronization_result;
+    move_synchronization_result.m_start_timestamp = timestamp::get_current_time();
+
+    const std::string previous_target_filesystem_object_path = std::format("{}/{}",
+        p_target_directory.get_path(),
+        p_replication_task->get_previous_filesystem_object_name());
+
+    const std::string target_filesystem_object_path = std::format("{}/{}",
+        p_target_directory.get_path(),
+        p_replication_task->get_filesystem_object_name());
+
+    bool renamed = !utilities::system_call_failed(rename(previous_target_filesystem_object_path.c_str(), target_filesystem_object_path.c_str()));
+
+    if (!renamed &&
+        errno == ENOENT &&
+        std::filesystem::exists(previous_target_filesystem_object_path))
+    {
+        //
+        // The object was moved into a directory which has not reached the target directory yet.
+        //
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(target_filesystem_object_path).parent_path(), error);
+
+        renamed = !utilities::system_call_failed(rename(previous_target_filesystem_object_path.c_str(), target_filesystem_object_path.c_str()));
+    }
+
+    status_code status = status::success;
+    struct stat source_stat;
+    struct stat target_stat;
+
+    if (!renamed)
+    {
+        status = status::move_fallback_required;
+    }
+    else if (!utilities::system_call_failed(lstat(p_replication_task->m_filesystem_object_path.c_str(), &source_stat)) &&
+        (utilities::system_call_failed(lstat(target_filesystem_object_path.c_str(), &target_stat)) ||
+        (source_stat.st_mode & S_IFMT) != (target_stat.st_mode & S_IFMT) ||
+        (S_ISREG(source_stat.st_mode) &&
+            (source_stat.st_size != target_stat.st_size ||
+            source_stat.st_mtim.tv_sec != target_stat.st_mtim.tv_sec ||
+            source_stat.st_mtim.tv_nsec != target_stat.st_mtim.tv_nsec))))
+    {
+        //
+        // The object changed before or after being renamed. A source object which is already gone again
+        // is left to the filesystem events which removed or moved it.
+        //
+        status = status::move_fallback_required;
+    }
+
+    move_synchronization_result.m_status = status;
+    move_synchronization_result.m_end_timestamp = timestamp::get_current_time();
+
+    return move_synchronization_result;
+}
+
+status_code
+synchronization_manager::remove_filesystem_object(
+    const std::string& p_target_filesystem_object_path)
+{
+    std::error_code error;
+    std::filesystem::remove_all(p_target_filesystem_object_path, error);
+
+    if (error)
+    {
+        status_code status = status::native_remove_failed;
+
+        logger::log(log_level::error, std::format("Failed to remove the filesystem object from the target path. "
+            "TargetFilesystemObjectPath={}, Error='{}', Status={:#X}.",
+            p_target_filesystem_object_path,
+            error.message(),
+            status));
+
+        return status;
+    }
+
+    return status::success;
 }
 
 } // namespace modula.
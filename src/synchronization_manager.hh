@@ -10,10 +10,53 @@
 
 #include "status.hh"
 #include "timestamp.hh"
+#include "directory.hh"
+#include "async_task.hh"
+#include "thread_pool.hh"
+#include "replication_task.hh"
+#include "delta_transfer_engine.hh"
+#include "io_uring_transfer_engine.hh"
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <string_view>
+#include <condition_variable>
+#include <sys/stat.h>
 
 namespace modula
 {
 
+//
+// Synchronization options of a replication engine applied to each of its synchronization tasks.
+//
+struct synchronization_options
+{
+
+    //
+    // Default constructor.
+    //
+    synchronization_options();
+
+    //
+    // Io_uring transfer engine; only used by target directories with the io_uring strategy.
+    //
+    io_uring_transfer_engine* m_io_uring_transfer_engine;
+
+    //
+    // Thread pool whose workers help with parallel chunked copies of large files.
+    //
+    thread_pool* m_thread_pool;
+
+    //
+    // Minimum file size in bytes for copying files in parallel chunks. Zero disables parallel copies.
+    //
+    uint64 m_parallel_copy_minimum_file_size;
+
+};
+
 struct synchronization_result
 {
 
@@ -40,13 +83,38 @@ struct synchronization_result
     //
     // Number of bytes synchronized and transferred.
     //
-    uint32 m_bytes_transferred;
+    uint64 m_bytes_transferred;
 
     //
     // Number of bytes synchronized and transferred.
     //
     single_precision m_bytes_per_second;
 
+    //
+    // Number of bytes reused from the existing target file by the delta transfer engine.
+    //
+    uint64 m_delta_bytes;
+
+    //
+    // Number of bytes taken from the source file as literal data.
+    //
+    uint64 m_literal_bytes;
+
+    //
+    // Number of bytes shared with the source file through a reflink instead of being copied.
+    //
+    uint64 m_reflinked_bytes;
+
+    //
+    // Logical size in bytes of the replicated file, holes included.
+    //
+    uint64 m_logical_bytes;
+
+    //
+    // Number of bytes allocated on disk for the replicated file in the target.
+    //
+    uint64 m_allocated_bytes;
+
 };
 
 //
@@ -62,16 +130,349 @@ class synchronization_manager
 
 public:
 
+    //
+    // Executes a filesytem object synchronization through the strategy of the specified options. The
+    // coroutine is suspended instead of blocking its thread while io_uring transfers are in flight.
+    //
+    static
+    async_task<synchronization_result>
+    execute_synchronization_task(
+        const directory& p_target_directory,
+        std::unique_ptr<replication_task>& p_replication_task,
+        const synchronization_options& p_synchronization_options);
+
+    //
+    // Executes a batch of filesystem object synchronizations through a single rsync process.
+    // Filesystem object names are relative to the source directory; one result is returned
+    // per replication task in the same order they were provided.
+    //
+    static
+    std::vector<synchronization_result>
+    execute_batched_synchronization_task(
+        const character* p_source_directory_path,
+        const directory& p_target_directory,
+        const std::vector<replication_task*>& p_replication_tasks);
+
+    //
+    // Determines whether a replication task can be fanned out to many targets out of a single source read.
+    // This is the case for created and updated regular files which do not qualify for delta transfers.
+    //
+    static
+    bool
+    is_fan_out_applicable(
+        const replication_task* p_replication_task);
+
+    //
+    // Determines whether a filesystem object name belongs to a temporary file of an in-flight atomic replacement.
+    //
+    static
+    bool
+    is_temporary_file_name(
+        const std::string_view p_filesystem_object_name);
+
+    //
+    // Executes a filesystem object synchronization into all the target directories at once, reading
+    // the source file a single time. One result is returned per target directory in the same order.
+    //
+    static
+    std::vector<synchronization_result>
+    execute_fan_out_synchronization_task(
+        const std::vector<directory>& p_target_directories,
+        std::unique_ptr<replication_task>& p_replication_task,
+        thread_pool* p_thread_pool);
+
+private:
+
+    //
+    // Shared state of a parallel chunked copy. Helpers hold it through a shared pointer,
+    // since they may start after the copy completed and only then find no chunk to claim.
+    //
+    struct parallel_copy
+    {
+
+        //
+        // Source file to read from.
+        //
+        file_descriptor m_source_file_descriptor;
+
+        //
+        // Target file to write into.
+        //
+        file_descriptor m_target_file_descriptor;
+
+        //
+        // Number of bytes to be copied.
+        //
+        uint64 m_number_bytes;
+
+        //
+        // Number of chunks the copy is split into.
+        //
+        uint64 m_number_chunks;
+
+        //
+        // Index of the next chunk to be claimed.
+        //
+        std::atomic<uint64> m_next_chunk;
+
+        //
+        // Number of bytes copied across all chunks.
+        //
+        std::atomic<uint64> m_bytes_transferred;
+
+        //
+        // Number of claimed chunks already completed.
+        //
+        uint64 m_number_completed_chunks;
+
+        //
+        // Status of the copy.
+        //
+        status_code m_status;
+
+        //
+        // Lock for synchronizing the completion of chunks.
+        //
+        std::mutex m_lock;
+
+        //
+        // Condition for awakening the calling thread once all chunks complete.
+        //
+        std::condition_variable m_chunks_completed_condition;
+
+    };
+
+    //
+    // Executes a filesytem object synchronization in-process.
+    //
+    static
+    async_task<synchronization_result>
+    execute_native_synchronization_task(
+        const directory& p_target_directory,
+        std::unique_ptr<replication_task>& p_replication_task,
+        const synchronization_options& p_synchronization_options);
+
+    //
+    // Executes a filesytem object move by renaming the object under its previous name in the target directory.
+    // Fails with move_fallback_required when the target directory does not hold the object under its previous
+    // name, or when the renamed object does not match the source object, so that it is copied instead.
+    //
+    static
+    synchronization_result
+    execute_move_synchronization_task(
+        const directory& p_target_directory,
+        std::unique_ptr<replication_task>& p_replication_task);
+
     //
     // Executes a filesytem object synchronization through rsync.
     //
     static
     synchronization_result
-    execute_synchronization_task(
-        const character* p_target_directory_path,
+    execute_rsync_synchronization_task(
+        const directory& p_target_directory,
         std::unique_ptr<replication_task>& p_replication_task);
 
-private:
+    //
+    // Builds the rsync command line options out of the transport profile of a target directory.
+    //
+    static
+    std::string
+    build_rsync_options(
+        const transport_profile& p_transport_profile);
+
+    //
+    // Spawns an rsync process and collects its output and exit status.
+    //
+    static
+    status_code
+    run_rsync_process(
+        const std::string& p_rsync_command,
+        std::string* p_rsync_result,
+        int32* p_rsync_process_exit_status);
+
+    //
+    // Parses the rsync transfer statistics into the synchronization result, if present.
+    //
+    static
+    void
+    parse_rsync_transfer_statistics(
+        const std::string& p_rsync_result,
+        synchronization_result* p_synchronization_result);
+
+    //
+    // Replicates a source filesystem object into the target path based on its type.
+    //
+    static
+    async_task<status_code>
+    copy_filesystem_object(
+        replication_task* p_replication_task,
+        const directory& p_target_directory,
+        const std::string& p_target_filesystem_object_path,
+        const synchronization_options& p_synchronization_options,
+        synchronization_result* p_synchronization_result);
+
+    //
+    // Replicates a regular file. Targets supporting reflinks get a clone of the source file; otherwise
+    // large file updates go through the delta transfer engine and the rest of the files are copied into
+    // a temporary file which is atomically renamed into the target path.
+    //
+    static
+    async_task<status_code>
+    copy_regular_file(
+        replication_task* p_replication_task,
+        const directory& p_target_directory,
+        const std::string& p_target_filesystem_object_path,
+        const synchronization_options& p_synchronization_options,
+        synchronization_result* p_synchronization_result);
+
+    //
+    // Opens the current target file as the delta transfer basis and computes the delta instructions against it.
+    // Returns an invalid file descriptor when no delta can be used and the file must be fully copied.
+    //
+    static
+    file_descriptor
+    open_delta_transfer_basis(
+        const file_descriptor p_source_file_descriptor,
+        const std::string& p_target_filesystem_object_path,
+        std::vector<delta_instruction>* p_delta_instructions);
+
+    //
+    // Creates a temporary file next to the target path for its atomic replacement, creating any missing parent directory.
+    //
+    static
+    file_descriptor
+    create_temporary_file(
+        const std::string& p_target_filesystem_object_path,
+        std::string* p_temporary_file_path);
+
+    //
+    // Sets the source file size into a fully written temporary file, finalizes it, closes it and atomically
+    // renames it into the target path, flushing the parent directory when required by the transport profile.
+    // The temporary file is removed on failure.
+    //
+    static
+    status_code
+    commit_temporary_file(
+        const file_descriptor p_temporary_file_descriptor,
+        const std::string& p_temporary_file_path,
+        const std::string& p_target_filesystem_object_path,
+        const file_descriptor p_source_file_descriptor,
+        const struct stat& p_source_stat,
+        const transport_profile& p_transport_profile);
+
+    //
+    // Verifies the target file content when required by the checksum policy, copies the source
+    // file metadata and flushes the target file data when required by the durability mode.
+    //
+    static
+    status_code
+    finalize_target_file(
+        const file_descriptor p_target_file_descriptor,
+        const file_descriptor p_source_file_descriptor,
+        const struct stat& p_source_stat,
+        const transport_profile& p_transport_profile);
+
+    //
+    // Compares the content of the target file against the source file.
+    //
+    static
+    status_code
+    verify_file_content(
+        const file_descriptor p_source_file_descriptor,
+        const file_descriptor p_target_file_descriptor,
+        const uint64 p_number_bytes);
+
+    //
+    // Copies the permissions and times of the source file into the target file.
+    //
+    static
+    status_code
+    copy_file_metadata(
+        const file_descriptor p_target_file_descriptor,
+        const struct stat& p_source_stat);
+
+    //
+    // Copies the file data between two file descriptors from their current offsets. Uses
+    // copy_file_range first and falls back to sendfile and then to a read/write loop.
+    //
+    static
+    status_code
+    copy_file_data(
+        const file_descriptor p_source_file_descriptor,
+        const file_descriptor p_target_file_descriptor,
+        const uint64 p_number_bytes,
+        uint64* p_bytes_transferred);
+
+    //
+    // Copies the source file into an empty target file in fixed-size chunks claimed concurrently by the calling
+    // thread and by helpers scheduled on the thread pool. The calling thread never waits on unstarted helpers,
+    // so the copy always progresses even when the thread pool is saturated.
+    //
+    static
+    status_code
+    copy_file_data_parallel(
+        const file_descriptor p_source_file_descriptor,
+        const file_descriptor p_target_file_descriptor,
+        const uint64 p_number_bytes,
+        thread_pool* p_thread_pool,
+        uint64* p_bytes_transferred);
+
+    //
+    // Claims and copies chunks of a parallel copy until none remain.
+    //
+    static
+    void
+    copy_file_chunks(
+        parallel_copy* p_parallel_copy);
+
+    //
+    // Copies only the data extents of the source file into an empty target file, leaving the holes unallocated.
+    //
+    static
+    status_code
+    copy_sparse_file_data(
+        const file_descriptor p_source_file_descriptor,
+        const file_descriptor p_target_file_descriptor,
+        const uint64 p_number_bytes,
+        uint64* p_bytes_transferred);
+
+    //
+    // Removes a filesystem object from the target path.
+    //
+    static
+    status_code
+    remove_filesystem_object(
+        const std::string& p_target_filesystem_object_path);
+
+    //
+    // Max number of bytes requested to the kernel per copy system call.
+    //
+    static constexpr uint64 c_native_copy_chunk_size = 1024u * 1024u * 1024u;
+
+    //
+    // Size of the user-space buffer for the read/write copy fallback.
+    //
+    static constexpr uint32 c_native_copy_buffer_size = 128u * 1024u;
+
+    //
+    // Size in bytes of the chunks claimed by the workers of a parallel copy.
+    //
+    static constexpr uint64 c_parallel_copy_chunk_size = 64u * 1024u * 1024u;
+
+    //
+    // Max number of thread pool helpers scheduled for a single parallel copy.
+    //
+    static constexpr uint32 c_parallel_copy_max_number_helpers = 8u;
+
+    //
+    // Minimum file size in bytes for replicating updates through the delta transfer engine.
+    //
+    static constexpr uint64 c_delta_transfer_minimum_file_size = 64u * 1024u * 1024u;
+
+    //
+    // Temporary file name template used for atomic replacement of target files.
+    //
+    static constexpr const character* c_temporary_file_name_template = ".modula-XXXXXX";
 
     //
     // Max size for the reading buffer for the rysnc IPC result.
@@ -82,6 +483,21 @@ private:
     // Regex rsync data pattern for synchronization information.
     //
     static constexpr const character* c_rsync_data_pattern = R"(sent (\d+) bytes.*?(\d+(\.\d+)?) bytes/sec)";
+
+    //
+    // Files list name template used for batched rsync processes.
+    //
+    static constexpr const character* c_rsync_files_list_name_template = "modula-files-from-XXXXXX";
+
+    //
+    // Marker prefixed to every transferred file line in the batched rsync output.
+    //
+    static constexpr const character* c_rsync_transferred_file_marker = "<modula>";
+
+    //
+    // Separator between the file name and the transferred bytes in the batched rsync output.
+    //
+    static constexpr character c_rsync_transferred_file_separator = '|';
     
 };
 
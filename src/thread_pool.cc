@@ -6,35 +6,273 @@
 // *************************************
 
 #include <memory>
+#include <charconv>
+#include <algorithm>
 
 #include "thread_pool.hh"
 
 namespace modula
 {
 
+thread_local thread_pool* thread_pool::s_current_thread_pool = nullptr;
+
+thread_local uint16 thread_pool::s_current_worker_index = 0;
+
+thread_local thread_pool::task_allocation_cache thread_pool::s_task_allocation_cache(c_task_allocation_cache_capacity);
+
+thread_pool::task_allocation_cache thread_pool::s_spare_task_allocations(c_max_number_spare_task_allocations);
+
+std::mutex thread_pool::s_spare_task_allocations_lock;
+
+thread_pool_options::thread_pool_options(
+    const uint16 p_max_number_threads)
+    : m_min_number_threads(std::min(c_default_min_number_threads, p_max_number_threads)),
+      m_max_number_threads(p_max_number_threads),
+      m_growth_queue_latency_ms(c_default_growth_queue_latency_ms),
+      m_idle_timeout_ms(c_default_idle_timeout_ms),
+      m_max_queued_tasks(c_default_max_queued_tasks),
+      m_overflow_policy(thread_pool_overflow_policy::block)
+{}
+
+status_code
+thread_pool_options::set_option(
+    const std::string& p_key,
+    const std::string& p_value)
+{
+    if (p_key == c_min_threads_key ||
+        p_key == c_max_threads_key)
+    {
+        uint16 number_threads = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), number_threads);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size())
+        {
+            return status::malformed_configuration_file;
+        }
+
+        if (p_key == c_min_threads_key)
+        {
+            m_min_number_threads = number_threads;
+        }
+        else
+        {
+            m_max_number_threads = number_threads;
+        }
+
+        return status::success;
+    }
+
+    if (p_key == c_growth_queue_latency_ms_key ||
+        p_key == c_idle_timeout_ms_key)
+    {
+        uint32 milliseconds = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), milliseconds);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size())
+        {
+            return status::malformed_configuration_file;
+        }
+
+        if (p_key == c_growth_queue_latency_ms_key)
+        {
+            m_growth_queue_latency_ms = milliseconds;
+        }
+        else
+        {
+            m_idle_timeout_ms = milliseconds;
+        }
+
+        return status::success;
+    }
+
+    if (p_key == c_max_queued_tasks_key)
+    {
+        uint64 max_queued_tasks = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), max_queued_tasks);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size())
+        {
+            return status::malformed_configuration_file;
+        }
+
+        m_max_queued_tasks = max_queued_tasks;
+
+        return status::success;
+    }
+
+    if (p_key == c_overflow_policy_key)
+    {
+        if (p_value == "block")
+        {
+            m_overflow_policy = thread_pool_overflow_policy::block;
+        }
+        else if (p_value == "reject")
+        {
+            m_overflow_policy = thread_pool_overflow_policy::reject;
+        }
+        else if (p_value == "spill")
+        {
+            m_overflow_policy = thread_pool_overflow_policy::spill;
+        }
+        else
+        {
+            return status::malformed_configuration_file;
+        }
+
+        return status::success;
+    }
+
+    return status::malformed_configuration_file;
+}
+
+status_code
+thread_pool_options::validate() const
+{
+    if (m_min_number_threads == 0 ||
+        m_min_number_threads > m_max_number_threads)
+    {
+        return status::malformed_configuration_file;
+    }
+
+    return status::success;
+}
+
+thread_pool::task::task(
+    small_task&& p_function)
+    : m_function(std::move(p_function)),
+      m_enqueue_time(std::chrono::steady_clock::now())
+{}
+
+void*
+thread_pool::task::operator new(
+    const std::size_t p_size)
+{
+    std::vector<void*>& cached_allocations = s_task_allocation_cache.m_allocations;
+
+    if (cached_allocations.empty())
+    {
+        std::scoped_lock<std::mutex> lock(s_spare_task_allocations_lock);
+
+        std::vector<void*>& spare_allocations = s_spare_task_allocations.m_allocations;
+        const uint64 number_transferred_allocations = std::min<uint64>(c_task_allocation_transfer_size, spare_allocations.size());
+
+        cached_allocations.insert(cached_allocations.end(), spare_allocations.end() - number_transferred_allocations, spare_allocations.end());
+        spare_allocations.resize(spare_allocations.size() - number_transferred_allocations);
+    }
+
+    if (cached_allocations.empty())
+    {
+        return ::operator new(p_size);
+    }
+
+    void* allocation = cached_allocations.back();
+    cached_allocations.pop_back();
+
+    return allocation;
+}
+
+void
+thread_pool::task::operator delete(
+    void* p_allocation)
+{
+    std::vector<void*>& cached_allocations = s_task_allocation_cache.m_allocations;
+
+    if (cached_allocations.size() == s_task_allocation_cache.m_capacity)
+    {
+        //
+        // Hand a chunk of the cached allocations over to the other threads, releasing whatever does not fit.
+        //
+        std::scoped_lock<std::mutex> lock(s_spare_task_allocations_lock);
+
+        std::vector<void*>& spare_allocations = s_spare_task_allocations.m_allocations;
+
+        for (uint64 transferred_allocations = 0; transferred_allocations < c_task_allocation_transfer_size; ++transferred_allocations)
+        {
+            if (spare_allocations.size() < s_spare_task_allocations.m_capacity)
+            {
+                spare_allocations.push_back(cached_allocations.back());
+            }
+            else
+            {
+                ::operator delete(cached_allocations.back());
+            }
+
+            cached_allocations.pop_back();
+        }
+    }
+
+    cached_allocations.push_back(p_allocation);
+}
+
+thread_pool::task_allocation_cache::task_allocation_cache(
+    const uint64 p_capacity)
+    : m_capacity(p_capacity)
+{
+    m_allocations.reserve(m_capacity);
+}
+
+thread_pool::task_allocation_cache::~task_allocation_cache()
+{
+    for (void* allocation : m_allocations)
+    {
+        ::operator delete(allocation);
+    }
+}
+
+thread_pool::worker::worker()
+    : m_tasks(c_worker_deque_capacity),
+      m_random_state(0),
+      m_running(false)
+{}
+
 thread_pool::thread_pool(
     status_code* p_status,
-    const uint16 p_number_threads) :
-    m_number_threads(p_number_threads),
+    const thread_pool_options& p_thread_pool_options) :
+    m_options(p_thread_pool_options),
+    m_number_injected_tasks(0),
+    m_number_queued_tasks(0),
+    m_number_parked_workers(0),
+    m_number_active_workers(0),
+    m_number_used_workers(0),
+    m_max_queue_latency_ns(0),
+    m_last_task_taken_time_ns(0),
+    m_number_blocked_producers(0),
+    m_number_rejected_tasks(0),
+    m_number_blocked_submissions(0),
+    m_number_spilled_tasks(0),
+    m_number_threads(0),
     m_stop(false)
 {
     //
-    // Spawn threads for the thread pool.
+    // All worker states are in place before any worker thread may try to steal from them.
     //
-    try
+    for (uint16 worker_index = 0; worker_index < m_options.m_max_number_threads; ++worker_index)
     {
-        for (uint16 thread_index = 0; thread_index < m_number_threads; ++thread_index)
-        {
-            m_worker_threads.emplace_back(&thread_pool::task_handler, this);
+        m_workers.emplace_back(std::make_unique<worker>());
+        m_workers.back()->m_random_state = worker_index + 1;
+    }
 
-            if (!m_worker_threads.back().joinable())
-            {
-                *p_status = status::launch_thread_failed;
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
 
-                return;
-            }
+        //
+        // Spawn the min number of threads for the thread pool.
+        //
+        for (uint16 thread_index = 0; thread_index < m_options.m_min_number_threads; ++thread_index)
+        {
+            *p_status = launch_worker();
+
+            return_if_failed(*p_status)
         }
     }
+
+    try
+    {
+        m_supervisor_thread = std::thread(&thread_pool::supervise_workers, this);
+    }
     catch (const std::system_error& exception)
     {
         *p_status = status::launch_thread_failed;
@@ -54,55 +292,484 @@ thread_pool::~thread_pool()
     // Awake all threads and finish them.
     //
     m_condition.notify_all();
+    m_capacity_condition.notify_all();
+    m_supervisor_condition.notify_all();
 
-    for (std::thread& worker_thread : m_worker_threads)
+    if (m_supervisor_thread.joinable())
     {
-        worker_thread.join();
+        m_supervisor_thread.join();
+    }
+
+    for (std::unique_ptr<worker>& worker : m_workers)
+    {
+        if (worker->m_thread.joinable())
+        {
+            worker->m_thread.join();
+        }
+    }
+
+    //
+    // Tasks left behind when no worker thread could be launched are released unexecuted.
+    //
+    while (!m_injected_tasks.empty())
+    {
+        delete m_injected_tasks.front();
+        m_injected_tasks.pop();
     }
 }
 
 uint16
 thread_pool::get_number_threads() const
 {
-    return m_number_threads;
+    return m_number_threads.load(std::memory_order_relaxed);
 }
 
-void
-thread_pool::task_handler()
+uint16
+thread_pool::get_number_active_threads() const
 {
-    forever
+    return m_number_active_workers.load(std::memory_order_relaxed);
+}
+
+uint16
+thread_pool::get_number_idle_threads() const
+{
+    const uint16 number_threads = get_number_threads();
+    const uint16 number_active_threads = get_number_active_threads();
+
+    return number_threads > number_active_threads ? number_threads - number_active_threads : 0;
+}
+
+uint64
+thread_pool::get_number_queued_tasks() const
+{
+    return m_number_queued_tasks.load(std::memory_order_relaxed);
+}
+
+bool
+thread_pool::is_saturated() const
+{
+    return m_options.m_max_queued_tasks != 0 &&
+        get_number_queued_tasks() >= m_options.m_max_queued_tasks;
+}
+
+uint64
+thread_pool::get_number_rejected_tasks() const
+{
+    return m_number_rejected_tasks.load(std::memory_order_relaxed);
+}
+
+uint64
+thread_pool::get_number_blocked_submissions() const
+{
+    return m_number_blocked_submissions.load(std::memory_order_relaxed);
+}
+
+uint64
+thread_pool::get_number_spilled_tasks() const
+{
+    return m_number_spilled_tasks.load(std::memory_order_relaxed);
+}
+
+thread_pool::schedule_awaitable::schedule_awaitable(
+    thread_pool* p_thread_pool)
+    : m_thread_pool(p_thread_pool),
+      m_scheduled(false)
+{}
+
+bool
+thread_pool::schedule_awaitable::await_ready() const noexcept
+{
+    return false;
+}
+
+bool
+thread_pool::schedule_awaitable::await_suspend(
+    std::coroutine_handle<> p_coroutine)
+{
+    //
+    // Once handed over, the coroutine may be resumed and the awaitable destroyed before the
+    // task submission returns, so the awaitable is only updated when the submission failed.
+    //
+    m_scheduled = true;
+
+    if (!m_thread_pool->submit_task(std::make_unique<task>(
+        [p_coroutine]()
+        {
+            p_coroutine.resume();
+        })))
     {
-        std::function<void()> task;
+        m_scheduled = false;
 
+        return false;
+    }
+
+    return true;
+}
+
+bool
+thread_pool::schedule_awaitable::await_resume() const noexcept
+{
+    return m_scheduled;
+}
+
+thread_pool::schedule_awaitable
+thread_pool::schedule()
+{
+    return schedule_awaitable(this);
+}
+
+bool
+thread_pool::submit_task(
+    std::unique_ptr<task>&& p_task)
+{
+    //
+    // Tasks enqueued from a worker thread stay local to it, away from the lock of the injection queue.
+    //
+    if (s_current_thread_pool == this &&
+        !m_stop.load(std::memory_order_relaxed) &&
+        m_workers[s_current_worker_index]->m_tasks.try_push(p_task.get()))
+    {
+        p_task.release();
+        m_number_queued_tasks.fetch_add(1, std::memory_order_seq_cst);
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        if (m_stop)
+        {
+            return false;
+        }
+
+        if (s_current_thread_pool != this &&
+            !admit_task(lock))
+        {
+            return false;
+        }
+
+        m_injected_tasks.push(p_task.release());
+        m_number_injected_tasks.fetch_add(1, std::memory_order_relaxed);
+        m_number_queued_tasks.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    //
+    // Notify a parked worker of a new task to be executed. Parked workers check for queued tasks
+    // under the lock, so taking it before notifying ensures the notification is never missed.
+    //
+    if (m_number_parked_workers.load(std::memory_order_seq_cst) > 0)
+    {
         {
             std::unique_lock<std::mutex> lock(m_lock);
+        }
+
+        m_condition.notify_one();
+    }
+
+    return true;
+}
 
-            m_condition.wait(lock,
-                [this]
-                {
-                    return this->m_stop ||
-                        !this->m_tasks.empty();
-                });
-
-            //
-            // If the destructor has been invoked, wait for finishing
-            // all pending tasks and then terminate the invoked thread.
-            //
-            if (this->m_stop &&
-                this->m_tasks.empty())
+bool
+thread_pool::admit_task(
+    std::unique_lock<std::mutex>& p_lock)
+{
+    if (!is_saturated())
+    {
+        return true;
+    }
+
+    switch (m_options.m_overflow_policy)
+    {
+        case thread_pool_overflow_policy::reject:
+        {
+            m_number_rejected_tasks.fetch_add(1, std::memory_order_relaxed);
+
+            return false;
+        }
+
+        case thread_pool_overflow_policy::spill:
+        {
+            m_number_spilled_tasks.fetch_add(1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        default:
+        {
+            m_number_blocked_submissions.fetch_add(1, std::memory_order_relaxed);
+            m_number_blocked_producers.fetch_add(1, std::memory_order_seq_cst);
+
+            m_capacity_condition.wait(p_lock, [this]
             {
-                return;
-            }
+                return this->m_stop ||
+                    !this->is_saturated();
+            });
+
+            m_number_blocked_producers.fetch_sub(1, std::memory_order_relaxed);
+
+            return !m_stop;
+        }
+    }
+}
+
+void
+thread_pool::release_capacity()
+{
+    //
+    // Blocked producers check the capacity under the lock, so taking it before notifying ensures the notification is never missed.
+    //
+    if (m_number_blocked_producers.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+        }
+
+        m_capacity_condition.notify_all();
+    }
+}
+
+thread_pool::task*
+thread_pool::take_task(
+    const uint16 p_worker_index)
+{
+    task* next_task = nullptr;
+    worker& current_worker = *m_workers[p_worker_index];
+
+    if (current_worker.m_tasks.try_pop(&next_task))
+    {
+        m_number_queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+
+        return next_task;
+    }
+
+    if (m_number_injected_tasks.load(std::memory_order_relaxed) > 0)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        if (!m_injected_tasks.empty())
+        {
+            next_task = m_injected_tasks.front();
+            m_injected_tasks.pop();
+            m_number_injected_tasks.fetch_sub(1, std::memory_order_relaxed);
+            m_number_queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+
+            return next_task;
+        }
+    }
+
+    //
+    // Steal from the other workers, starting at a random one so that thieves spread across victims.
+    //
+    current_worker.m_random_state ^= current_worker.m_random_state << 13;
+    current_worker.m_random_state ^= current_worker.m_random_state >> 7;
+    current_worker.m_random_state ^= current_worker.m_random_state << 17;
+
+    const uint16 number_used_workers = m_number_used_workers.load(std::memory_order_acquire);
+    const uint16 first_victim_index = current_worker.m_random_state % number_used_workers;
+
+    for (uint16 victim_offset = 0; victim_offset < number_used_workers; ++victim_offset)
+    {
+        const uint16 victim_index = (first_victim_index + victim_offset) % number_used_workers;
+
+        if (victim_index != p_worker_index &&
+            m_workers[victim_index]->m_tasks.try_steal(&next_task))
+        {
+            m_number_queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+
+            return next_task;
+        }
+    }
+
+    return nullptr;
+}
+
+void
+thread_pool::record_queue_latency(
+    const task& p_task)
+{
+    const std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+    const int64 queue_latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(current_time - p_task.m_enqueue_time).count();
 
-            //
-            //  Retrieve and move task from the queue for non-blocking execution.
-            //
-            task = std::move(this->m_tasks.front());
-            this->m_tasks.pop();
+    m_last_task_taken_time_ns.store(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(current_time.time_since_epoch()).count(),
+        std::memory_order_relaxed);
+
+    int64 max_queue_latency_ns = m_max_queue_latency_ns.load(std::memory_order_relaxed);
+
+    while (queue_latency_ns > max_queue_latency_ns &&
+        !m_max_queue_latency_ns.compare_exchange_weak(max_queue_latency_ns, queue_latency_ns, std::memory_order_relaxed))
+    {}
+}
+
+bool
+thread_pool::park_worker(
+    const uint16 p_worker_index)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    m_number_parked_workers.fetch_add(1, std::memory_order_seq_cst);
+
+    const bool task_available = m_condition.wait_for(lock, std::chrono::milliseconds(m_options.m_idle_timeout_ms),
+        [this]
+        {
+            return this->m_stop ||
+                this->m_number_queued_tasks.load(std::memory_order_seq_cst) > 0;
+        });
+
+    m_number_parked_workers.fetch_sub(1, std::memory_order_relaxed);
+
+    //
+    // Retire idle worker threads above the min number of threads. Only the worker thread itself
+    // pushes onto its deque, so an empty deque stays empty once the worker thread is gone.
+    //
+    if (!task_available &&
+        m_number_threads.load(std::memory_order_relaxed) > m_options.m_min_number_threads &&
+        m_workers[p_worker_index]->m_tasks.get_size() == 0)
+    {
+        m_workers[p_worker_index]->m_running = false;
+        m_number_threads.fetch_sub(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    //
+    // If the destructor has been invoked, wait for finishing
+    // all pending tasks and then terminate the invoked thread.
+    //
+    return !(m_stop &&
+        m_number_queued_tasks.load(std::memory_order_seq_cst) == 0);
+}
+
+status_code
+thread_pool::launch_worker()
+{
+    auto free_worker = std::find_if(m_workers.begin(), m_workers.end(), [](const std::unique_ptr<worker>& p_worker)
+    {
+        return !p_worker->m_running;
+    });
+
+    if (free_worker == m_workers.end())
+    {
+        return status::launch_thread_failed;
+    }
+
+    const uint16 worker_index = std::distance(m_workers.begin(), free_worker);
+    worker& launched_worker = **free_worker;
+
+    //
+    // The retired worker thread no longer needs the lock; it only has to return.
+    //
+    if (launched_worker.m_thread.joinable())
+    {
+        launched_worker.m_thread.join();
+    }
+
+    //
+    // The worker state is visible to thieves before the worker thread itself may start stealing.
+    //
+    if (worker_index >= m_number_used_workers.load(std::memory_order_relaxed))
+    {
+        m_number_used_workers.store(worker_index + 1, std::memory_order_release);
+    }
+
+    try
+    {
+        launched_worker.m_thread = std::thread(&thread_pool::task_handler, this, worker_index);
+    }
+    catch (const std::system_error& exception)
+    {
+        return status::launch_thread_failed;
+    }
+
+    launched_worker.m_running = true;
+    m_number_threads.fetch_add(1, std::memory_order_relaxed);
+
+    return status::success;
+}
+
+void
+thread_pool::task_handler(
+    const uint16 p_worker_index)
+{
+    s_current_thread_pool = this;
+    s_current_worker_index = p_worker_index;
+
+    forever
+    {
+        //
+        //  Retrieve the next task for non-blocking execution.
+        //
+        std::unique_ptr<task> next_task(take_task(p_worker_index));
+
+        if (next_task != nullptr)
+        {
+            record_queue_latency(*next_task);
+            release_capacity();
+
+            m_number_active_workers.fetch_add(1, std::memory_order_relaxed);
+            next_task->m_function();
+            m_number_active_workers.fetch_sub(1, std::memory_order_relaxed);
+
+            continue;
+        }
+
+        if (!park_worker(p_worker_index))
+        {
+            return;
+        }
+    }
+}
+
+void
+thread_pool::supervise_workers()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    forever
+    {
+        if (m_supervisor_condition.wait_for(lock, std::chrono::milliseconds(c_supervision_interval_ms), [this] { return this->m_stop.load(); }))
+        {
+            return;
         }
 
-        task();
-    }      
+        const int64 max_queue_latency_ns = m_max_queue_latency_ns.exchange(0, std::memory_order_relaxed);
+        const uint64 number_queued_tasks = m_number_queued_tasks.load(std::memory_order_relaxed);
+
+        if (number_queued_tasks == 0 ||
+            m_number_parked_workers.load(std::memory_order_relaxed) > 0 ||
+            m_number_threads.load(std::memory_order_relaxed) >= m_options.m_max_number_threads)
+        {
+            continue;
+        }
+
+        //
+        // Queued tasks are not taken at all while every worker thread is busy or blocked; the time
+        // since a task was last taken bounds the latency of the tasks still waiting in that case.
+        //
+        const int64 current_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        const int64 queue_latency_ns = std::max(
+            max_queue_latency_ns,
+            current_time_ns - m_last_task_taken_time_ns.load(std::memory_order_relaxed));
+
+        if (queue_latency_ns < static_cast<int64>(m_options.m_growth_queue_latency_ms) * 1000 * 1000)
+        {
+            continue;
+        }
+
+        const uint16 number_launched_threads = std::min<uint64>({
+            number_queued_tasks,
+            static_cast<uint64>(m_options.m_max_number_threads - m_number_threads.load(std::memory_order_relaxed)),
+            c_max_number_threads_launched_per_supervision});
+
+        for (uint16 thread_index = 0; thread_index < number_launched_threads; ++thread_index)
+        {
+            if (status::failed(launch_worker()))
+            {
+                break;
+            }
+        }
+    }
 }
 
 } // namespace modula.
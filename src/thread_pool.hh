@@ -10,13 +10,20 @@
 
 #include "status.hh"
 #include "utilities.hh"
+#include "small_task.hh"
+#include "work_stealing_deque.hh"
 
 #include <queue>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
 #include <vector>
 #include <thread>
 #include <future>
 #include <optional>
+#include <coroutine>
 #include <functional>
 #include <condition_variable>
 
@@ -24,7 +31,154 @@ namespace modula
 {
 
 //
-// Thread pool class for handling concurrent tasks through preallocated threads.
+// Overflow policy enum class for selecting how a thread pool handles tasks submitted beyond its queue capacity.
+// Tasks submitted from the worker threads of the pool itself are continuations of already admitted work and are
+// always admitted, since holding them back could leave the pool waiting on itself.
+//
+enum class thread_pool_overflow_policy : uint8
+{
+
+    //
+    // The producer blocks until the queued tasks drop below the capacity.
+    //
+    block = 0,
+
+    //
+    // The task is rejected and the producer is notified of the failed enqueue.
+    //
+    reject = 1,
+
+    //
+    // The task is admitted beyond the capacity and only counted, leaving the queue unbounded. Meant for producers
+    // which hold their work back in a cheaper representation themselves while the thread pool reports itself
+    // saturated, as the filesystem monitor does with the ready filesystem events; others should block or reject.
+    //
+    spill = 2
+
+};
+
+//
+// Sizing options of a thread pool, configurable through the initial configuration file.
+//
+struct thread_pool_options
+{
+
+    //
+    // Constructor. Defaults the values for the thread pool options.
+    //
+    explicit
+    thread_pool_options(
+        const uint16 p_max_number_threads = c_default_max_number_threads);
+
+    //
+    // Sets a thread pool option out of its configuration key and value.
+    //
+    status_code
+    set_option(
+        const std::string& p_key,
+        const std::string& p_value);
+
+    //
+    // Ensures the options describe a usable thread pool.
+    //
+    status_code
+    validate() const;
+
+    //
+    // Number of worker threads kept alive even when idle.
+    //
+    uint16 m_min_number_threads;
+
+    //
+    // Max number of worker threads the pool grows up to.
+    //
+    uint16 m_max_number_threads;
+
+    //
+    // Queue latency in milliseconds beyond which the pool grows, as long as no worker thread is idle.
+    //
+    uint32 m_growth_queue_latency_ms;
+
+    //
+    // Time in milliseconds a worker thread above the minimum stays idle before retiring.
+    //
+    uint32 m_idle_timeout_ms;
+
+    //
+    // Max number of queued tasks before the overflow policy applies. Zero leaves the queue unbounded.
+    //
+    uint64 m_max_queued_tasks;
+
+    //
+    // Handling of the tasks submitted beyond the max number of queued tasks. Producers block by default.
+    //
+    thread_pool_overflow_policy m_overflow_policy;
+
+    //
+    // Configuration key for the min number of threads.
+    //
+    static constexpr const character* c_min_threads_key = "min_threads";
+
+    //
+    // Configuration key for the max number of threads.
+    //
+    static constexpr const character* c_max_threads_key = "max_threads";
+
+    //
+    // Configuration key for the growth queue latency.
+    //
+    static constexpr const character* c_growth_queue_latency_ms_key = "growth_queue_latency_ms";
+
+    //
+    // Configuration key for the idle timeout.
+    //
+    static constexpr const character* c_idle_timeout_ms_key = "idle_timeout_ms";
+
+    //
+    // Configuration key for the max number of queued tasks.
+    //
+    static constexpr const character* c_max_queued_tasks_key = "max_queued_tasks";
+
+    //
+    // Configuration key for the overflow policy.
+    //
+    static constexpr const character* c_overflow_policy_key = "overflow_policy";
+
+    //
+    // Default min number of threads.
+    //
+    static constexpr uint16 c_default_min_number_threads = 4u;
+
+    //
+    // Default max number of threads.
+    //
+    static constexpr uint16 c_default_max_number_threads = 64u;
+
+    //
+    // Default growth queue latency in milliseconds.
+    //
+    static constexpr uint32 c_default_growth_queue_latency_ms = 5u;
+
+    //
+    // Default idle timeout in milliseconds.
+    //
+    static constexpr uint32 c_default_idle_timeout_ms = 30u * 1000u;
+
+    //
+    // Default max number of queued tasks.
+    //
+    static constexpr uint64 c_default_max_queued_tasks = 64u * 1024u;
+
+};
+
+//
+// Thread pool class for handling concurrent tasks through an elastic set of worker threads. Every worker thread owns a
+// work-stealing deque: tasks enqueued from a worker thread are pushed onto its own deque, while tasks enqueued from any
+// other thread go through a shared injection queue. Idle workers steal from the other workers before parking, and parked
+// workers are only awakened one at a time, as tasks become available. The pool starts with its min number of threads; a
+// supervisor thread grows it while tasks wait too long without any idle worker to take them, which also keeps tasks
+// blocked on other tasks of the pool from starving them, and workers idle for too long retire down to the minimum.
+// The queue is bounded by the max number of queued tasks, beyond which the overflow policy of the pool applies.
 //
 class thread_pool
 {
@@ -36,7 +190,7 @@ public:
     //
     thread_pool(
         status_code* p_status,
-        const uint16 p_number_threads);
+        const thread_pool_options& p_thread_pool_options);
 
     //
     // Destructor. Ensures all threads are finished properly.
@@ -44,11 +198,53 @@ public:
     ~thread_pool();
 
     //
-    // Returns the number of threads used by the pool.
+    // Returns the number of threads currently used by the pool.
     //
     uint16
     get_number_threads() const;
 
+    //
+    // Returns the number of threads currently executing a task.
+    //
+    uint16
+    get_number_active_threads() const;
+
+    //
+    // Returns the number of threads currently waiting for a task.
+    //
+    uint16
+    get_number_idle_threads() const;
+
+    //
+    // Returns the number of tasks waiting to be executed.
+    //
+    uint64
+    get_number_queued_tasks() const;
+
+    //
+    // Returns whether the queued tasks reached the capacity of the pool.
+    //
+    bool
+    is_saturated() const;
+
+    //
+    // Returns the number of tasks rejected for exceeding the capacity of the pool.
+    //
+    uint64
+    get_number_rejected_tasks() const;
+
+    //
+    // Returns the number of submissions which blocked their producer for exceeding the capacity of the pool.
+    //
+    uint64
+    get_number_blocked_submissions() const;
+
+    //
+    // Returns the number of tasks admitted beyond the capacity of the pool.
+    //
+    uint64
+    get_number_spilled_tasks() const;
+
     //
     //  Enqueues a task into the queue.
     //
@@ -60,76 +256,423 @@ public:
         using return_type = typename std::result_of<Function(Args...)>::type;
 
         //
-        // Package destination function and arguments into a simple task wrapper pointer.
+        // Package destination function and arguments into a packaged task, moved as a whole into the enqueued task.
         //
-        std::shared_ptr<std::packaged_task<return_type()>> packaged_task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<Function>(p_function), std::forward<Args>(p_args)...));
-        
-        std::future<return_type> packaged_task_result = packaged_task->get_future();
-
-        {
-            std::unique_lock<std::mutex> lock(m_lock);
-
-            //
-            // If thread pool is in destruction process fail the enqueue request.
-            //
-            if (m_stop)
+        std::packaged_task<return_type()> packaged_task(
+            [function = std::forward<Function>(p_function), ...arguments = std::forward<Args>(p_args)]() mutable -> return_type
             {
-                return std::nullopt;
-            }
-
-            m_tasks.emplace(
-                [packaged_task]()
-                {
-                    (*packaged_task)();
-                });
-        }
+                return std::invoke(function, arguments...);
+            });
+
+        std::future<return_type> packaged_task_result = packaged_task.get_future();
 
         //
-        // Notify the task handler of a new task to be executed.
+        // If thread pool is in destruction process fail the enqueue request.
         //
-        m_condition.notify_one();
+        if (!post(std::move(packaged_task)))
+        {
+            return std::nullopt;
+        }
+
         return std::make_optional<std::future<return_type>>(std::move(packaged_task_result));
     }
 
+    //
+    // Enqueues a function for execution without tracking its completion, sparing the future of enqueue_task.
+    // Returns false when the thread pool is in destruction process, releasing the function without executing it.
+    //
+    template<typename Function>
+    bool
+    post(
+        Function&& p_function)
+    {
+        return submit_task(std::make_unique<task>(
+            small_task(std::forward<Function>(p_function))));
+    }
+
+    //
+    // Awaitable resuming the awaiting coroutine on a worker thread of the pool. When the thread pool is in
+    // destruction process the coroutine is not suspended, and resumes to false on the awaiting thread instead.
+    //
+    class schedule_awaitable
+    {
+
+    public:
+
+        //
+        // Constructor.
+        //
+        explicit
+        schedule_awaitable(
+            thread_pool* p_thread_pool);
+
+        bool
+        await_ready() const noexcept;
+
+        bool
+        await_suspend(
+            std::coroutine_handle<> p_coroutine);
+
+        bool
+        await_resume() const noexcept;
+
+    private:
+
+        //
+        // Thread pool to resume the awaiting coroutine on.
+        //
+        thread_pool* m_thread_pool;
+
+        //
+        // Flag for determining whether the awaiting coroutine was handed over to the thread pool.
+        //
+        bool m_scheduled;
+
+    };
+
+    //
+    // Returns an awaitable which moves the awaiting coroutine onto a worker thread of the pool. The result must be
+    // bound to a variable before being tested, as GCC 12 miscompiles co_await expressions within if conditions.
+    //
+    schedule_awaitable
+    schedule();
+
 private:
 
     //
-    // Handles and executes tasks from the queue.
+    // Type-erased task to be executed by the worker threads, along with the time it was enqueued.
+    // Task allocations are recycled through the task allocation caches instead of returning to the heap.
+    //
+    struct task
+    {
+
+        //
+        // Constructor. Stamps the task with the current time.
+        //
+        explicit
+        task(
+            small_task&& p_function);
+
+        //
+        // Takes a task allocation out of the task allocation cache of the current thread.
+        //
+        static
+        void*
+        operator new(
+            const std::size_t p_size);
+
+        //
+        // Hands a task allocation back to the task allocation cache of the current thread.
+        //
+        static
+        void
+        operator delete(
+            void* p_allocation);
+
+        //
+        // Function to be executed.
+        //
+        small_task m_function;
+
+        //
+        // Time the task was enqueued, for measuring its queue latency.
+        //
+        std::chrono::steady_clock::time_point m_enqueue_time;
+
+    };
+
+    //
+    // Cache of released task allocations. Tasks are mostly released on a different thread than the one which
+    // allocated them, so every thread caches a bounded number of allocations and exchanges them in chunks with
+    // the spare task allocations shared by all threads as its cache fills up or runs out.
+    //
+    struct task_allocation_cache
+    {
+
+        //
+        // Constructor. Reserves room for the max number of cached allocations.
+        //
+        explicit
+        task_allocation_cache(
+            const uint64 p_capacity);
+
+        //
+        // Destructor. Releases the cached allocations back to the heap.
+        //
+        ~task_allocation_cache();
+
+        //
+        // Cached task allocations.
+        //
+        std::vector<void*> m_allocations;
+
+        //
+        // Max number of cached task allocations.
+        //
+        const uint64 m_capacity;
+
+    };
+
+    //
+    // Worker thread state. Worker states are preallocated up to the max number of threads
+    // and reused as worker threads retire and get launched again.
+    //
+    struct worker
+    {
+
+        //
+        // Constructor.
+        //
+        worker();
+
+        //
+        // Tasks enqueued from the worker thread itself, stolen by the other workers when they run out of tasks.
+        //
+        work_stealing_deque<task> m_tasks;
+
+        //
+        // State of the generator picking the first worker to steal from.
+        //
+        uint64 m_random_state;
+
+        //
+        // Worker thread handle. Kept after the worker thread retires until the worker state is reused.
+        //
+        std::thread m_thread;
+
+        //
+        // Flag for determining whether a worker thread runs on the worker state. Guarded by the pool lock.
+        //
+        bool m_running;
+
+    };
+
+    //
+    // Hands a task over to the worker threads, awakening a parked worker if any.
+    // Returns false without running the task when the thread pool is in destruction process.
+    //
+    bool
+    submit_task(
+        std::unique_ptr<task>&& p_task);
+
+    //
+    // Applies the overflow policy to a task submitted from outside the worker threads while the
+    // pool is at capacity. Must be called with the pool lock held, which may be released while
+    // blocking. Returns false when the task must not be enqueued.
+    //
+    bool
+    admit_task(
+        std::unique_lock<std::mutex>& p_lock);
+
+    //
+    // Awakens the producers blocked on the capacity of the pool, if any, once a task was taken.
+    //
+    void
+    release_capacity();
+
+    //
+    // Takes the next task to be executed by a worker thread out of its own deque, the injection
+    // queue or the deque of another worker, in that order. Returns a null task when none was found.
+    //
+    task*
+    take_task(
+        const uint16 p_worker_index);
+
+    //
+    // Records the queue latency of a task taken by a worker thread.
     //
     void
-    task_handler();
+    record_queue_latency(
+        const task& p_task);
 
     //
-    // Worker threads to execute tasks in the pool.
+    // Parks a worker thread until tasks become available. Returns false when the worker thread has
+    // to finish, either because it stayed idle for too long above the min number of threads or
+    // because the thread pool is in destruction process and no tasks are left.
     //
-    std::vector<std::thread> m_worker_threads;
+    bool
+    park_worker(
+        const uint16 p_worker_index);
 
     //
-    // Queue of packaged tasks to be executed.
+    // Launches a worker thread on a free worker state. Must be called with the pool lock held.
     //
-    std::queue<std::function<void()>> m_tasks;
-    
+    status_code
+    launch_worker();
+
+    //
+    // Handles and executes tasks from the queues.
+    //
+    void
+    task_handler(
+        const uint16 p_worker_index);
+
     //
-    // Exclusive lock for synchronizing access to the tasks queue.
+    // Periodically grows the pool while tasks wait for longer than the growth queue latency.
+    //
+    void
+    supervise_workers();
+
+    //
+    // Sizing options of the pool.
+    //
+    const thread_pool_options m_options;
+
+    //
+    // Worker states, as many as the max number of threads.
+    //
+    std::vector<std::unique_ptr<worker>> m_workers;
+
+    //
+    // Queue of tasks enqueued from outside the worker threads, or from a worker whose deque was full.
+    //
+    std::queue<task*> m_injected_tasks;
+
+    //
+    // Number of tasks held by the injection queue, for checking it without taking the lock.
+    //
+    std::atomic<uint64> m_number_injected_tasks;
+
+    //
+    // Number of tasks held across the injection queue and the worker deques.
+    //
+    std::atomic<uint64> m_number_queued_tasks;
+
+    //
+    // Number of worker threads parked on the condition.
+    //
+    std::atomic<uint16> m_number_parked_workers;
+
+    //
+    // Number of worker threads executing a task.
+    //
+    std::atomic<uint16> m_number_active_workers;
+
+    //
+    // Number of worker states ever used, bounding the workers visited when stealing.
+    //
+    std::atomic<uint16> m_number_used_workers;
+
+    //
+    // Max queue latency in nanoseconds of the tasks taken since the last supervision.
+    //
+    std::atomic<int64> m_max_queue_latency_ns;
+
+    //
+    // Time in nanoseconds since the steady clock epoch at which a worker thread last took a task.
+    //
+    std::atomic<int64> m_last_task_taken_time_ns;
+
+    //
+    // Exclusive lock for synchronizing access to the injection queue, the parking of worker threads and the worker states.
     //
     std::mutex m_lock;
 
     //
-    // Condition for awakening worker threads.
+    // Condition for awakening parked worker threads.
     //
     std::condition_variable m_condition;
 
     //
-    // Number of threads to be spawned for the pool.
+    // Condition for awakening the producers blocked on the capacity of the pool.
+    //
+    std::condition_variable m_capacity_condition;
+
+    //
+    // Number of producers blocked on the capacity of the pool.
+    //
+    std::atomic<uint32> m_number_blocked_producers;
+
+    //
+    // Number of tasks rejected for exceeding the capacity of the pool.
+    //
+    std::atomic<uint64> m_number_rejected_tasks;
+
+    //
+    // Number of submissions which blocked their producer for exceeding the capacity of the pool.
+    //
+    std::atomic<uint64> m_number_blocked_submissions;
+
+    //
+    // Number of tasks admitted beyond the capacity of the pool.
+    //
+    std::atomic<uint64> m_number_spilled_tasks;
+
+    //
+    // Condition for awakening the supervisor thread on destruction.
+    //
+    std::condition_variable m_supervisor_condition;
+
+    //
+    // Supervisor thread handle.
     //
-    uint16 m_number_threads;
+    std::thread m_supervisor_thread;
+
+    //
+    // Number of running worker threads.
+    //
+    std::atomic<uint16> m_number_threads;
 
     //
     // Flag for stopping worker threads.
     //
-    bool m_stop;
-    
+    std::atomic<bool> m_stop;
+
+    //
+    // Thread pool the current thread works for, if any.
+    //
+    static thread_local thread_pool* s_current_thread_pool;
+
+    //
+    // Index of the current worker thread within its thread pool.
+    //
+    static thread_local uint16 s_current_worker_index;
+
+    //
+    // Task allocations cached by the current thread.
+    //
+    static thread_local task_allocation_cache s_task_allocation_cache;
+
+    //
+    // Spare task allocations shared by all threads.
+    //
+    static task_allocation_cache s_spare_task_allocations;
+
+    //
+    // Lock for synchronizing access to the spare task allocations.
+    //
+    static std::mutex s_spare_task_allocations_lock;
+
+    //
+    // Max number of tasks held by the deque of a worker thread.
+    //
+    static constexpr uint64 c_worker_deque_capacity = 1024u;
+
+    //
+    // Interval in milliseconds between supervisions of the pool.
+    //
+    static constexpr uint32 c_supervision_interval_ms = 5u;
+
+    //
+    // Max number of worker threads launched on a single supervision.
+    //
+    static constexpr uint16 c_max_number_threads_launched_per_supervision = 8u;
+
+    //
+    // Max number of task allocations cached by a thread.
+    //
+    static constexpr uint64 c_task_allocation_cache_capacity = 64u;
+
+    //
+    // Number of task allocations exchanged at once between a thread and the spare task allocations.
+    //
+    static constexpr uint64 c_task_allocation_transfer_size = c_task_allocation_cache_capacity / 2u;
+
+    //
+    // Max number of spare task allocations shared by all threads.
+    //
+    static constexpr uint64 c_max_number_spare_task_allocations = 4u * 1024u;
+
 };
 
 } // namespace modula.
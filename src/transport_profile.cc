@@ -0,0 +1,99 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'transport_profile.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "transport_profile.hh"
+
+#include <format>
+#include <charconv>
+
+namespace modula
+{
+
+transport_profile::transport_profile()
+    : m_synchronization_strategy(synchronization_strategy::native),
+      m_compression_codec(compression_codec::none),
+      m_compression_level(0),
+      m_checksum_policy(checksum_policy::metadata),
+      m_durability_mode(durability_mode::none),
+      m_delta_application_mode(delta_application_mode::temporary)
+{}
+
+status_code
+transport_profile::set_option(
+    const std::string& p_key,
+    const std::string& p_value)
+{
+    if (p_key == c_strategy_key)
+    {
+        return parse_name(p_value, c_synchronization_strategy_names, &m_synchronization_strategy);
+    }
+
+    if (p_key == c_compression_key)
+    {
+        return parse_name(p_value, c_compression_codec_names, &m_compression_codec);
+    }
+
+    if (p_key == c_checksum_key)
+    {
+        return parse_name(p_value, c_checksum_policy_names, &m_checksum_policy);
+    }
+
+    if (p_key == c_durability_key)
+    {
+        return parse_name(p_value, c_durability_mode_names, &m_durability_mode);
+    }
+
+    if (p_key == c_delta_application_key)
+    {
+        return parse_name(p_value, c_delta_application_mode_names, &m_delta_application_mode);
+    }
+
+    if (p_key == c_compression_level_key)
+    {
+        uint32 compression_level = 0;
+        const std::from_chars_result result = std::from_chars(p_value.data(), p_value.data() + p_value.size(), compression_level);
+
+        if (result.ec != std::errc() ||
+            result.ptr != p_value.data() + p_value.size() ||
+            compression_level > c_max_compression_level)
+        {
+            return status::malformed_configuration_file;
+        }
+
+        m_compression_level = static_cast<uint8>(compression_level);
+
+        return status::success;
+    }
+
+    return status::malformed_configuration_file;
+}
+
+const character*
+transport_profile::get_compression_codec_name() const
+{
+    return c_compression_codec_names[static_cast<uint8>(m_compression_codec)];
+}
+
+std::string
+transport_profile::to_string() const
+{
+    return std::format("{}={}, {}={}, {}={}, {}={}, {}={}, {}={}",
+        c_strategy_key,
+        c_synchronization_strategy_names[static_cast<uint8>(m_synchronization_strategy)],
+        c_compression_key,
+        c_compression_codec_names[static_cast<uint8>(m_compression_codec)],
+        c_compression_level_key,
+        static_cast<uint32>(m_compression_level),
+        c_checksum_key,
+        c_checksum_policy_names[static_cast<uint8>(m_checksum_policy)],
+        c_durability_key,
+        c_durability_mode_names[static_cast<uint8>(m_durability_mode)],
+        c_delta_application_key,
+        c_delta_application_mode_names[static_cast<uint8>(m_delta_application_mode)]);
+}
+
+} // namespace modula.
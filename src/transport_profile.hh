@@ -0,0 +1,294 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'transport_profile.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef TRANSPORT_PROFILE_
+#define TRANSPORT_PROFILE_
+
+#include "status.hh"
+#include "utilities.hh"
+
+#include <array>
+#include <string>
+
+namespace modula
+{
+
+//
+// Synchronization strategy enum class for selecting the transport used for a target directory.
+//
+enum class synchronization_strategy : uint8
+{
+
+    //
+    // In-process copy through copy_file_range/sendfile with a read/write fallback.
+    // Reflinks are used automatically when the target directory supports them.
+    //
+    native = 0,
+
+    //
+    // Spawned rsync process per synchronization task.
+    //
+    rsync = 1,
+
+    //
+    // In-process copy with the file data moved asynchronously through the io_uring transfer engine.
+    //
+    io_uring = 2,
+
+    //
+    // In-process copy expected to be served through reflinks. Behaves as the native
+    // strategy, but a target directory without reflink support is reported on startup.
+    //
+    reflink = 3
+
+};
+
+//
+// Compression codec enum class for transports which move data over the wire.
+//
+enum class compression_codec : uint8
+{
+
+    //
+    // No compression.
+    //
+    none = 0,
+
+    //
+    // Zlib compression.
+    //
+    zlib = 1,
+
+    //
+    // Zstandard compression.
+    //
+    zstd = 2,
+
+    //
+    // LZ4 compression.
+    //
+    lz4 = 3
+
+};
+
+//
+// Checksum policy enum class for deciding how replicated data is validated.
+//
+enum class checksum_policy : uint8
+{
+
+    //
+    // Files are compared by size and modification time only.
+    //
+    metadata = 0,
+
+    //
+    // Files are compared by content. Rsync transfers decide through checksums
+    // and in-process copies verify the target content against the source.
+    //
+    content = 1
+
+};
+
+//
+// Durability mode enum class for deciding when replicated data is flushed to stable storage.
+//
+enum class durability_mode : uint8
+{
+
+    //
+    // Data is left to the page cache writeback.
+    //
+    none = 0,
+
+    //
+    // File data is flushed before the file is renamed into the target path.
+    //
+    file = 1,
+
+    //
+    // File data is flushed and the parent directory is flushed after the rename.
+    //
+    full = 2
+
+};
+
+//
+// Delta application mode enum class for deciding where delta transfers reconstruct the updated file.
+//
+enum class delta_application_mode : uint8
+{
+
+    //
+    // The updated file is reconstructed into a temporary file renamed over the target path once complete,
+    // so the target path holds either the previous or the updated content at any time.
+    //
+    temporary = 0,
+
+    //
+    // Literal data is written directly into the target file when every matched block remains at its offset.
+    // Saves rewriting the unchanged blocks at the cost of leaving a partially updated file behind on failure.
+    //
+    in_place = 1
+
+};
+
+//
+// Transport profile class for matching the replication into a target directory to its cost model,
+// e.g. local SSDs favor reflinks or native copies while remote targets favor compressed rsync transfers.
+//
+class transport_profile
+{
+
+public:
+
+    //
+    // Constructor. Defaults the values for the transport profile.
+    //
+    transport_profile();
+
+    //
+    // Sets a transport profile option out of its configuration key and value.
+    //
+    status_code
+    set_option(
+        const std::string& p_key,
+        const std::string& p_value);
+
+    //
+    // Returns the configuration name of the compression codec.
+    //
+    const character*
+    get_compression_codec_name() const;
+
+    //
+    // Returns the transport profile text representation for logging.
+    //
+    std::string
+    to_string() const;
+
+    //
+    // Transport used for the target directory.
+    //
+    synchronization_strategy m_synchronization_strategy;
+
+    //
+    // Compression codec used by transports moving data over the wire.
+    //
+    compression_codec m_compression_codec;
+
+    //
+    // Compression level for the codec. Zero selects the codec default.
+    //
+    uint8 m_compression_level;
+
+    //
+    // Checksum policy for validating replicated data.
+    //
+    checksum_policy m_checksum_policy;
+
+    //
+    // Durability mode for flushing replicated data.
+    //
+    durability_mode m_durability_mode;
+
+    //
+    // Delta application mode for delta transfers.
+    //
+    delta_application_mode m_delta_application_mode;
+
+    //
+    // Configuration key for the synchronization strategy.
+    //
+    static constexpr const character* c_strategy_key = "strategy";
+
+    //
+    // Configuration key for the compression codec.
+    //
+    static constexpr const character* c_compression_key = "compression";
+
+    //
+    // Configuration key for the compression level.
+    //
+    static constexpr const character* c_compression_level_key = "compression_level";
+
+    //
+    // Configuration key for the checksum policy.
+    //
+    static constexpr const character* c_checksum_key = "checksum";
+
+    //
+    // Configuration key for the durability mode.
+    //
+    static constexpr const character* c_durability_key = "durability";
+
+    //
+    // Configuration key for the delta application mode.
+    //
+    static constexpr const character* c_delta_application_key = "delta_application";
+
+    //
+    // Max compression level accepted across codecs.
+    //
+    static constexpr uint8 c_max_compression_level = 22u;
+
+private:
+
+    //
+    // Parses a configuration value into the index of its name within a names table.
+    //
+    template<typename Enum, std::size_t Size>
+    static
+    status_code
+    parse_name(
+        const std::string& p_value,
+        const std::array<const character*, Size>& p_names,
+        Enum* p_enum)
+    {
+        for (uint64 name_index = 0; name_index < p_names.size(); ++name_index)
+        {
+            if (p_value == p_names[name_index])
+            {
+                *p_enum = static_cast<Enum>(name_index);
+
+                return status::success;
+            }
+        }
+
+        return status::malformed_configuration_file;
+    }
+
+    //
+    // Configuration names of the synchronization strategies, indexed by value.
+    //
+    static constexpr std::array<const character*, 4> c_synchronization_strategy_names = {"native", "rsync", "io_uring", "reflink"};
+
+    //
+    // Configuration names of the compression codecs, indexed by value.
+    //
+    static constexpr std::array<const character*, 4> c_compression_codec_names = {"none", "zlib", "zstd", "lz4"};
+
+    //
+    // Configuration names of the checksum policies, indexed by value.
+    //
+    static constexpr std::array<const character*, 2> c_checksum_policy_names = {"metadata", "content"};
+
+    //
+    // Configuration names of the durability modes, indexed by value.
+    //
+    static constexpr std::array<const character*, 3> c_durability_mode_names = {"none", "file", "full"};
+
+    //
+    // Configuration names of the delta application modes, indexed by value.
+    //
+    static constexpr std::array<const character*, 2> c_delta_application_mode_names = {"temporary", "in_place"};
+
+};
+
+} // namespace modula.
+
+#endif
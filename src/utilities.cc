@@ -7,9 +7,15 @@
 
 #include "utilities.hh"
 
+#include <cerrno>
+#include <fcntl.h>
 #include <fstream>
+#include <unistd.h>
+#include <algorithm>
 #include <stdexcept>
 #include <filesystem>
+#include <sys/stat.h>
+#include <linux/falloc.h>
 
 namespace modula
 {
@@ -93,6 +99,234 @@ get_file_size(
     return file_size_mib;
 }
 
+bool
+find_next_data_extent(
+    const file_descriptor p_file_descriptor,
+    const uint64 p_offset,
+    const uint64 p_end_offset,
+    uint64* p_data_offset,
+    uint64* p_data_end_offset)
+{
+    if (p_offset >= p_end_offset)
+    {
+        return false;
+    }
+
+    const off_t data_offset = lseek(p_file_descriptor, p_offset, SEEK_DATA);
+
+    if (data_offset == -1)
+    {
+        if (errno == ENXIO)
+        {
+            //
+            // Only a hole remains past the offset.
+            //
+            return false;
+        }
+
+        *p_data_offset = p_offset;
+        *p_data_end_offset = p_end_offset;
+
+        return true;
+    }
+
+    if (static_cast<uint64>(data_offset) >= p_end_offset)
+    {
+        return false;
+    }
+
+    const off_t hole_offset = lseek(p_file_descriptor, data_offset, SEEK_HOLE);
+
+    *p_data_offset = data_offset;
+    *p_data_end_offset = hole_offset == -1 ? p_end_offset : std::min<uint64>(hole_offset, p_end_offset);
+
+    return true;
+}
+
+uint64
+get_allocated_size(
+    const file_descriptor p_file_descriptor)
+{
+    struct stat file_stat;
+
+    if (system_call_failed(fstat(p_file_descriptor, &file_stat)))
+    {
+        //
+        // Consider a failed retrieval as no allocation.
+        //
+        return 0;
+    }
+
+    return static_cast<uint64>(file_stat.st_blocks) * 512u;
+}
+
+status_code
+copy_data_extents(
+    const file_descriptor p_input_file_descriptor,
+    const uint64 p_input_offset,
+    const file_descriptor p_output_file_descriptor,
+    const uint64 p_output_offset,
+    const uint64 p_length,
+    const bool p_punch_holes,
+    uint64* p_number_bytes_copied)
+{
+    status_code status = status::success;
+    const uint64 input_end_offset = p_input_offset + p_length;
+    uint64 input_offset = p_input_offset;
+    uint64 data_offset = 0;
+    uint64 data_end_offset = 0;
+
+    while (input_offset < input_end_offset)
+    {
+        if (!find_next_data_extent(p_input_file_descriptor, input_offset, input_end_offset, &data_offset, &data_end_offset))
+        {
+            data_offset = input_end_offset;
+            data_end_offset = input_end_offset;
+        }
+
+        if (p_punch_holes &&
+            data_offset > input_offset)
+        {
+            //
+            // The input turned this range into a hole; release the stale blocks of the output file.
+            //
+            if (system_call_failed(fallocate(
+                p_output_file_descriptor,
+                FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                p_output_offset + (input_offset - p_input_offset),
+                data_offset - input_offset)))
+            {
+                if (errno != EOPNOTSUPP)
+                {
+                    return status::file_write_failed;
+                }
+
+                //
+                // Hole punching is not supported by the filesystem; write the zeroes instead.
+                //
+                data_offset = input_offset;
+            }
+        }
+
+        if (data_end_offset > data_offset)
+        {
+            status = copy_file_range_at(
+                p_input_file_descriptor,
+                data_offset,
+                p_output_file_descriptor,
+                p_output_offset + (data_offset - p_input_offset),
+                data_end_offset - data_offset);
+
+            return_status_if_failed(status)
+
+            *p_number_bytes_copied += data_end_offset - data_offset;
+        }
+
+        input_offset = data_end_offset;
+    }
+
+    return status;
+}
+
+status_code
+copy_file_range_at(
+    const file_descriptor p_input_file_descriptor,
+    uint64 p_input_offset,
+    const file_descriptor p_output_file_descriptor,
+    uint64 p_output_offset,
+    uint64 p_length)
+{
+    static thread_local byte copy_buffer[c_file_copy_buffer_size];
+
+    bool copy_file_range_supported = true;
+
+    while (p_length > 0)
+    {
+        if (copy_file_range_supported)
+        {
+            loff_t input_offset = p_input_offset;
+            loff_t output_offset = p_output_offset;
+
+            const ssize_t number_bytes_copied = copy_file_range(
+                p_input_file_descriptor,
+                &input_offset,
+                p_output_file_descriptor,
+                &output_offset,
+                p_length,
+                0 /* No flags. */);
+
+            if (number_bytes_copied == -1 &&
+                (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL))
+            {
+                copy_file_range_supported = false;
+
+                continue;
+            }
+
+            if (number_bytes_copied == -1 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (number_bytes_copied <= 0)
+            {
+                return status::file_write_failed;
+            }
+
+            p_input_offset += number_bytes_copied;
+            p_output_offset += number_bytes_copied;
+            p_length -= number_bytes_copied;
+
+            continue;
+        }
+
+        const ssize_t number_bytes_read = pread(
+            p_input_file_descriptor,
+            copy_buffer,
+            std::min<uint64>(p_length, c_file_copy_buffer_size),
+            p_input_offset);
+
+        if (number_bytes_read == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (number_bytes_read <= 0)
+        {
+            return status::file_write_failed;
+        }
+
+        ssize_t number_bytes_written = 0;
+
+        while (number_bytes_written < number_bytes_read)
+        {
+            const ssize_t write_result = pwrite(
+                p_output_file_descriptor,
+                copy_buffer + number_bytes_written,
+                number_bytes_read - number_bytes_written,
+                p_output_offset + number_bytes_written);
+
+            if (write_result == -1 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (write_result == -1)
+            {
+                return status::file_write_failed;
+            }
+
+            number_bytes_written += write_result;
+        }
+
+        p_input_offset += number_bytes_read;
+        p_output_offset += number_bytes_read;
+        p_length -= number_bytes_read;
+    }
+
+    return status::success;
+}
+
 } // namespace utilities.
 
 } // namespace modula.
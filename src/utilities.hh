@@ -97,6 +97,11 @@ using file_descriptor = int;
 //
 static constexpr file_descriptor c_invalid_file_descriptor = -1;
 
+//
+// Size of the user-space buffer for the pread/pwrite file copy fallback.
+//
+static constexpr uint32 c_file_copy_buffer_size = 128u * 1024u;
+
 //
 // Utility functions.
 //
@@ -140,6 +145,50 @@ uint32
 get_file_size(
     const std::string& p_file_path);
 
+//
+// Finds the first data extent of a file within the given range, skipping holes. Returns false when
+// no data remains in the range. Filesystems without hole reporting expose the range as a single extent.
+//
+bool
+find_next_data_extent(
+    const file_descriptor p_file_descriptor,
+    const uint64 p_offset,
+    const uint64 p_end_offset,
+    uint64* p_data_offset,
+    uint64* p_data_end_offset);
+
+//
+// Gets the number of bytes allocated on disk for a file.
+//
+uint64
+get_allocated_size(
+    const file_descriptor p_file_descriptor);
+
+//
+// Copies only the data extents of an input range into the output file, leaving the holes unwritten.
+// When requested, the holes of the input range are punched into the output file instead.
+//
+status_code
+copy_data_extents(
+    const file_descriptor p_input_file_descriptor,
+    const uint64 p_input_offset,
+    const file_descriptor p_output_file_descriptor,
+    const uint64 p_output_offset,
+    const uint64 p_length,
+    const bool p_punch_holes,
+    uint64* p_number_bytes_copied);
+
+//
+// Copies a byte range between two file descriptors at explicit offsets, without moving their file offsets.
+//
+status_code
+copy_file_range_at(
+    const file_descriptor p_input_file_descriptor,
+    uint64 p_input_offset,
+    const file_descriptor p_output_file_descriptor,
+    uint64 p_output_offset,
+    uint64 p_length);
+
 } // namespace utilities.
 
 } // namespace modula.
@@ -0,0 +1,346 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'watch_descriptor_index.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "watch_descriptor_index.hh"
+
+namespace modula
+{
+
+watch_descriptor_index::watch_descriptor_index()
+    : m_number_released_name_bytes(0),
+      m_number_watch_descriptors(0)
+{}
+
+void
+watch_descriptor_index::add_root(
+    const file_descriptor p_watch_descriptor)
+{
+    add_child(
+        p_watch_descriptor,
+        c_invalid_file_descriptor,
+        "");
+}
+
+void
+watch_descriptor_index::add_child(
+    const file_descriptor p_watch_descriptor,
+    const file_descriptor p_parent_watch_descriptor,
+    const std::string_view p_name)
+{
+    if (p_watch_descriptor < 0)
+    {
+        return;
+    }
+
+    if (static_cast<uint64>(p_watch_descriptor) >= m_entries.size())
+    {
+        m_entries.resize(p_watch_descriptor + 1, entry{
+            c_invalid_file_descriptor,
+            c_invalid_file_descriptor,
+            c_invalid_file_descriptor,
+            c_invalid_file_descriptor,
+            c_invalid_file_descriptor,
+            0,
+            0});
+    }
+
+    entry& index_entry = m_entries[p_watch_descriptor];
+
+    if (index_entry.m_root_watch_descriptor != c_invalid_file_descriptor)
+    {
+        //
+        // The kernel hands out the same watch descriptor for an already watched directory; refresh its location.
+        // Its children remain linked to it, as they moved along with it.
+        //
+        unlink_from_parent(p_watch_descriptor);
+        release_name(index_entry);
+    }
+    else
+    {
+        ++m_number_watch_descriptors;
+    }
+
+    index_entry.m_parent_watch_descriptor = p_parent_watch_descriptor;
+    index_entry.m_root_watch_descriptor = contains(p_parent_watch_descriptor) ?
+        m_entries[p_parent_watch_descriptor].m_root_watch_descriptor :
+        p_watch_descriptor;
+    index_entry.m_name_offset = m_names.size();
+    index_entry.m_name_length = p_name.size();
+    index_entry.m_previous_sibling_watch_descriptor = c_invalid_file_descriptor;
+    index_entry.m_next_sibling_watch_descriptor = c_invalid_file_descriptor;
+
+    m_names.append(p_name);
+
+    if (contains(p_parent_watch_descriptor))
+    {
+        entry& parent_entry = m_entries[p_parent_watch_descriptor];
+
+        if (parent_entry.m_first_child_watch_descriptor != c_invalid_file_descriptor)
+        {
+            m_entries[parent_entry.m_first_child_watch_descriptor].m_previous_sibling_watch_descriptor = p_watch_descriptor;
+        }
+
+        index_entry.m_next_sibling_watch_descriptor = parent_entry.m_first_child_watch_descriptor;
+        parent_entry.m_first_child_watch_descriptor = p_watch_descriptor;
+    }
+}
+
+void
+watch_descriptor_index::remove(
+    const file_descriptor p_watch_descriptor)
+{
+    if (!contains(p_watch_descriptor))
+    {
+        return;
+    }
+
+    unlink_from_parent(p_watch_descriptor);
+
+    entry& index_entry = m_entries[p_watch_descriptor];
+
+    //
+    // Children left behind are orphaned; they are no longer reachable through any subtree.
+    //
+    for (file_descriptor child_watch_descriptor = index_entry.m_first_child_watch_descriptor;
+        child_watch_descriptor != c_invalid_file_descriptor;)
+    {
+        entry& child_entry = m_entries[child_watch_descriptor];
+
+        child_watch_descriptor = child_entry.m_next_sibling_watch_descriptor;
+        child_entry.m_previous_sibling_watch_descriptor = c_invalid_file_descriptor;
+        child_entry.m_next_sibling_watch_descriptor = c_invalid_file_descriptor;
+    }
+
+    release_name(index_entry);
+
+    index_entry.m_parent_watch_descriptor = c_invalid_file_descriptor;
+    index_entry.m_first_child_watch_descriptor = c_invalid_file_descriptor;
+    index_entry.m_root_watch_descriptor = c_invalid_file_descriptor;
+    index_entry.m_name_offset = 0;
+    index_entry.m_name_length = 0;
+
+    --m_number_watch_descriptors;
+}
+
+bool
+watch_descriptor_index::contains(
+    const file_descriptor p_watch_descriptor) const
+{
+    return p_watch_descriptor >= 0 &&
+        static_cast<uint64>(p_watch_descriptor) < m_entries.size() &&
+        m_entries[p_watch_descriptor].m_root_watch_descriptor != c_invalid_file_descriptor;
+}
+
+file_descriptor
+watch_descriptor_index::get_root_watch_descriptor(
+    const file_descriptor p_watch_descriptor) const
+{
+    if (!contains(p_watch_descriptor))
+    {
+        return c_invalid_file_descriptor;
+    }
+
+    return m_entries[p_watch_descriptor].m_root_watch_descriptor;
+}
+
+std::string
+watch_descriptor_index::get_relative_path(
+    const file_descriptor p_watch_descriptor,
+    const std::string_view p_name) const
+{
+    std::string relative_path;
+
+    append_relative_path(
+        p_watch_descriptor,
+        p_name,
+        &relative_path);
+
+    return relative_path;
+}
+
+void
+watch_descriptor_index::append_relative_path(
+    const file_descriptor p_watch_descriptor,
+    const std::string_view p_name,
+    std::string* p_relative_path) const
+{
+    const uint64 relative_path_offset = p_relative_path->size();
+
+    append_directory_path(
+        p_watch_descriptor,
+        relative_path_offset,
+        p_relative_path);
+
+    if (!p_name.empty())
+    {
+        if (p_relative_path->size() > relative_path_offset)
+        {
+            p_relative_path->push_back('/');
+        }
+
+        p_relative_path->append(p_name);
+    }
+}
+
+void
+watch_descriptor_index::collect_subtree_watch_descriptors(
+    const file_descriptor p_parent_watch_descriptor,
+    const std::string_view p_name,
+    std::vector<file_descriptor>* p_watch_descriptors) const
+{
+    if (!contains(p_parent_watch_descriptor))
+    {
+        return;
+    }
+
+    file_descriptor subtree_watch_descriptor = m_entries[p_parent_watch_descriptor].m_first_child_watch_descriptor;
+
+    while (subtree_watch_descriptor != c_invalid_file_descriptor)
+    {
+        const entry& index_entry = m_entries[subtree_watch_descriptor];
+
+        if (std::string_view(m_names).substr(index_entry.m_name_offset, index_entry.m_name_length) == p_name)
+        {
+            break;
+        }
+
+        subtree_watch_descriptor = index_entry.m_next_sibling_watch_descriptor;
+    }
+
+    if (subtree_watch_descriptor == c_invalid_file_descriptor)
+    {
+        return;
+    }
+
+    //
+    // Walk the subtree depth-first through the child and sibling links, climbing back up once a branch is exhausted.
+    //
+    file_descriptor watch_descriptor = subtree_watch_descriptor;
+
+    forever
+    {
+        p_watch_descriptors->push_back(watch_descriptor);
+
+        if (m_entries[watch_descriptor].m_first_child_watch_descriptor != c_invalid_file_descriptor)
+        {
+            watch_descriptor = m_entries[watch_descriptor].m_first_child_watch_descriptor;
+
+            continue;
+        }
+
+        while (watch_descriptor != subtree_watch_descriptor &&
+            m_entries[watch_descriptor].m_next_sibling_watch_descriptor == c_invalid_file_descriptor)
+        {
+            watch_descriptor = m_entries[watch_descriptor].m_parent_watch_descriptor;
+        }
+
+        if (watch_descriptor == subtree_watch_descriptor)
+        {
+            return;
+        }
+
+        watch_descriptor = m_entries[watch_descriptor].m_next_sibling_watch_descriptor;
+    }
+}
+
+uint64
+watch_descriptor_index::get_number_watch_descriptors() const
+{
+    return m_number_watch_descriptors;
+}
+
+void
+watch_descriptor_index::unlink_from_parent(
+    const file_descriptor p_watch_descriptor)
+{
+    entry& index_entry = m_entries[p_watch_descriptor];
+
+    if (index_entry.m_previous_sibling_watch_descriptor != c_invalid_file_descriptor)
+    {
+        m_entries[index_entry.m_previous_sibling_watch_descriptor].m_next_sibling_watch_descriptor = index_entry.m_next_sibling_watch_descriptor;
+    }
+    else if (contains(index_entry.m_parent_watch_descriptor) &&
+        m_entries[index_entry.m_parent_watch_descriptor].m_first_child_watch_descriptor == p_watch_descriptor)
+    {
+        m_entries[index_entry.m_parent_watch_descriptor].m_first_child_watch_descriptor = index_entry.m_next_sibling_watch_descriptor;
+    }
+
+    if (index_entry.m_next_sibling_watch_descriptor != c_invalid_file_descriptor)
+    {
+        m_entries[index_entry.m_next_sibling_watch_descriptor].m_previous_sibling_watch_descriptor = index_entry.m_previous_sibling_watch_descriptor;
+    }
+
+    index_entry.m_previous_sibling_watch_descriptor = c_invalid_file_descriptor;
+    index_entry.m_next_sibling_watch_descriptor = c_invalid_file_descriptor;
+}
+
+void
+watch_descriptor_index::release_name(
+    entry& p_entry)
+{
+    m_number_released_name_bytes += p_entry.m_name_length;
+
+    if (m_number_released_name_bytes * 2 <= m_names.size())
+    {
+        return;
+    }
+
+    //
+    // Most of the arena belongs to unregistered entries; rebuild it with the live name segments only.
+    //
+    p_entry.m_name_length = 0;
+
+    std::string names;
+    names.reserve(m_names.size() - m_number_released_name_bytes);
+
+    for (entry& index_entry : m_entries)
+    {
+        if (index_entry.m_root_watch_descriptor == c_invalid_file_descriptor)
+        {
+            continue;
+        }
+
+        const uint32 name_offset = names.size();
+        names.append(m_names, index_entry.m_name_offset, index_entry.m_name_length);
+        index_entry.m_name_offset = name_offset;
+    }
+
+    m_names = std::move(names);
+    m_number_released_name_bytes = 0;
+}
+
+void
+watch_descriptor_index::append_directory_path(
+    const file_descriptor p_watch_descriptor,
+    const uint64 p_relative_path_offset,
+    std::string* p_relative_path) const
+{
+    if (!contains(p_watch_descriptor) ||
+        m_entries[p_watch_descriptor].m_parent_watch_descriptor == c_invalid_file_descriptor)
+    {
+        return;
+    }
+
+    const entry& index_entry = m_entries[p_watch_descriptor];
+
+    //
+    // Name segments are appended from the source directory down to the leaf; the recursion depth is bounded by the tree depth.
+    //
+    append_directory_path(
+        index_entry.m_parent_watch_descriptor,
+        p_relative_path_offset,
+        p_relative_path);
+
+    if (p_relative_path->size() > p_relative_path_offset)
+    {
+        p_relative_path->push_back('/');
+    }
+
+    p_relative_path->append(m_names, index_entry.m_name_offset, index_entry.m_name_length);
+}
+
+} // namespace modula.
@@ -0,0 +1,201 @@
+// *************************************
+// Modula Replication Engine
+// Core
+// 'watch_descriptor_index.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef WATCH_DESCRIPTOR_INDEX_
+#define WATCH_DESCRIPTOR_INDEX_
+
+#include "utilities.hh"
+
+#include <string>
+#include <vector>
+#include <string_view>
+
+namespace modula
+{
+
+//
+// Watch descriptor index class for resolving the watch descriptors of a recursively watched source
+// directory into paths relative to it. Each watched directory only stores its parent watch descriptor and
+// its own name segment within a shared names arena, so memory scales with the number of directories rather
+// than with the length of their full paths. Relative paths are rebuilt on demand by walking up the parents.
+// Directories are also linked to their children, so subtrees are walked without visiting the rest of the index.
+//
+class watch_descriptor_index
+{
+
+public:
+
+    //
+    // Constructor.
+    //
+    watch_descriptor_index();
+
+    //
+    // Registers the watch descriptor of a source directory.
+    //
+    void
+    add_root(
+        const file_descriptor p_watch_descriptor);
+
+    //
+    // Registers the watch descriptor of a directory nested under an already registered directory.
+    //
+    void
+    add_child(
+        const file_descriptor p_watch_descriptor,
+        const file_descriptor p_parent_watch_descriptor,
+        const std::string_view p_name);
+
+    //
+    // Unregisters a watch descriptor once the kernel has dropped its watch.
+    //
+    void
+    remove(
+        const file_descriptor p_watch_descriptor);
+
+    //
+    // Determines whether a watch descriptor is registered.
+    //
+    bool
+    contains(
+        const file_descriptor p_watch_descriptor) const;
+
+    //
+    // Returns the watch descriptor of the source directory containing a registered watch descriptor.
+    //
+    file_descriptor
+    get_root_watch_descriptor(
+        const file_descriptor p_watch_descriptor) const;
+
+    //
+    // Returns the path of a filesystem object relative to its source directory out of the
+    // watch descriptor of its parent directory and its name. An empty name resolves the
+    // relative path of the watched directory itself.
+    //
+    std::string
+    get_relative_path(
+        const file_descriptor p_watch_descriptor,
+        const std::string_view p_name = "") const;
+
+    //
+    // Appends the path of a filesystem object relative to its source directory to the provided string.
+    // Allocation-free whenever the string already has room for the relative path.
+    //
+    void
+    append_relative_path(
+        const file_descriptor p_watch_descriptor,
+        const std::string_view p_name,
+        std::string* p_relative_path) const;
+
+    //
+    // Collects the watch descriptor of a directory, looked up by its parent watch descriptor and name, along with
+    // the watch descriptors of every directory nested under it, parents ahead of their children. Meant for directories
+    // moved out of their source directory, whose watch descriptors cannot be found through the rename events.
+    //
+    void
+    collect_subtree_watch_descriptors(
+        const file_descriptor p_parent_watch_descriptor,
+        const std::string_view p_name,
+        std::vector<file_descriptor>* p_watch_descriptors) const;
+
+    //
+    // Returns the number of registered watch descriptors.
+    //
+    uint64
+    get_number_watch_descriptors() const;
+
+private:
+
+    //
+    // Index entry for a watched directory.
+    //
+    struct entry
+    {
+
+        //
+        // Watch descriptor of the parent directory. Invalid for source directories.
+        //
+        file_descriptor m_parent_watch_descriptor;
+
+        //
+        // Watch descriptor of the source directory. Invalid for unregistered entries.
+        //
+        file_descriptor m_root_watch_descriptor;
+
+        //
+        // Watch descriptor of the first child directory. Invalid for directories without registered children.
+        //
+        file_descriptor m_first_child_watch_descriptor;
+
+        //
+        // Watch descriptors of the previous and next directories sharing the parent directory.
+        //
+        file_descriptor m_previous_sibling_watch_descriptor;
+        file_descriptor m_next_sibling_watch_descriptor;
+
+        //
+        // Offset of the directory name segment within the names arena.
+        //
+        uint32 m_name_offset;
+
+        //
+        // Length of the directory name segment.
+        //
+        uint32 m_name_length;
+
+    };
+
+    //
+    // Unlinks a registered watch descriptor from the children of its parent directory.
+    //
+    void
+    unlink_from_parent(
+        const file_descriptor p_watch_descriptor);
+
+    //
+    // Releases the name segment of an entry, compacting the names arena once most of it is unused.
+    //
+    void
+    release_name(
+        entry& p_entry);
+
+    //
+    // Appends the path of a watched directory relative to its source directory to the provided string.
+    // The offset marks where the relative path starts within the string.
+    //
+    void
+    append_directory_path(
+        const file_descriptor p_watch_descriptor,
+        const uint64 p_relative_path_offset,
+        std::string* p_relative_path) const;
+
+    //
+    // Index entries indexed by watch descriptor. Watch descriptors are small
+    // integers allocated sequentially by the kernel, so direct indexing is dense.
+    //
+    std::vector<entry> m_entries;
+
+    //
+    // Arena holding the name segments of all watched directories back to back.
+    //
+    std::string m_names;
+
+    //
+    // Number of arena bytes held by name segments of unregistered entries.
+    //
+    uint64 m_number_released_name_bytes;
+
+    //
+    // Number of registered watch descriptors.
+    //
+    uint64 m_number_watch_descriptors;
+
+};
+
+} // namespace modula.
+
+#endif
@@ -0,0 +1,311 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'weighted_fair_scheduler.cc'
+// Author: jcjuarez
+// *************************************
+
+#include "logger.hh"
+#include "weighted_fair_scheduler.hh"
+
+#include <algorithm>
+
+namespace modula
+{
+
+weighted_fair_scheduler_slot::weighted_fair_scheduler_slot(
+    weighted_fair_scheduler* p_weighted_fair_scheduler,
+    const uint32 p_lane_index,
+    const bool p_granted)
+    : m_weighted_fair_scheduler(p_weighted_fair_scheduler),
+      m_lane_index(p_lane_index),
+      m_granted(p_granted)
+{}
+
+weighted_fair_scheduler_slot::weighted_fair_scheduler_slot(
+    weighted_fair_scheduler_slot&& p_weighted_fair_scheduler_slot)
+    : m_weighted_fair_scheduler(p_weighted_fair_scheduler_slot.m_weighted_fair_scheduler),
+      m_lane_index(p_weighted_fair_scheduler_slot.m_lane_index),
+      m_granted(std::exchange(p_weighted_fair_scheduler_slot.m_granted, false))
+{}
+
+weighted_fair_scheduler_slot::~weighted_fair_scheduler_slot()
+{
+    if (m_granted)
+    {
+        m_weighted_fair_scheduler->release_slot(m_lane_index);
+    }
+}
+
+weighted_fair_scheduler_slot::operator bool() const
+{
+    return m_granted;
+}
+
+weighted_fair_scheduler::schedule_awaitable::schedule_awaitable(
+    weighted_fair_scheduler* p_weighted_fair_scheduler,
+    const uint32 p_lane_index)
+    : m_weighted_fair_scheduler(p_weighted_fair_scheduler),
+      m_lane_index(p_lane_index),
+      m_granted(false)
+{}
+
+bool
+weighted_fair_scheduler::schedule_awaitable::await_ready() const noexcept
+{
+    return false;
+}
+
+void
+weighted_fair_scheduler::schedule_awaitable::await_suspend(
+    std::coroutine_handle<> p_coroutine)
+{
+    m_coroutine = p_coroutine;
+
+    //
+    // Once queued, another thread releasing a slot may grant the awaitable, resume the coroutine and destroy the
+    // awaitable before this call returns, so the awaitable is not touched again after being queued.
+    //
+    weighted_fair_scheduler* const scheduler = m_weighted_fair_scheduler;
+
+    {
+        std::scoped_lock<std::mutex> lock(scheduler->m_lock);
+
+        scheduler->m_lanes[m_lane_index]->m_waiting_coroutines.push_back(this);
+    }
+
+    scheduler->dispatch_waiting_coroutines();
+}
+
+weighted_fair_scheduler_slot
+weighted_fair_scheduler::schedule_awaitable::await_resume() const noexcept
+{
+    return weighted_fair_scheduler_slot(
+        m_weighted_fair_scheduler,
+        m_lane_index,
+        m_granted);
+}
+
+weighted_fair_scheduler::weighted_fair_scheduler(
+    std::shared_ptr<thread_pool> p_thread_pool,
+    const uint32 p_capacity)
+    : m_thread_pool(std::move(p_thread_pool)),
+      m_capacity(std::max(p_capacity, 1u)),
+      m_number_running_coroutines(0),
+      m_total_reserved_concurrency(0),
+      m_current_lane_index(0)
+{}
+
+uint32
+weighted_fair_scheduler::register_lane(
+    const std::string& p_name,
+    const uint32 p_weight,
+    const uint32 p_reserved_concurrency)
+{
+    std::scoped_lock<std::mutex> lock(m_lock);
+
+    const uint32 reserved_concurrency = std::min(p_reserved_concurrency, m_capacity - m_total_reserved_concurrency);
+
+    if (reserved_concurrency < p_reserved_concurrency)
+    {
+        logger::log(log_level::warning, std::format("Reserved concurrency exceeds the running slots left unreserved and was reduced. "
+            "LaneName={}, RequestedReservedConcurrency={}, ReservedConcurrency={}, Capacity={}.",
+            p_name,
+            p_reserved_concurrency,
+            reserved_concurrency,
+            m_capacity));
+    }
+
+    std::unique_ptr<lane> registered_lane = std::make_unique<lane>();
+    registered_lane->m_name = p_name;
+    registered_lane->m_weight = std::max(p_weight, 1u);
+    registered_lane->m_reserved_concurrency = reserved_concurrency;
+    registered_lane->m_deficit = 0;
+    registered_lane->m_number_running_coroutines = 0;
+
+    m_lanes.push_back(std::move(registered_lane));
+    m_total_reserved_concurrency += reserved_concurrency;
+
+    logger::log(log_level::info, std::format("Weighted fair scheduler lane registered. LaneName={}, LaneIndex={}, Weight={}, ReservedConcurrency={}, Capacity={}.",
+        p_name,
+        m_lanes.size() - 1,
+        m_lanes.back()->m_weight,
+        reserved_concurrency,
+        m_capacity));
+
+    return static_cast<uint32>(m_lanes.size() - 1);
+}
+
+weighted_fair_scheduler::schedule_awaitable
+weighted_fair_scheduler::schedule(
+    const uint32 p_lane_index)
+{
+    return schedule_awaitable(this, p_lane_index);
+}
+
+uint64
+weighted_fair_scheduler::get_number_queued_coroutines(
+    const uint32 p_lane_index)
+{
+    std::scoped_lock<std::mutex> lock(m_lock);
+
+    return m_lanes[p_lane_index]->m_waiting_coroutines.size();
+}
+
+uint32
+weighted_fair_scheduler::get_number_running_coroutines(
+    const uint32 p_lane_index)
+{
+    std::scoped_lock<std::mutex> lock(m_lock);
+
+    return m_lanes[p_lane_index]->m_number_running_coroutines;
+}
+
+weighted_fair_scheduler::lane*
+weighted_fair_scheduler::pick_next_lane()
+{
+    if (m_number_running_coroutines >= m_capacity)
+    {
+        return nullptr;
+    }
+
+    //
+    // Lanes below their reserved concurrency are served ahead of the deficit round-robin.
+    //
+    uint32 number_unused_reserved_slots = 0;
+
+    for (const std::unique_ptr<lane>& reserving_lane : m_lanes)
+    {
+        if (reserving_lane->m_number_running_coroutines >= reserving_lane->m_reserved_concurrency)
+        {
+            continue;
+        }
+
+        if (!reserving_lane->m_waiting_coroutines.empty())
+        {
+            return reserving_lane.get();
+        }
+
+        number_unused_reserved_slots += reserving_lane->m_reserved_concurrency - reserving_lane->m_number_running_coroutines;
+    }
+
+    //
+    // The running slots still reserved for idle lanes are kept free for them.
+    //
+    if (m_capacity - m_number_running_coroutines <= number_unused_reserved_slots)
+    {
+        return nullptr;
+    }
+
+    //
+    // Each lane with waiting coroutines takes up to its weight in running slots before the round moves on to the next one.
+    //
+    for (uint64 number_visited_lanes = 0; number_visited_lanes < m_lanes.size(); ++number_visited_lanes)
+    {
+        lane& current_lane = *m_lanes[m_current_lane_index];
+
+        if (current_lane.m_waiting_coroutines.empty())
+        {
+            current_lane.m_deficit = 0;
+            m_current_lane_index = (m_current_lane_index + 1) % m_lanes.size();
+
+            continue;
+        }
+
+        if (current_lane.m_deficit == 0)
+        {
+            current_lane.m_deficit = current_lane.m_weight;
+        }
+
+        if (--current_lane.m_deficit == 0)
+        {
+            m_current_lane_index = (m_current_lane_index + 1) % m_lanes.size();
+        }
+
+        return &current_lane;
+    }
+
+    return nullptr;
+}
+
+void
+weighted_fair_scheduler::dispatch_waiting_coroutines()
+{
+    forever
+    {
+        std::vector<schedule_awaitable*> granted_coroutines;
+
+        {
+            std::scoped_lock<std::mutex> lock(m_lock);
+
+            for (lane* next_lane = pick_next_lane(); next_lane != nullptr; next_lane = pick_next_lane())
+            {
+                schedule_awaitable* granted_coroutine = next_lane->m_waiting_coroutines.front();
+                next_lane->m_waiting_coroutines.pop_front();
+
+                ++next_lane->m_number_running_coroutines;
+                ++m_number_running_coroutines;
+
+                granted_coroutine->m_granted = true;
+                granted_coroutines.push_back(granted_coroutine);
+            }
+        }
+
+        if (granted_coroutines.empty())
+        {
+            return;
+        }
+
+        bool slots_released = false;
+
+        for (schedule_awaitable* granted_coroutine : granted_coroutines)
+        {
+            //
+            // Once handed over, the coroutine may be resumed and the awaitable destroyed,
+            // so the awaitable is only touched again when the thread pool refused it.
+            //
+            const std::coroutine_handle<> coroutine = granted_coroutine->m_coroutine;
+            const uint32 lane_index = granted_coroutine->m_lane_index;
+
+            if (m_thread_pool->post([coroutine]()
+                {
+                    coroutine.resume();
+                }))
+            {
+                continue;
+            }
+
+            {
+                std::scoped_lock<std::mutex> lock(m_lock);
+
+                --m_lanes[lane_index]->m_number_running_coroutines;
+                --m_number_running_coroutines;
+            }
+
+            slots_released = true;
+            granted_coroutine->m_granted = false;
+            coroutine.resume();
+        }
+
+        if (!slots_released)
+        {
+            return;
+        }
+    }
+}
+
+void
+weighted_fair_scheduler::release_slot(
+    const uint32 p_lane_index)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_lock);
+
+        --m_lanes[p_lane_index]->m_number_running_coroutines;
+        --m_number_running_coroutines;
+    }
+
+    dispatch_waiting_coroutines();
+}
+
+} // namespace modula.
@@ -0,0 +1,291 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'weighted_fair_scheduler.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef WEIGHTED_FAIR_SCHEDULER_
+#define WEIGHTED_FAIR_SCHEDULER_
+
+#include "utilities.hh"
+#include "thread_pool.hh"
+
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <coroutine>
+
+namespace modula
+{
+
+class weighted_fair_scheduler;
+
+//
+// Scoped ownership of a running slot of a weighted fair scheduler, releasing it on destruction.
+//
+class weighted_fair_scheduler_slot
+{
+
+public:
+
+    //
+    // Constructor. Takes ownership of a running slot of a lane, or holds none when it was not granted.
+    //
+    weighted_fair_scheduler_slot(
+        weighted_fair_scheduler* p_weighted_fair_scheduler,
+        const uint32 p_lane_index,
+        const bool p_granted);
+
+    //
+    // Move constructor. Transfers the running slot ownership.
+    //
+    weighted_fair_scheduler_slot(
+        weighted_fair_scheduler_slot&& p_weighted_fair_scheduler_slot);
+
+    weighted_fair_scheduler_slot(
+        const weighted_fair_scheduler_slot&) = delete;
+
+    weighted_fair_scheduler_slot&
+    operator=(
+        const weighted_fair_scheduler_slot&) = delete;
+
+    //
+    // Destructor. Releases the running slot, if held.
+    //
+    ~weighted_fair_scheduler_slot();
+
+    //
+    // Returns whether the running slot was granted. Slots are not granted when the thread pool refused the coroutine.
+    //
+    explicit
+    operator bool() const;
+
+private:
+
+    //
+    // Scheduler owning the running slot.
+    //
+    weighted_fair_scheduler* m_weighted_fair_scheduler;
+
+    //
+    // Lane the running slot was granted to.
+    //
+    uint32 m_lane_index;
+
+    //
+    // Flag for determining whether the running slot is held.
+    //
+    bool m_granted;
+
+};
+
+//
+// Scheduler class placing one queue per lane in front of a shared thread pool. Every replication engine holds a lane,
+// and coroutines scheduled on a lane are handed over to the thread pool only once a running slot is available, so a
+// lane flooding the scheduler cannot starve the others. Lanes below their reserved concurrency are served first, and
+// the running slots left are shared through deficit round-robin in proportion to the lane weights. Running slots still
+// reserved for idle lanes are kept free for them.
+//
+class weighted_fair_scheduler
+{
+
+public:
+
+    //
+    // Awaitable resuming the awaiting coroutine on the thread pool once its lane is granted a running slot. When the
+    // thread pool refuses the coroutine it resumes on the releasing thread instead, with a slot which was not granted.
+    //
+    class schedule_awaitable
+    {
+
+    public:
+
+        //
+        // Constructor.
+        //
+        schedule_awaitable(
+            weighted_fair_scheduler* p_weighted_fair_scheduler,
+            const uint32 p_lane_index);
+
+        bool
+        await_ready() const noexcept;
+
+        void
+        await_suspend(
+            std::coroutine_handle<> p_coroutine);
+
+        weighted_fair_scheduler_slot
+        await_resume() const noexcept;
+
+    private:
+
+        friend class weighted_fair_scheduler;
+
+        //
+        // Scheduler to be scheduled on.
+        //
+        weighted_fair_scheduler* m_weighted_fair_scheduler;
+
+        //
+        // Lane to be scheduled on.
+        //
+        uint32 m_lane_index;
+
+        //
+        // Suspended coroutine.
+        //
+        std::coroutine_handle<> m_coroutine;
+
+        //
+        // Flag for determining whether the coroutine was granted a running slot on the thread pool.
+        //
+        bool m_granted;
+
+    };
+
+    //
+    // Constructor.
+    //
+    weighted_fair_scheduler(
+        std::shared_ptr<thread_pool> p_thread_pool,
+        const uint32 p_capacity);
+
+    //
+    // Registers a lane and returns its index. Reserved concurrency beyond the running slots
+    // not reserved yet is reduced to them. Lanes must be registered before being scheduled on.
+    //
+    uint32
+    register_lane(
+        const std::string& p_name,
+        const uint32 p_weight,
+        const uint32 p_reserved_concurrency);
+
+    //
+    // Returns an awaitable which moves the awaiting coroutine onto the thread pool once its lane is granted a running
+    // slot, resuming with the scoped ownership of the slot. The slot must be tested once bound to a variable, as GCC 12
+    // miscompiles co_await expressions within if conditions.
+    //
+    schedule_awaitable
+    schedule(
+        const uint32 p_lane_index);
+
+    //
+    // Returns the number of coroutines waiting for a running slot on a lane.
+    //
+    uint64
+    get_number_queued_coroutines(
+        const uint32 p_lane_index);
+
+    //
+    // Returns the number of running slots held by a lane.
+    //
+    uint32
+    get_number_running_coroutines(
+        const uint32 p_lane_index);
+
+private:
+
+    friend class weighted_fair_scheduler_slot;
+
+    //
+    // Queue and accounting of a lane.
+    //
+    struct lane
+    {
+
+        //
+        // Name of the lane, for logging.
+        //
+        std::string m_name;
+
+        //
+        // Running slots granted per deficit round-robin round.
+        //
+        uint32 m_weight;
+
+        //
+        // Running slots the lane is always able to take.
+        //
+        uint32 m_reserved_concurrency;
+
+        //
+        // Running slots left for the lane in the current deficit round-robin round.
+        //
+        uint32 m_deficit;
+
+        //
+        // Running slots held by the lane.
+        //
+        uint32 m_number_running_coroutines;
+
+        //
+        // Coroutines waiting for a running slot.
+        //
+        std::deque<schedule_awaitable*> m_waiting_coroutines;
+
+    };
+
+    //
+    // Picks the lane to be granted the next running slot, or null when no lane may take one.
+    // Must be called with the scheduler lock held.
+    //
+    lane*
+    pick_next_lane();
+
+    //
+    // Grants running slots to waiting coroutines while any is available, handing them over to the thread pool.
+    //
+    void
+    dispatch_waiting_coroutines();
+
+    //
+    // Releases a running slot of a lane and grants it to the next waiting coroutine.
+    //
+    void
+    release_slot(
+        const uint32 p_lane_index);
+
+    //
+    // Thread pool running the scheduled coroutines.
+    //
+    std::shared_ptr<thread_pool> m_thread_pool;
+
+    //
+    // Max number of running slots across all lanes.
+    //
+    const uint32 m_capacity;
+
+    //
+    // Running slots held across all lanes.
+    //
+    uint32 m_number_running_coroutines;
+
+    //
+    // Running slots reserved across all lanes.
+    //
+    uint32 m_total_reserved_concurrency;
+
+    //
+    // Lane currently visited by the deficit round-robin.
+    //
+    uint32 m_current_lane_index;
+
+    //
+    // Registered lanes, indexed by lane index.
+    //
+    std::vector<std::unique_ptr<lane>> m_lanes;
+
+    //
+    // Lock for synchronizing access to the scheduler state.
+    //
+    std::mutex m_lock;
+
+};
+
+} // namespace modula.
+
+#endif
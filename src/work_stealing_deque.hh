@@ -0,0 +1,207 @@
+// *************************************
+// Modula Replication Engine
+// Utilities
+// 'work_stealing_deque.hh'
+// Author: jcjuarez
+// *************************************
+
+#ifndef WORK_STEALING_DEQUE_
+#define WORK_STEALING_DEQUE_
+
+#include "utilities.hh"
+
+#include <atomic>
+#include <memory>
+
+namespace modula
+{
+
+//
+// Bounded lock-free Chase-Lev deque class for distributing elements from an owner thread to any number of thief threads.
+// The owner pushes and pops elements at the bottom in LIFO order while thieves steal them from the top in FIFO order;
+// only the last element is contended. The capacity is fixed and rounded up to a power of two, so pushes fail instead of
+// growing the deque, which spares the reclamation of a replaced buffer still being read by thieves. Elements are pointers
+// whose ownership travels with them.
+//
+template<typename T>
+class work_stealing_deque
+{
+
+public:
+
+    //
+    // Constructor. Preallocates all slots of the deque.
+    //
+    explicit
+    work_stealing_deque(
+        const uint64 p_capacity)
+        : m_capacity(round_up_to_power_of_two(p_capacity)),
+          m_mask(m_capacity - 1),
+          m_slots(std::make_unique<std::atomic<T*>[]>(m_capacity)),
+          m_top(0),
+          m_bottom(0)
+    {}
+
+    //
+    // Pushes an element at the bottom of the deque. Only callable from the owner thread.
+    // Returns false without consuming the element when the deque is full.
+    //
+    bool
+    try_push(
+        T* p_element)
+    {
+        const int64 bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64 top = m_top.load(std::memory_order_acquire);
+
+        if (bottom - top >= static_cast<int64>(m_capacity))
+        {
+            return false;
+        }
+
+        m_slots[bottom & m_mask].store(p_element, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    //
+    // Pops the most recently pushed element from the bottom of the deque. Only callable from the owner thread.
+    // Returns false when the deque is empty or when a thief stole the last element first.
+    //
+    bool
+    try_pop(
+        T** p_element)
+    {
+        const int64 bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+
+        //
+        // Publish the reservation of the bottom element before observing the thieves.
+        //
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int64 top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+            return false;
+        }
+
+        *p_element = m_slots[bottom & m_mask].load(std::memory_order_relaxed);
+
+        if (top == bottom)
+        {
+            //
+            // The last element is raced against the thieves through the top position.
+            //
+            const bool won = m_top.compare_exchange_strong(
+                top,
+                top + 1,
+                std::memory_order_seq_cst,
+                std::memory_order_relaxed);
+
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+            return won;
+        }
+
+        return true;
+    }
+
+    //
+    // Steals the least recently pushed element from the top of the deque. Callable from any thread.
+    // Returns false when the deque is empty or when the element was taken by someone else first.
+    //
+    bool
+    try_steal(
+        T** p_element)
+    {
+        int64 top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64 bottom = m_bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+        {
+            return false;
+        }
+
+        *p_element = m_slots[top & m_mask].load(std::memory_order_relaxed);
+
+        return m_top.compare_exchange_strong(
+            top,
+            top + 1,
+            std::memory_order_seq_cst,
+            std::memory_order_relaxed);
+    }
+
+    //
+    // Returns the number of elements held by the deque. Callable from any thread;
+    // the value is a snapshot which may be stale by the time it is observed.
+    //
+    uint64
+    get_size() const
+    {
+        const int64 top = m_top.load(std::memory_order_acquire);
+        const int64 bottom = m_bottom.load(std::memory_order_acquire);
+
+        return bottom > top ? bottom - top : 0;
+    }
+
+private:
+
+    //
+    // Cache line size used for separating the thieves and owner positions.
+    //
+    static constexpr uint64 c_cache_line_size = 64u;
+
+    //
+    // Rounds a capacity up to the next power of two.
+    //
+    static
+    uint64
+    round_up_to_power_of_two(
+        const uint64 p_capacity)
+    {
+        uint64 capacity = 1;
+
+        while (capacity < p_capacity)
+        {
+            capacity <<= 1;
+        }
+
+        return capacity;
+    }
+
+    //
+    // Max number of elements the deque can hold.
+    //
+    const uint64 m_capacity;
+
+    //
+    // Mask for mapping positions into slot indexes.
+    //
+    const uint64 m_mask;
+
+    //
+    // Preallocated slots of the deque.
+    //
+    std::unique_ptr<std::atomic<T*>[]> m_slots;
+
+    //
+    // Thieves position. Kept on its own cache line to avoid false sharing with the owner position.
+    //
+    alignas(c_cache_line_size) std::atomic<int64> m_top;
+
+    //
+    // Owner position.
+    //
+    alignas(c_cache_line_size) std::atomic<int64> m_bottom;
+
+};
+
+} // namespace modula.
+
+#endif